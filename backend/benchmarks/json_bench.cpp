@@ -0,0 +1,84 @@
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <string>
+#include <string_view>
+
+#include "character.hpp"
+#include "ihandler.hpp"
+#include "json.hpp"
+#include "lobby_controller.hpp"
+
+
+namespace io_blair::benchmarks {
+using std::string;
+using std::string_view;
+namespace jout = json::out;
+
+namespace {
+// One of each message a client sends, from the most to the least frequent.
+constexpr std::array<string_view, 6> kInbound = {
+    R"({"type":"characterMove","coordinate":[1,0]})",
+    R"({"type":"ping"})",
+    R"({"type":"chat","msg":"hello there"})",
+    R"({"type":"characterConfirm","character":"Io"})",
+    R"({"type":"lobbyJoin","code":"ABC123"})",
+    R"(not json)",
+};
+
+// Dispatches nowhere so only decoding is measured.
+class NullHandler : public IHandler {};
+
+void BM_JsonDecode(benchmark::State& state) {
+  const string data(kInbound[state.range(0)]);
+  NullHandler handler;
+
+  for (auto _ : state) {
+    json::decode(data, handler);
+  }
+  state.SetLabel(string(kInbound[state.range(0)].substr(0, 24)));
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * data.size()));
+}
+BENCHMARK(BM_JsonDecode)->DenseRange(0, kInbound.size() - 1);
+
+void BM_JsonEncodeLobbyJoin(benchmark::State& state) {
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(jout::lobby_join("ABC123", 2, Character::Io));
+  }
+}
+BENCHMARK(BM_JsonEncodeLobbyJoin);
+
+void BM_JsonEncodeChat(benchmark::State& state) {
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(jout::chat_msg("hello there"));
+  }
+}
+BENCHMARK(BM_JsonEncodeChat);
+
+void BM_JsonEncodeCharacterMove(benchmark::State& state) {
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(jout::character_move({1, 0}, 0b1'0101'0011));
+  }
+}
+BENCHMARK(BM_JsonEncodeCharacterMove);
+
+void BM_JsonEncodeCharacterOtherMove(benchmark::State& state) {
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(jout::character_other_move(jout::Direction::right, false));
+  }
+}
+BENCHMARK(BM_JsonEncodeCharacterOtherMove);
+
+void BM_JsonEncodeInGameMaze(benchmark::State& state) {
+  using Maze = LobbyController::Maze;
+  Maze maze({0, 0}, {Maze::cols() - 1, Maze::rows() - 1});
+  maze.randomize();
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(jout::ingame_maze(maze, Character::Io, Character::Blair));
+  }
+}
+BENCHMARK(BM_JsonEncodeInGameMaze);
+}  // namespace
+
+}  // namespace io_blair::benchmarks
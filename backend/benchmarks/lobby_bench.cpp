@@ -0,0 +1,227 @@
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "character.hpp"
+#include "lobby_context.hpp"
+#include "lobby_controller.hpp"
+#include "lobby_manager.hpp"
+#include "null_session.hpp"
+
+
+namespace io_blair::benchmarks {
+using std::make_shared;
+using std::shared_ptr;
+using std::string;
+
+namespace {
+// A full create, join and leave cycle. With multiple threads every thread
+// goes through the same manager, like sessions on different io threads do.
+void BM_LobbyManagerCreateJoinLeave(benchmark::State& state) {
+  static LobbyManager manager;
+  auto host  = make_shared<NullSession>();
+  auto guest = make_shared<NullSession>();
+
+  for (auto _ : state) {
+    LobbyContext host_ctx = manager.create(host);
+    const string code(host_ctx.code);
+
+    auto guest_ctx = manager.join(guest, code);
+    benchmark::DoNotOptimize(guest_ctx);
+
+    manager.leave(guest, code);
+    manager.leave(host, code);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LobbyManagerCreateJoinLeave)->ThreadRange(1, 8)->UseRealTime();
+
+// Joining a code that doesn't exist. This only takes the manager's lock.
+void BM_LobbyManagerJoinMissing(benchmark::State& state) {
+  static LobbyManager manager;
+  auto session = make_shared<NullSession>();
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(manager.join(session, "######"));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LobbyManagerJoinMissing)->ThreadRange(1, 8)->UseRealTime();
+
+// Remembers whether the session's last move was reset, so the benchmark can
+// keep sending moves to a neighboring cell.
+class MoveSession : public NullSession {
+ public:
+  void async_send(Message msg) override {
+    if (msg.view().starts_with(R"({"type":"characterMove")")) {
+      reset = msg.view().find(R"("reset":true)") != std::string_view::npos;
+    }
+  }
+
+  bool reset = false;
+};
+
+// Two players in one lobby. Each benchmark thread plays as one of them, so
+// with two threads both players contend for the controller's lock.
+struct SharedLobby {
+  SharedLobby()
+      : controller("BENCH0"),
+        sessions{make_shared<MoveSession>(), make_shared<MoveSession>()},
+        contexts{controller.join(sessions[0]), controller.join(sessions[1])} {
+    contexts[0]->controller->set_character(Character::Io);
+    contexts[1]->controller->set_character(Character::Blair);
+  }
+
+  LobbyController controller;
+  std::array<shared_ptr<MoveSession>, 2> sessions;
+  std::array<std::optional<LobbyContext>, 2> contexts;
+};
+
+SharedLobby& shared_lobby() {
+  static SharedLobby lobby;
+  return lobby;
+}
+
+void BM_LobbyControllerMoveCharacter(benchmark::State& state) {
+  auto& lobby      = shared_lobby();
+  const auto index = static_cast<std::size_t>(state.thread_index()) % 2;
+  auto& controller = *lobby.contexts[index]->controller;
+  auto& session    = *lobby.sessions[index];
+
+  // Step off the start and back. Whether or not the path is open, both the
+  // move and the reset paths get exercised. The start is (1, 4).
+  constexpr coordinate kStart    = {1, 4};
+  constexpr coordinate kNeighbor = {1, 3};
+  bool at_start                  = true;
+  for (auto _ : state) {
+    const coordinate to = at_start ? kNeighbor : kStart;
+    controller.move_character(to);
+    at_start = session.reset || to == kStart;
+  }
+  // Leave the player where the next run expects it.
+  if (!at_start) {
+    controller.move_character(kStart);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LobbyControllerMoveCharacter)->Threads(1)->Threads(2)->UseRealTime();
+
+void BM_LobbyControllerCheckWin(benchmark::State& state) {
+  auto& controller = *shared_lobby().contexts[state.thread_index() % 2]->controller;
+
+  for (auto _ : state) {
+    controller.check_win();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LobbyControllerCheckWin)->Threads(1)->Threads(2)->UseRealTime();
+
+// Counts what it's sent so the fan-out can't be optimized away.
+class CountingSession : public NullSession {
+ public:
+  void async_send(Message msg) override {
+    benchmark::DoNotOptimize(msg.data());
+    ++received;
+  }
+
+  int64_t received = 0;
+};
+
+// A move in a lobby watched by state.range(0) spectators. Each move is encoded
+// once for the spectators and the same payload is sent to all of them.
+void BM_LobbyControllerSpectatorFanOut(benchmark::State& state) {
+  LobbyController controller("BENCH1");
+  auto players = std::array{make_shared<MoveSession>(), make_shared<MoveSession>()};
+  std::array contexts{controller.join(players[0]), controller.join(players[1])};
+  contexts[0]->controller->set_character(Character::Io);
+  contexts[1]->controller->set_character(Character::Blair);
+
+  std::vector<shared_ptr<CountingSession>> spectators;
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    spectators.push_back(make_shared<CountingSession>());
+    controller.spectate(spectators.back());
+  }
+
+  constexpr coordinate kStart    = {1, 4};
+  constexpr coordinate kNeighbor = {1, 3};
+  bool at_start                  = true;
+  for (auto _ : state) {
+    const coordinate to = at_start ? kNeighbor : kStart;
+    contexts[0]->controller->move_character(to);
+    at_start = players[0]->reset || to == kStart;
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.counters["spectators"] = static_cast<double>(state.range(0));
+}
+BENCHMARK(BM_LobbyControllerSpectatorFanOut)->Arg(1)->Arg(100)->Arg(10'000);
+
+// Lobbies with one player each, for the snapshot benchmarks.
+struct SavedLobbies {
+  explicit SavedLobbies(int64_t count) {
+    for (int64_t i = 0; i < count; ++i) {
+      hosts.push_back(make_shared<NullSession>());
+      codes.emplace_back(manager.create(hosts.back()).code);
+    }
+  }
+
+  LobbyManager manager;
+  std::vector<shared_ptr<NullSession>> hosts;
+  std::vector<string> codes;
+};
+
+const string kSnapshotPath =
+    (std::filesystem::temp_directory_path() / "io_blair_snapshot_bench.bin").string();
+
+// Saving state.range(0) lobbies, as on SIGTERM.
+void BM_LobbyManagerSnapshot(benchmark::State& state) {
+  SavedLobbies lobbies(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(lobbies.manager.snapshot(kSnapshotPath));
+  }
+  std::filesystem::remove(kSnapshotPath);
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_LobbyManagerSnapshot)->Arg(1'000)->Arg(100'000)->Unit(benchmark::kMillisecond);
+
+// Restoring state.range(0) lobbies and rebuilding every one of them as their
+// players come back.
+void BM_LobbyManagerRestore(benchmark::State& state) {
+  const string saved = kSnapshotPath + ".saved";
+  std::vector<string> codes;
+  {
+    SavedLobbies lobbies(state.range(0));
+    lobbies.manager.snapshot(saved);
+    codes = std::move(lobbies.codes);
+  }
+  auto guest = make_shared<NullSession>();
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::filesystem::copy_file(saved, kSnapshotPath,
+                               std::filesystem::copy_options::overwrite_existing);
+    auto manager = std::make_unique<LobbyManager>();
+    state.ResumeTiming();
+
+    manager->restore(kSnapshotPath);
+    for (const string& code : codes) {
+      benchmark::DoNotOptimize(manager->join(guest, code));
+    }
+
+    state.PauseTiming();
+    manager.reset();
+    state.ResumeTiming();
+  }
+  std::filesystem::remove(saved);
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_LobbyManagerRestore)->Arg(1'000)->Arg(100'000)->Unit(benchmark::kMillisecond);
+}  // namespace
+
+}  // namespace io_blair::benchmarks
@@ -0,0 +1,20 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdlib>
+
+#include "logging.hpp"
+
+int main(int argc, char** argv) {
+  // Lobby churn logs at info level. Keep those records out of the measurements
+  // and the output unless LOG_LEVEL asks for them.
+  const char* level = std::getenv("LOG_LEVEL");
+  io_blair::logging::Logger::instance().set_level(io_blair::logging::parse_level(
+      level != nullptr ? level : "warn", io_blair::logging::Level::kWarn));
+
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+}
@@ -0,0 +1,40 @@
+#include <benchmark/benchmark.h>
+
+#include "character.hpp"
+#include "lobby_controller.hpp"
+#include "maze.hpp"
+
+
+namespace io_blair::benchmarks {
+using Maze = LobbyController::Maze;
+
+namespace {
+void BM_MazeRandomize(benchmark::State& state) {
+  Maze maze({0, 0}, {Maze::cols() - 1, Maze::rows() - 1});
+  for (auto _ : state) {
+    maze.randomize();
+    benchmark::DoNotOptimize(maze);
+  }
+}
+BENCHMARK(BM_MazeRandomize);
+
+void BM_MazeSerializeFor(benchmark::State& state) {
+  Maze maze({0, 0}, {Maze::cols() - 1, Maze::rows() - 1});
+  maze.randomize();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(maze.serialize_for(Character::Io));
+  }
+}
+BENCHMARK(BM_MazeSerializeFor);
+
+void BM_CellSerializeFor(benchmark::State& state) {
+  Maze maze({0, 0}, {Maze::cols() - 1, Maze::rows() - 1});
+  maze.randomize();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(maze.at(maze.start()).serialize_for(Character::Blair));
+  }
+}
+BENCHMARK(BM_CellSerializeFor);
+}  // namespace
+
+}  // namespace io_blair::benchmarks
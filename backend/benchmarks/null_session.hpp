@@ -0,0 +1,22 @@
+/**
+ * @file null_session.hpp
+ */
+#pragma once
+
+#include "event.hpp"
+#include "isession.hpp"
+#include "message.hpp"
+
+namespace io_blair::benchmarks {
+/**
+ * @brief An ISession that discards everything sent to it, so benchmarks
+ * measure the server's own work rather than a mock's bookkeeping.
+ */
+class NullSession : public ISession {
+ public:
+  void async_send(Message) override {}
+
+  void async_handle(SessionEvent) override {}
+};
+
+}  // namespace io_blair::benchmarks
@@ -0,0 +1,55 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "character.hpp"
+#include "lobby_controller.hpp"
+#include "maze.hpp"
+#include "replay.hpp"
+
+
+namespace io_blair::benchmarks {
+using Maze = LobbyController::Maze;
+using replay::EventKind;
+
+namespace {
+// Records a game of Arg(0) events in which both seats pace between the
+// start and an open neighbor of it.
+std::vector<uint8_t> pacing_game(int64_t events) {
+  Maze maze({0, 0}, {Maze::cols() - 1, Maze::rows() - 1});
+  maze.randomize();
+  const coordinate start    = maze.start();
+  const coordinate neighbor = maze.traversable(start, {1, 0}) ? coordinate{1, 0} : coordinate{0, 1};
+
+  replay::GameRecorder recorder;
+  recorder.begin(maze, Character::Io, Character::Blair);
+  for (int64_t i = 0; i < events; ++i) {
+    const auto seat     = static_cast<uint8_t>(i % 2);
+    const coordinate to = (i / 2) % 2 == 0 ? neighbor : start;
+    recorder.record(EventKind::kMove, seat, to);
+    if (maze.at(to).coin()) {
+      maze.take_coin(to);
+      recorder.record(EventKind::kCoin, seat, to);
+    }
+  }
+  return recorder.finish();
+}
+
+void BM_ReplayDecodeAndVerify(benchmark::State& state) {
+  const std::vector<uint8_t> log = pacing_game(state.range(0));
+  replay::Game game;
+  for (auto _ : state) {
+    replay::Reader reader(log);
+    reader.next(game);
+    if (!replay::verify<Maze::rows(), Maze::cols()>(game).ok) {
+      state.SkipWithError("Recorded game failed to verify");
+      break;
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(game.events.size()));
+}
+BENCHMARK(BM_ReplayDecodeAndVerify)->Arg(100)->Arg(100'000);
+}  // namespace
+
+}  // namespace io_blair::benchmarks
@@ -21,6 +21,18 @@ CPMAddPackage(
     "gtest_forced_shared_crt ON CACHE BOOL \"\" FORCE"
 )
 
+if(ENABLE_BENCHMARKS)
+    CPMAddPackage(
+        NAME benchmark
+        VERSION 1.9.0
+        URL https://github.com/google/benchmark/archive/refs/tags/v1.9.0.tar.gz
+        URL_HASH SHA256=35a77f46cc782b16fac8d3b107fbfbb37dcd645f7c28eee19f3b8e0758b48994
+        OPTIONS
+        "BENCHMARK_ENABLE_TESTING OFF"
+        "BENCHMARK_ENABLE_INSTALL OFF"
+    )
+endif()
+
 CPMAddPackage(
     NAME reflect-cpp
     VERSION 0.16.0
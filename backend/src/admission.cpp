@@ -0,0 +1,88 @@
+#include "admission.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <utility>
+
+
+namespace io_blair {
+using Ticket = Admission::Ticket;
+
+Ticket::Ticket(Ticket&& other) noexcept
+    : verdict_(other.verdict_),
+      dropped_(other.dropped_),
+      held_(std::exchange(other.held_, nullptr)) {}
+
+Ticket& Ticket::operator=(Ticket&& other) noexcept {
+  if (this != &other) {
+    release();
+    verdict_ = other.verdict_;
+    dropped_ = other.dropped_;
+    held_    = std::exchange(other.held_, nullptr);
+  }
+  return *this;
+}
+
+Ticket::~Ticket() {
+  release();
+}
+
+void Ticket::release() {
+  if (held_ != nullptr) {
+    held_->fetch_sub(1, std::memory_order_relaxed);
+    held_ = nullptr;
+  }
+}
+
+Admission::Admission(AdmissionOptions options)
+    : options_(options),
+      burst_(options.accept_burst != 0 ? options.accept_burst : options.accept_rate),
+      tokens_(burst_),
+      refilled_(clock::now()) {}
+
+void Admission::update(AdmissionOptions options) {
+  options_ = options;
+  burst_   = options.accept_burst != 0 ? options.accept_burst : options.accept_rate;
+  tokens_  = std::min(tokens_, burst_);
+}
+
+Ticket Admission::admit(uint64_t sessions, clock::time_point now) {
+  if (options_.max_sessions != 0 && sessions >= options_.max_sessions) {
+    return reject(Verdict::kTooManySessions);
+  }
+  if (options_.max_pending_handshakes != 0
+      && pending_.load(std::memory_order_relaxed) >= options_.max_pending_handshakes) {
+    return reject(Verdict::kTooManyHandshakes);
+  }
+  if (options_.accept_rate != 0) {
+    refill(now);
+    if (tokens_ < 1) {
+      return reject(Verdict::kRateLimited);
+    }
+    tokens_ -= 1;
+  }
+
+  pending_.fetch_add(1, std::memory_order_relaxed);
+  return {Verdict::kAdmit, &pending_};
+}
+
+Ticket Admission::reject(Verdict verdict) {
+  if (rejecting_.load(std::memory_order_relaxed) >= options_.max_pending_rejections) {
+    return {verdict, nullptr, true};
+  }
+  rejecting_.fetch_add(1, std::memory_order_relaxed);
+  return {verdict, &rejecting_};
+}
+
+void Admission::refill(clock::time_point now) {
+  if (now <= refilled_) {
+    return;
+  }
+  const std::chrono::duration<double> elapsed = now - refilled_;
+  tokens_   = std::min(burst_, tokens_ + elapsed.count() * options_.accept_rate);
+  refilled_ = now;
+}
+
+}  // namespace io_blair
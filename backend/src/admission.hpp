@@ -0,0 +1,158 @@
+/**
+ * @file admission.hpp
+ */
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "admission_options.hpp"
+
+namespace io_blair {
+/**
+ * @brief Decides whether an accepted connection is served or turned away,
+ * by the limits in AdmissionOptions.
+ */
+class Admission {
+ public:
+  using clock = std::chrono::steady_clock;
+
+  /**
+   * @brief Why a connection was or wasn't admitted.
+   */
+  enum class Verdict : uint8_t {
+    kAdmit,
+    kTooManySessions,
+    kTooManyHandshakes,
+    kRateLimited,
+  };
+
+  /**
+   * @brief The outcome of admitting a connection. An admitted connection
+   * holds one of the pending handshake places, and a turned away one a
+   * place among the rejections being answered, until the ticket is
+   * destroyed or released.
+   */
+  class Ticket {
+   public:
+    /**
+     * @brief Construct an admitted Ticket that holds no place.
+     */
+    Ticket() = default;
+
+    Ticket(Ticket&& other) noexcept;
+    Ticket& operator=(Ticket&& other) noexcept;
+
+    ~Ticket();
+
+    /**
+     * @brief Gives up the place held, if any.
+     */
+    void release();
+
+    bool admitted() const {
+      return verdict_ == Verdict::kAdmit;
+    }
+
+    Verdict verdict() const {
+      return verdict_;
+    }
+
+    /**
+     * @brief Determines whether a turned away connection should be closed
+     * without an answer, because max_pending_rejections others are still
+     * being answered.
+     *
+     * @return true
+     * @return false
+     */
+    bool dropped() const {
+      return dropped_;
+    }
+
+   private:
+    friend class Admission;
+
+    Ticket(Verdict verdict, std::atomic<uint32_t>* held, bool dropped = false)
+        : verdict_(verdict), dropped_(dropped), held_(held) {}
+
+    Verdict verdict_             = Verdict::kAdmit;
+    bool dropped_                = false;
+    std::atomic<uint32_t>* held_ = nullptr;
+  };
+
+  /**
+   * @brief Construct a new Admission object.
+   *
+   * @param options
+   */
+  explicit Admission(AdmissionOptions options = {});
+
+  /**
+   * @brief Replaces the limits. Connections already admitted keep their places.
+   *
+   * @note Must not be called concurrently with admit().
+   *
+   * @param options
+   */
+  void update(AdmissionOptions options);
+
+  /**
+   * @brief Decides whether to serve a newly accepted connection. Turned away
+   * connections don't spend an accept token.
+   *
+   * @note Must not be called concurrently, i.e. only from the accept loop.
+   * Tickets may be released from any thread.
+   *
+   * @param sessions The number of websocket sessions currently open.
+   * @param now
+   * @return Ticket
+   */
+  Ticket admit(uint64_t sessions, clock::time_point now = clock::now());
+
+  /**
+   * @brief Gets the number of admitted connections still waiting on their
+   * first request.
+   *
+   * @return uint32_t
+   */
+  uint32_t pending() const {
+    return pending_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Gets the number of turned away connections still being answered.
+   *
+   * @return uint32_t
+   */
+  uint32_t rejecting() const {
+    return rejecting_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  // Adds the tokens earned since the last refill, up to the burst size.
+  void refill(clock::time_point now);
+
+  // Turns a connection away for verdict, taking a rejection place if one is free.
+  Ticket reject(Verdict verdict);
+
+  AdmissionOptions options_;
+
+  // The most tokens the bucket holds.
+  double burst_;
+
+  // Accept tokens currently available. Unused without an accept rate.
+  double tokens_;
+
+  // When tokens_ was last refilled.
+  clock::time_point refilled_;
+
+  // The number of tickets holding a pending handshake place.
+  std::atomic<uint32_t> pending_{0};
+
+  // The number of tickets holding a rejection place.
+  std::atomic<uint32_t> rejecting_{0};
+};
+
+}  // namespace io_blair
@@ -0,0 +1,44 @@
+/**
+ * @file admission_options.hpp
+ */
+#pragma once
+
+#include <cstdint>
+
+namespace io_blair {
+/**
+ * @brief Limits on the connections the server takes on, so a reconnect storm
+ * is turned away cheaply instead of slowing down players already connected.
+ */
+struct AdmissionOptions {
+  /**
+   * @brief The most websocket sessions open at once. Zero for no limit.
+   */
+  uint32_t max_sessions = 0;
+
+  /**
+   * @brief How many connections are accepted per second on average. Zero
+   * for no limit.
+   */
+  uint32_t accept_rate = 0;
+
+  /**
+   * @brief How many connections may be accepted at once after a quiet
+   * period. Zero means accept_rate.
+   */
+  uint32_t accept_burst = 0;
+
+  /**
+   * @brief The most accepted connections still waiting on their first
+   * request at once. Zero for no limit.
+   */
+  uint32_t max_pending_handshakes = 0;
+
+  /**
+   * @brief The most turned away connections being answered with 503 at
+   * once. Connections turned away past it are closed without an answer.
+   */
+  uint32_t max_pending_rejections = 64;
+};
+
+}  // namespace io_blair
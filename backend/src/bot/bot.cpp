@@ -0,0 +1,330 @@
+#include "bot.hpp"
+
+#include <charconv>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <utility>
+
+
+namespace io_blair::bot {
+using std::string;
+using clock = std::chrono::steady_clock;
+namespace chrono = std::chrono;
+
+namespace {
+constexpr auto kConnectTimeout = chrono::seconds(30);
+
+// Chat messages carry their send time so the receiving bot can time delivery.
+string chat_stamp() {
+  return std::to_string(
+      chrono::duration_cast<chrono::nanoseconds>(clock::now().time_since_epoch()).count());
+}
+}  // namespace
+
+Bot::Bot(net::io_context& ctx, const Options& options, Stats& stats, Role role)
+    : options_(options),
+      stats_(stats),
+      role_(role),
+      strand_(net::make_strand(ctx)),
+      ws_(strand_),
+      move_timer_(strand_),
+      ping_timer_(strand_),
+      chat_timer_(strand_) {}
+
+void Bot::set_partner(std::weak_ptr<Bot> partner) {
+  partner_ = std::move(partner);
+}
+
+void Bot::start(const tcp::resolver::results_type& endpoints) {
+  net::post(strand_, [self = shared_from_this(), endpoints] {
+    beast::get_lowest_layer(self->ws_).expires_after(kConnectTimeout);
+    beast::get_lowest_layer(self->ws_).async_connect(
+        endpoints, beast::bind_front_handler(&Bot::on_connect, self));
+  });
+}
+
+void Bot::stop() {
+  net::post(strand_, [self = shared_from_this()] {
+    self->stopping_ = true;
+    self->playing_  = false;
+    self->move_timer_.cancel();
+    self->ping_timer_.cancel();
+    self->chat_timer_.cancel();
+
+    if (!self->connected_) {
+      beast::get_lowest_layer(self->ws_).cancel();
+      return;
+    }
+    self->connected_ = false;
+    self->ws_.async_close(websocket::close_code::normal, [self](beast::error_code) {});
+  });
+}
+
+void Bot::on_connect(beast::error_code ec, const tcp::endpoint&) {
+  if (ec) {
+    return fail(ec);
+  }
+
+  beast::get_lowest_layer(ws_).expires_never();
+  // Latencies are measured per message, so don't let small writes wait on Nagle.
+  beast::get_lowest_layer(ws_).socket().set_option(tcp::no_delay(true));
+  ws_.set_option(websocket::stream_base::timeout::suggested(beast::role_type::client));
+  ws_.async_handshake(options_.host + ":" + options_.port,
+                      "/",
+                      beast::bind_front_handler(&Bot::on_handshake, shared_from_this()));
+}
+
+void Bot::on_handshake(beast::error_code ec) {
+  if (ec) {
+    return fail(ec);
+  }
+  if (stopping_) {
+    ws_.async_close(websocket::close_code::normal, [self = shared_from_this()](auto) {});
+    return;
+  }
+
+  connected_ = true;
+  stats_.connected.fetch_add(1, std::memory_order_relaxed);
+  do_read();
+  schedule_ping();
+  schedule_chat();
+
+  if (role_ == Role::kHost) {
+    send(MessageType::kLobbyCreate, protocol::out::lobby_create());
+  } else if (code_) {
+    send(MessageType::kLobbyJoin, protocol::out::lobby_join(*code_));
+  }
+}
+
+void Bot::do_read() {
+  ws_.async_read(buffer_, beast::bind_front_handler(&Bot::on_read, shared_from_this()));
+}
+
+void Bot::on_read(beast::error_code ec, std::size_t) {
+  if (ec) {
+    return fail(ec);
+  }
+
+  if (auto msg = protocol::decode(beast::buffers_to_string(buffer_.data())); msg) {
+    msg->visit([this](const auto& decoded) { handle(decoded); });
+  }
+  buffer_.consume(buffer_.size());
+
+  do_read();
+}
+
+void Bot::fail(beast::error_code ec) {
+  if (!stopping_ && ec != net::error::operation_aborted) {
+    stats_.failed.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  connected_ = false;
+  playing_   = false;
+  move_timer_.cancel();
+  ping_timer_.cancel();
+  chat_timer_.cancel();
+}
+
+void Bot::send(MessageType type, string msg) {
+  if (!connected_) {
+    return;
+  }
+
+  stats_.sent(type);
+  // Chat is relayed to the other bot, which times it from the stamp in the message.
+  if (type != MessageType::kChat) {
+    pending_[static_cast<std::size_t>(type)].push_back(clock::now());
+  }
+
+  outbox_.push_back(std::move(msg));
+  if (!writing_) {
+    do_write();
+  }
+}
+
+void Bot::do_write() {
+  writing_ = true;
+  ws_.async_write(net::buffer(outbox_.front()),
+                  beast::bind_front_handler(&Bot::on_write, shared_from_this()));
+}
+
+void Bot::on_write(beast::error_code ec, std::size_t) {
+  writing_ = false;
+  if (ec) {
+    return fail(ec);
+  }
+
+  outbox_.pop_front();
+  if (!outbox_.empty()) {
+    do_write();
+  }
+}
+
+void Bot::complete(MessageType type) {
+  auto& pending = pending_[static_cast<std::size_t>(type)];
+  if (pending.empty()) {
+    return;
+  }
+  stats_.completed(type, clock::now() - pending.front());
+  pending.pop_front();
+}
+
+void Bot::on_code(string code) {
+  code_ = std::move(code);
+  if (connected_) {
+    send(MessageType::kLobbyJoin, protocol::out::lobby_join(*code_));
+  }
+}
+
+void Bot::handle(const protocol::LobbyJoin& msg) {
+  complete(role_ == Role::kHost ? MessageType::kLobbyCreate : MessageType::kLobbyJoin);
+  if (!msg.success) {
+    stats_.protocol_errors.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  if (role_ == Role::kGuest) {
+    send(MessageType::kCharacterConfirm, protocol::out::character_confirm(Character::Blair));
+    return;
+  }
+
+  if (auto partner = partner_.lock(); partner) {
+    net::post(partner->strand_,
+              beast::bind_front_handler(&Bot::on_code, std::move(partner), msg.code));
+  }
+}
+
+void Bot::handle(const protocol::LobbyOtherJoin&) {
+  if (role_ == Role::kHost) {
+    send(MessageType::kCharacterConfirm, protocol::out::character_confirm(Character::Io));
+  }
+}
+
+void Bot::handle(const protocol::LobbyOtherLeave&) {
+  // The other bot's connection dropped. There is no one to play with anymore.
+  stats_.protocol_errors.fetch_add(1, std::memory_order_relaxed);
+  playing_ = false;
+  move_timer_.cancel();
+}
+
+void Bot::handle(const protocol::TransitionToInGame&) {
+  // characterConfirm has no direct response. The game starting is the closest thing.
+  complete(MessageType::kCharacterConfirm);
+  complete(MessageType::kNewGame);
+}
+
+void Bot::handle(const protocol::InGameMaze& msg) {
+  explorer_.reset(msg);
+  playing_        = true;
+  check_win_sent_ = false;
+  schedule_move();
+}
+
+void Bot::handle(const protocol::CharacterMove& msg) {
+  complete(MessageType::kCharacterMove);
+
+  if (msg.reset) {
+    stats_.protocol_errors.fetch_add(1, std::memory_order_relaxed);
+    explorer_.reset_to_start();
+  } else {
+    explorer_.moved(msg.coordinate, msg.cell);
+  }
+  schedule_move();
+}
+
+void Bot::handle(const protocol::CoinTaken& msg) {
+  explorer_.coin_taken(msg.coordinate);
+}
+
+void Bot::handle(const protocol::TransitionToGameDone&) {
+  // The win is usually triggered by whichever bot arrives last, so this times
+  // how long the bot waited at the end rather than a single request.
+  complete(MessageType::kCheckWin);
+  stats_.games_completed.fetch_add(1, std::memory_order_relaxed);
+
+  playing_ = false;
+  if (role_ != Role::kHost) {
+    move_timer_.cancel();
+    return;
+  }
+
+  move_timer_.expires_after(options_.think);
+  move_timer_.async_wait([self = shared_from_this()](beast::error_code ec) {
+    if (!ec && self->connected_) {
+      self->send(MessageType::kNewGame, protocol::out::new_game());
+    }
+  });
+}
+
+void Bot::handle(const protocol::Pong&) {
+  complete(MessageType::kPing);
+}
+
+void Bot::handle(const protocol::Chat& msg) {
+  int64_t sent_ns = 0;
+  const auto* end = msg.msg.data() + msg.msg.size();
+  if (auto [ptr, ec] = std::from_chars(msg.msg.data(), end, sent_ns); ec != std::errc{}) {
+    return;
+  }
+  const clock::time_point sent{chrono::nanoseconds(sent_ns)};
+  stats_.completed(MessageType::kChat, clock::now() - sent);
+}
+
+void Bot::schedule_move() {
+  if (!playing_) {
+    return;
+  }
+  move_timer_.expires_after(options_.think);
+  move_timer_.async_wait([self = shared_from_this()](beast::error_code ec) {
+    if (!ec) {
+      self->make_move();
+    }
+  });
+}
+
+void Bot::make_move() {
+  if (!playing_) {
+    return;
+  }
+
+  if (auto to = explorer_.next(); to) {
+    auto [x, y] = *to;
+    send(MessageType::kCharacterMove, protocol::out::character_move(x, y));
+    return;
+  }
+
+  // At the end with every coin picked up. Wait for the other bot to arrive.
+  if (!check_win_sent_) {
+    check_win_sent_ = true;
+    send(MessageType::kCheckWin, protocol::out::check_win());
+  }
+}
+
+void Bot::schedule_ping() {
+  if (options_.ping.count() == 0) {
+    return;
+  }
+  ping_timer_.expires_after(options_.ping);
+  ping_timer_.async_wait([self = shared_from_this()](beast::error_code ec) {
+    if (!ec && self->connected_) {
+      self->send(MessageType::kPing, protocol::out::ping());
+      self->schedule_ping();
+    }
+  });
+}
+
+void Bot::schedule_chat() {
+  if (options_.chat.count() == 0) {
+    return;
+  }
+  chat_timer_.expires_after(options_.chat);
+  chat_timer_.async_wait([self = shared_from_this()](beast::error_code ec) {
+    if (!ec && self->connected_) {
+      self->send(MessageType::kChat, protocol::out::chat(chat_stamp()));
+      self->schedule_chat();
+    }
+  });
+}
+
+}  // namespace io_blair::bot
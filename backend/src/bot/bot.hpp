@@ -0,0 +1,133 @@
+/**
+ * @file bot.hpp
+ */
+#pragma once
+
+#include <array>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/strand.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/websocket.hpp>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "explorer.hpp"
+#include "options.hpp"
+#include "protocol.hpp"
+#include "stats.hpp"
+
+namespace io_blair::bot {
+namespace net       = boost::asio;
+namespace beast     = boost::beast;
+namespace websocket = beast::websocket;
+using tcp           = net::ip::tcp;
+
+/**
+ * @brief A single headless client. Bots are created in pairs: the host creates
+ * a lobby and hands its code to the guest, then both confirm a character and
+ * play games until stopped.
+ */
+class Bot : public std::enable_shared_from_this<Bot> {
+ public:
+  /**
+   * @brief Whether the bot creates or joins its lobby.
+   */
+  enum class Role { kHost, kGuest };
+
+  /**
+   * @brief Construct a new Bot.
+   *
+   * @param ctx The io_context the bot's strand runs on.
+   * @param options Shared load generator settings. Must outlive the bot.
+   * @param stats Where the bot reports to. Must outlive the bot.
+   * @param role
+   */
+  Bot(net::io_context& ctx, const Options& options, Stats& stats, Role role);
+
+  /**
+   * @brief Sets the bot sharing this bot's lobby. Must be called before start().
+   *
+   * @param partner
+   */
+  void set_partner(std::weak_ptr<Bot> partner);
+
+  /**
+   * @brief Connects to the server and starts playing.
+   *
+   * @param endpoints The resolved server address.
+   */
+  void start(const tcp::resolver::results_type& endpoints);
+
+  /**
+   * @brief Closes the connection and cancels pending work.
+   */
+  void stop();
+
+ private:
+  static constexpr auto kMessageTypes = static_cast<std::size_t>(MessageType::kCount);
+
+  void on_connect(beast::error_code ec, const tcp::endpoint&);
+  void on_handshake(beast::error_code ec);
+  void do_read();
+  void on_read(beast::error_code ec, std::size_t);
+  void fail(beast::error_code ec);
+
+  // Queues msg and remembers when it was sent so its response can be timed.
+  void send(MessageType type, std::string msg);
+  void do_write();
+  void on_write(beast::error_code ec, std::size_t);
+
+  // Records the round trip of the oldest outstanding message of type.
+  void complete(MessageType type);
+
+  // Called on the guest's strand once the host knows the lobby code.
+  void on_code(std::string code);
+
+  void handle(const protocol::LobbyJoin& msg);
+  void handle(const protocol::LobbyOtherJoin& msg);
+  void handle(const protocol::LobbyOtherLeave& msg);
+  void handle(const protocol::TransitionToInGame& msg);
+  void handle(const protocol::InGameMaze& msg);
+  void handle(const protocol::CharacterMove& msg);
+  void handle(const protocol::CoinTaken& msg);
+  void handle(const protocol::TransitionToGameDone& msg);
+  void handle(const protocol::Pong& msg);
+  void handle(const protocol::Chat& msg);
+
+  void schedule_move();
+  void make_move();
+  void schedule_ping();
+  void schedule_chat();
+
+  const Options& options_;
+  Stats& stats_;
+  const Role role_;
+
+  net::strand<net::io_context::executor_type> strand_;
+  websocket::stream<beast::tcp_stream> ws_;
+  beast::flat_buffer buffer_;
+
+  std::deque<std::string> outbox_;
+  bool writing_   = false;
+  bool connected_ = false;
+  bool stopping_  = false;
+
+  std::weak_ptr<Bot> partner_;
+  std::optional<std::string> code_;
+
+  std::array<std::deque<std::chrono::steady_clock::time_point>, kMessageTypes> pending_;
+
+  net::steady_timer move_timer_;
+  net::steady_timer ping_timer_;
+  net::steady_timer chat_timer_;
+
+  Explorer explorer_;
+  bool playing_        = false;
+  bool check_win_sent_ = false;
+};
+
+}  // namespace io_blair::bot
@@ -0,0 +1,192 @@
+#include "explorer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <deque>
+#include <optional>
+#include <vector>
+
+
+namespace io_blair::bot {
+using std::deque;
+using std::nullopt;
+using std::optional;
+using std::vector;
+using coordinate = Explorer::coordinate;
+
+namespace {
+// Directions in the order of the serialized bits: up, right, down, left.
+constexpr int kDirections = 4;
+
+coordinate translate(coordinate from, int dir) {
+  auto [x, y] = from;
+  switch (dir) {
+    case 0:  return {x, y - 1};
+    case 1:  return {x + 1, y};
+    case 2:  return {x, y + 1};
+    default: return {x - 1, y};
+  }
+}
+
+int opposite(int dir) {
+  return (dir + 2) % kDirections;
+}
+}  // namespace
+
+void Explorer::reset(const protocol::InGameMaze& maze) {
+  rows_     = static_cast<int>(maze.maze.size());
+  cols_     = rows_ == 0 ? 0 : static_cast<int>(maze.maze.front().size());
+  start_    = maze.start;
+  end_      = maze.end;
+  position_ = start_;
+  self_     = maze.maze;
+  other_.assign(rows_, vector<int>(cols_, -1));
+  visited_.assign(rows_, vector<bool>(cols_, false));
+
+  coins_ = 0;
+  for (const auto& row : self_) {
+    coins_ += static_cast<int>(std::count_if(
+        row.begin(), row.end(), [](int cell) { return (cell & kCoinBit) != 0; }));
+  }
+
+  route_.clear();
+  stack_ = {start_};
+  if (in_range(start_)) {
+    other_[start_[1]][start_[0]]   = maze.cell;
+    visited_[start_[1]][start_[0]] = true;
+  }
+}
+
+optional<coordinate> Explorer::next() {
+  // Stop exploring once there is nothing left to pick up and the way to the
+  // end is known.
+  if (coins_ == 0 && !stack_.empty() && route_.empty()) {
+    route_ = route_to_end();
+    if (!route_.empty() || position_ == end_) {
+      stack_.clear();
+    }
+  }
+
+  if (!stack_.empty()) {
+    const coordinate current = stack_.back();
+    for (int dir = 0; dir < kDirections; ++dir) {
+      const coordinate to = translate(current, dir);
+      if (in_range(to) && !visited_[to[1]][to[0]] && open(current, dir)) {
+        return to;
+      }
+    }
+    if (stack_.size() > 1) {
+      return stack_[stack_.size() - 2];
+    }
+    stack_.clear();
+  }
+
+  if (position_ == end_) {
+    return nullopt;
+  }
+  if (route_.empty()) {
+    route_ = route_to_end();
+  }
+  if (route_.empty()) {
+    return nullopt;
+  }
+  return route_.front();
+}
+
+void Explorer::moved(coordinate to, int cell) {
+  if (!in_range(to)) {
+    return;
+  }
+  other_[to[1]][to[0]] = cell;
+  position_            = to;
+
+  if (!stack_.empty()) {
+    if (stack_.size() > 1 && stack_[stack_.size() - 2] == to) {
+      stack_.pop_back();
+    } else {
+      visited_[to[1]][to[0]] = true;
+      stack_.push_back(to);
+    }
+    return;
+  }
+
+  if (!route_.empty() && route_.front() == to) {
+    route_.pop_front();
+  } else {
+    route_.clear();
+  }
+}
+
+void Explorer::reset_to_start() {
+  // The explorer only follows paths it has seen, so this means its view of
+  // the maze is stale. Explore again from scratch.
+  position_ = start_;
+  for (auto& row : visited_) {
+    std::fill(row.begin(), row.end(), false);
+  }
+  if (in_range(start_)) {
+    visited_[start_[1]][start_[0]] = true;
+  }
+  stack_ = {start_};
+  route_.clear();
+}
+
+void Explorer::coin_taken(coordinate at) {
+  if (!in_range(at)) {
+    return;
+  }
+  int& cell = self_[at[1]][at[0]];
+  if ((cell & kCoinBit) != 0) {
+    cell &= ~kCoinBit;
+    --coins_;
+  }
+}
+
+bool Explorer::in_range(coordinate at) const {
+  auto [x, y] = at;
+  return x >= 0 && x < cols_ && y >= 0 && y < rows_;
+}
+
+bool Explorer::open(coordinate from, int dir) const {
+  const auto known = [&](coordinate at, int d) {
+    const int self  = self_[at[1]][at[0]];
+    const int other = other_[at[1]][at[0]];
+    return (self & (1 << d)) != 0 || (self & (1 << (d + kOwnShift))) != 0
+           || (other != -1 && (other & (1 << (d + kOwnShift))) != 0);
+  };
+
+  const coordinate to = translate(from, dir);
+  return in_range(to) && (known(from, dir) || known(to, opposite(dir)));
+}
+
+deque<coordinate> Explorer::route_to_end() const {
+  vector<vector<optional<coordinate>>> parent(rows_, vector<optional<coordinate>>(cols_));
+  deque<coordinate> frontier{position_};
+  parent[position_[1]][position_[0]] = position_;
+
+  while (!frontier.empty()) {
+    const coordinate current = frontier.front();
+    frontier.pop_front();
+    if (current == end_) {
+      break;
+    }
+    for (int dir = 0; dir < kDirections; ++dir) {
+      const coordinate to = translate(current, dir);
+      if (open(current, dir) && !parent[to[1]][to[0]]) {
+        parent[to[1]][to[0]] = current;
+        frontier.push_back(to);
+      }
+    }
+  }
+
+  deque<coordinate> route;
+  if (!in_range(end_) || !parent[end_[1]][end_[0]]) {
+    return route;
+  }
+  for (coordinate at = end_; at != position_; at = *parent[at[1]][at[0]]) {
+    route.push_front(at);
+  }
+  return route;
+}
+
+}  // namespace io_blair::bot
@@ -0,0 +1,106 @@
+/**
+ * @file explorer.hpp
+ */
+#pragma once
+
+#include <array>
+#include <deque>
+#include <optional>
+#include <vector>
+
+#include "protocol.hpp"
+
+namespace io_blair::bot {
+
+/**
+ * @brief Plans a bot's moves through the maze.
+ *
+ * A client only sees the paths both characters share and the ones its own
+ * character can take. The other character's paths out of a cell are revealed
+ * by the characterMove response when the client steps onto that cell, so the
+ * explorer performs a depth first traversal, learning each cell on arrival,
+ * until every coin has been picked up. It then walks the shortest known
+ * route to the end of the maze.
+ */
+class Explorer {
+ public:
+  /**
+   * @brief An [x, y] position, where x is the column and y is the row.
+   */
+  using coordinate = std::array<int, 2>;
+
+  /**
+   * @brief Starts planning for a new maze.
+   *
+   * @param maze The inGameMaze message received.
+   */
+  void reset(const protocol::InGameMaze& maze);
+
+  /**
+   * @brief Gets the cell to move to next.
+   *
+   * @return std::optional<coordinate> nullopt if the explorer is at the end
+   * and has nothing left to do.
+   */
+  std::optional<coordinate> next();
+
+  /**
+   * @brief Records a successful move.
+   *
+   * @param to The cell moved to.
+   * @param cell The other client's view of \p to.
+   */
+  void moved(coordinate to, int cell);
+
+  /**
+   * @brief Records that the server sent the character back to the start.
+   */
+  void reset_to_start();
+
+  /**
+   * @brief Records that a coin was picked up by either client.
+   *
+   * @param at Where the coin was.
+   */
+  void coin_taken(coordinate at);
+
+  /**
+   * @brief Gets the current position.
+   *
+   * @return coordinate
+   */
+  coordinate position() const {
+    return position_;
+  }
+
+ private:
+  // Bit layout of a serialized cell. See Cell::serialize_for.
+  static constexpr int kOwnShift = 4;
+  static constexpr int kCoinBit  = 1 << 8;
+
+  bool in_range(coordinate at) const;
+
+  // Whether a path from `from` in direction `dir` is known to exist.
+  bool open(coordinate from, int dir) const;
+
+  // The shortest route from the current position to `end_` using known paths.
+  std::deque<coordinate> route_to_end() const;
+
+  int rows_ = 0;
+  int cols_ = 0;
+  coordinate start_{};
+  coordinate end_{};
+  coordinate position_{};
+  int coins_ = 0;
+
+  std::vector<std::vector<int>> self_;
+  // The other client's view of each cell. -1 when unknown.
+  std::vector<std::vector<int>> other_;
+  std::vector<std::vector<bool>> visited_;
+
+  // The depth first path from the start. Empty once exploring is over.
+  std::vector<coordinate> stack_;
+  std::deque<coordinate> route_;
+};
+
+}  // namespace io_blair::bot
@@ -0,0 +1,228 @@
+#include <algorithm>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/signal_set.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/strand.hpp>
+#include <chrono>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "bot.hpp"
+#include "options.hpp"
+#include "stats.hpp"
+
+namespace {
+namespace net = boost::asio;
+using io_blair::bot::Bot;
+using io_blair::bot::Options;
+using io_blair::bot::Stats;
+using tcp         = net::ip::tcp;
+using clock       = std::chrono::steady_clock;
+namespace chrono = std::chrono;
+
+// How often the ramp-up opens another batch of connections.
+constexpr auto kRampInterval = chrono::milliseconds(10);
+// How long bots get to close their connections before the run is abandoned.
+constexpr auto kShutdownGrace = chrono::seconds(5);
+// How often to check whether every connection has closed.
+constexpr auto kClosePollInterval = chrono::milliseconds(50);
+
+/**
+ * @brief Opens the bots' connections at the configured rate and stops them
+ * once the run is over. Its handlers all run on one strand.
+ */
+class Driver {
+ public:
+  Driver(net::io_context& ctx, const Options& options, Stats& stats,
+         tcp::resolver::results_type endpoints)
+      : ctx_(ctx),
+        options_(options),
+        stats_(stats),
+        endpoints_(std::move(endpoints)),
+        strand_(net::make_strand(ctx)),
+        ramp_timer_(strand_),
+        report_timer_(strand_),
+        deadline_timer_(strand_),
+        signals_(strand_, SIGINT, SIGTERM) {
+    bots_.reserve(options.connections);
+    for (std::size_t i = 0; i < options.connections; i += 2) {
+      auto host  = std::make_shared<Bot>(ctx, options, stats, Bot::Role::kHost);
+      auto guest = std::make_shared<Bot>(ctx, options, stats, Bot::Role::kGuest);
+      host->set_partner(guest);
+      guest->set_partner(host);
+      bots_.push_back(std::move(host));
+      bots_.push_back(std::move(guest));
+    }
+  }
+
+  void run() {
+    net::post(strand_, [this] { start(); });
+  }
+
+  /**
+   * @brief Gets the time between the start of the run and the bots being stopped.
+   * Call once the io_context has stopped.
+   */
+  clock::duration measured() const {
+    return (finished_ ? end_ : clock::now()) - start_;
+  }
+
+ private:
+  void start() {
+    start_ = clock::now();
+
+    signals_.async_wait([this](auto ec, int) {
+      if (!ec) {
+        finish();
+      }
+    });
+    deadline_timer_.expires_after(options_.duration);
+    deadline_timer_.async_wait([this](auto ec) {
+      if (!ec) {
+        finish();
+      }
+    });
+
+    ramp();
+    report();
+  }
+
+  clock::duration elapsed() const {
+    return clock::now() - start_;
+  }
+
+  void ramp() {
+    // A tick already queued when finish() cancelled the timer mustn't start
+    // bots that will never be stopped.
+    if (finished_) {
+      return;
+    }
+    // Ramp by elapsed time rather than by tick so slow ticks don't lower the rate.
+    const auto secs   = chrono::duration<double>(elapsed()).count();
+    const auto target = std::min(bots_.size(), static_cast<std::size_t>(secs * options_.ramp) + 1);
+    for (; launched_ < target; ++launched_) {
+      bots_[launched_]->start(endpoints_);
+    }
+
+    if (launched_ < bots_.size()) {
+      ramp_timer_.expires_after(kRampInterval);
+      ramp_timer_.async_wait([this](auto ec) {
+        if (!ec) {
+          ramp();
+        }
+      });
+    }
+  }
+
+  void report() {
+    if (options_.report.count() == 0) {
+      return;
+    }
+    report_timer_.expires_after(options_.report);
+    report_timer_.async_wait([this](auto ec) {
+      if (!ec) {
+        stats_.progress(std::cerr, elapsed());
+        report();
+      }
+    });
+  }
+
+  void finish() {
+    if (std::exchange(finished_, true)) {
+      return;
+    }
+    end_ = clock::now();
+
+    ramp_timer_.cancel();
+    report_timer_.cancel();
+    signals_.cancel();
+    for (std::size_t i = 0; i < launched_; ++i) {
+      bots_[i]->stop();
+    }
+
+    wait_for_close(end_ + kShutdownGrace);
+  }
+
+  // Returns once every bot's pending operations have completed, so the
+  // io_context runs out of work. Connections that never finish closing
+  // shouldn't hold up the report, so the io_context is stopped at `deadline`.
+  void wait_for_close(clock::time_point deadline) {
+    const bool closed = std::all_of(
+        bots_.begin(), bots_.end(), [](const auto& bot) { return bot.use_count() == 1; });
+    if (closed) {
+      return;
+    }
+    if (clock::now() >= deadline) {
+      ctx_.stop();
+      return;
+    }
+
+    deadline_timer_.expires_after(kClosePollInterval);
+    deadline_timer_.async_wait([this, deadline](auto ec) {
+      if (!ec) {
+        wait_for_close(deadline);
+      }
+    });
+  }
+
+  net::io_context& ctx_;
+  const Options& options_;
+  Stats& stats_;
+  tcp::resolver::results_type endpoints_;
+  net::strand<net::io_context::executor_type> strand_;
+
+  std::vector<std::shared_ptr<Bot>> bots_;
+  std::size_t launched_ = 0;
+
+  net::steady_timer ramp_timer_;
+  net::steady_timer report_timer_;
+  net::steady_timer deadline_timer_;
+  net::signal_set signals_;
+
+  clock::time_point start_;
+  clock::time_point end_;
+  bool finished_ = false;
+};
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  const auto options = io_blair::bot::parse_options(argc, argv);
+  if (!options) {
+    return 1;
+  }
+
+  net::io_context ctx(static_cast<int>(options->threads));
+
+  tcp::resolver::results_type endpoints;
+  try {
+    endpoints = tcp::resolver(ctx).resolve(options->host, options->port);
+  } catch (const boost::system::system_error& e) {
+    std::cerr << "Failed to resolve " << options->host << ":" << options->port << ": " << e.what()
+              << '\n';
+    return 1;
+  }
+
+  Stats stats;
+  Driver driver(ctx, *options, stats, std::move(endpoints));
+  driver.run();
+
+  std::vector<std::thread> threads;
+  threads.reserve(options->threads - 1);
+  for (uint32_t i = 1; i < options->threads; ++i) {
+    threads.emplace_back([&ctx] { ctx.run(); });
+  }
+  ctx.run();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  stats.report(std::cout, driver.measured());
+}
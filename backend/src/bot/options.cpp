@@ -0,0 +1,110 @@
+#include "options.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+
+
+namespace io_blair::bot {
+using std::optional;
+using std::string_view;
+namespace chrono = std::chrono;
+
+namespace {
+constexpr string_view kUsage = R"(usage: io_blair_server_bot [flags]
+
+  --host HOST         server host (default 127.0.0.1)
+  --port PORT         server port (default 8080)
+  --connections N     websocket connections, paired into lobbies (default 100)
+  --ramp N            connections opened per second (default 100)
+  --duration SECONDS  how long to generate load for (default 60)
+  --threads N         io threads (default hardware concurrency)
+  --think-ms MS       delay between moves and games (default 50)
+  --ping-ms MS        interval between pings per bot, 0 disables (default 5000)
+  --chat-ms MS        interval between chat messages per bot, 0 disables (default 0)
+  --report-s SECONDS  interval between progress lines, 0 disables (default 5)
+)";
+
+template <typename T>
+bool parse_number(string_view str, T& out) {
+  const auto* end = str.data() + str.size();
+  auto [ptr, ec]  = std::from_chars(str.data(), end, out);
+  return ec == std::errc{} && ptr == end;
+}
+
+template <typename Duration>
+bool parse_duration(string_view str, Duration& out) {
+  int64_t count = 0;
+  if (!parse_number(str, count) || count < 0) {
+    return false;
+  }
+  out = Duration(count);
+  return true;
+}
+}  // namespace
+
+optional<Options> parse_options(int argc, char* argv[]) {
+  Options options;
+  options.threads = std::max(1U, std::thread::hardware_concurrency());
+
+  for (int i = 1; i < argc; ++i) {
+    string_view flag = argv[i];
+    string_view value;
+
+    if (flag == "--help" || flag == "-h") {
+      std::cerr << kUsage;
+      return std::nullopt;
+    }
+    if (auto eq = flag.find('='); eq != string_view::npos) {
+      value = flag.substr(eq + 1);
+      flag  = flag.substr(0, eq);
+    } else if (i + 1 < argc) {
+      value = argv[++i];
+    } else {
+      std::cerr << "Missing value for " << flag << "\n\n" << kUsage;
+      return std::nullopt;
+    }
+
+    bool ok = true;
+    if (flag == "--host") {
+      options.host = value;
+    } else if (flag == "--port") {
+      options.port = value;
+    } else if (flag == "--connections") {
+      ok = parse_number(value, options.connections) && options.connections > 0;
+    } else if (flag == "--ramp") {
+      ok = parse_number(value, options.ramp) && options.ramp > 0;
+    } else if (flag == "--duration") {
+      ok = parse_duration(value, options.duration);
+    } else if (flag == "--threads") {
+      ok = parse_number(value, options.threads) && options.threads > 0;
+    } else if (flag == "--think-ms") {
+      ok = parse_duration(value, options.think);
+    } else if (flag == "--ping-ms") {
+      ok = parse_duration(value, options.ping);
+    } else if (flag == "--chat-ms") {
+      ok = parse_duration(value, options.chat);
+    } else if (flag == "--report-s") {
+      ok = parse_duration(value, options.report);
+    } else {
+      std::cerr << "Unknown flag " << flag << "\n\n" << kUsage;
+      return std::nullopt;
+    }
+
+    if (!ok) {
+      std::cerr << "Invalid value for " << flag << ": " << value << "\n\n" << kUsage;
+      return std::nullopt;
+    }
+  }
+
+  options.connections += options.connections % 2;
+  return options;
+}
+
+}  // namespace io_blair::bot
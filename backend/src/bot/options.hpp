@@ -0,0 +1,70 @@
+/**
+ * @file options.hpp
+ */
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace io_blair::bot {
+
+/**
+ * @brief Load generator settings.
+ */
+struct Options {
+  /**
+   * @brief Server host.
+   */
+  std::string host = "127.0.0.1";
+  /**
+   * @brief Server port.
+   */
+  std::string port = "8080";
+  /**
+   * @brief Number of websocket connections. Rounded up to an even number
+   * since every pair of connections shares a lobby.
+   */
+  uint32_t connections = 100;
+  /**
+   * @brief Connections opened per second while ramping up.
+   */
+  uint32_t ramp = 100;
+  /**
+   * @brief How long to generate load for after the first connection is opened.
+   */
+  std::chrono::seconds duration{60};
+  /**
+   * @brief Number of threads running the io_context.
+   */
+  uint32_t threads = 1;
+  /**
+   * @brief Delay between a bot's moves and before starting a new game.
+   */
+  std::chrono::milliseconds think{50};
+  /**
+   * @brief Interval between pings from each bot. 0 disables pings.
+   */
+  std::chrono::milliseconds ping{5000};
+  /**
+   * @brief Interval between chat messages from each bot. 0 disables chat.
+   */
+  std::chrono::milliseconds chat{0};
+  /**
+   * @brief Interval between progress lines. 0 disables progress.
+   */
+  std::chrono::seconds report{5};
+};
+
+/**
+ * @brief Parses command line flags of the form --name value or --name=value.
+ * Prints usage to stderr on failure.
+ *
+ * @param argc
+ * @param argv
+ * @return std::optional<Options> nullopt if the flags were invalid or --help was passed.
+ */
+std::optional<Options> parse_options(int argc, char* argv[]);
+
+}  // namespace io_blair::bot
@@ -0,0 +1,164 @@
+/**
+ * @file protocol.hpp
+ */
+#pragma once
+
+#include <array>
+#include <optional>
+#include <rfl/json.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "character.hpp"
+#include "rfl/Literal.hpp"
+
+/**
+ * @brief The subset of the client-server protocol the load generator speaks.
+ * Server messages are mirrored here as owning structs so they can be decoded.
+ */
+namespace io_blair::bot::protocol {
+
+/**
+ * @brief Server response to lobbyCreate and lobbyJoin.
+ */
+struct LobbyJoin {
+  using Tag = rfl::Literal<"lobbyJoin">;
+  bool success;
+  std::string code;
+  int player_count;
+};
+
+/**
+ * @brief Another client has joined the lobby.
+ */
+struct LobbyOtherJoin {
+  using Tag = rfl::Literal<"lobbyOtherJoin">;
+};
+
+/**
+ * @brief The other client has left the lobby.
+ */
+struct LobbyOtherLeave {
+  using Tag = rfl::Literal<"lobbyOtherLeave">;
+};
+
+/**
+ * @brief The lobby moved to the in-game state.
+ */
+struct TransitionToInGame {
+  using Tag = rfl::Literal<"transitionToInGame">;
+};
+
+/**
+ * @brief The maze serialized for this client. See Cell::serialize_for.
+ */
+struct InGameMaze {
+  using Tag = rfl::Literal<"inGameMaze">;
+  std::vector<std::vector<int>> maze;
+  std::array<int, 2> start;
+  std::array<int, 2> end;
+  int cell;
+};
+
+/**
+ * @brief The result of this client's characterMove.
+ */
+struct CharacterMove {
+  using Tag = rfl::Literal<"characterMove">;
+  std::array<int, 2> coordinate;
+  int cell;
+  bool reset;
+};
+
+/**
+ * @brief A coin was picked up by either client.
+ */
+struct CoinTaken {
+  using Tag = rfl::Literal<"coinTaken">;
+  std::array<int, 2> coordinate;
+};
+
+/**
+ * @brief The game was won.
+ */
+struct TransitionToGameDone {
+  using Tag = rfl::Literal<"transitionToGameDone">;
+};
+
+/**
+ * @brief Response to ping.
+ */
+struct Pong {
+  using Tag = rfl::Literal<"pong">;
+};
+
+/**
+ * @brief A chat message from the other client.
+ */
+struct Chat {
+  using Tag = rfl::Literal<"chat">;
+  std::string msg;
+};
+
+/**
+ * @brief Every server message the load generator reacts to.
+ */
+using ServerMessage
+    = rfl::TaggedUnion<"type", LobbyJoin, LobbyOtherJoin, LobbyOtherLeave, TransitionToInGame,
+                       InGameMaze, CharacterMove, CoinTaken, TransitionToGameDone, Pong, Chat>;
+
+/**
+ * @brief Decodes a server message.
+ *
+ * @param data The JSON received.
+ * @return std::optional<ServerMessage> nullopt if the message isn't one the load
+ * generator reacts to.
+ */
+inline std::optional<ServerMessage> decode(std::string_view data) {
+  if (auto res = rfl::json::read<ServerMessage, rfl::SnakeCaseToCamelCase>(data); res) {
+    return *res;
+  }
+  return std::nullopt;
+}
+
+/**
+ * @brief Encoders for the client messages the load generator sends.
+ */
+namespace out {
+inline std::string lobby_create() {
+  return R"({"type":"lobbyCreate"})";
+}
+
+inline std::string lobby_join(std::string_view code) {
+  return std::string(R"({"type":"lobbyJoin","code":")").append(code).append(R"("})");
+}
+
+inline std::string character_confirm(Character character) {
+  return character == Character::Io ? R"({"type":"characterConfirm","character":"Io"})"
+                                    : R"({"type":"characterConfirm","character":"Blair"})";
+}
+
+inline std::string character_move(int x, int y) {
+  return R"({"type":"characterMove","coordinate":[)" + std::to_string(x) + ","
+         + std::to_string(y) + "]}";
+}
+
+inline std::string check_win() {
+  return R"({"type":"checkWin"})";
+}
+
+inline std::string new_game() {
+  return R"({"type":"newGame"})";
+}
+
+inline std::string ping() {
+  return R"({"type":"ping"})";
+}
+
+inline std::string chat(std::string_view msg) {
+  return std::string(R"({"type":"chat","msg":")").append(msg).append(R"("})");
+}
+}  // namespace out
+
+}  // namespace io_blair::bot::protocol
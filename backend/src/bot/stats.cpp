@@ -0,0 +1,176 @@
+#include "stats.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <ostream>
+#include <string_view>
+
+
+namespace io_blair::bot {
+using std::memory_order_relaxed;
+using std::string_view;
+namespace chrono = std::chrono;
+
+namespace {
+double seconds(chrono::steady_clock::duration elapsed) {
+  return std::max(chrono::duration<double>(elapsed).count(), 1e-9);
+}
+
+double millis(chrono::microseconds us) {
+  return static_cast<double>(us.count()) / 1000.0;
+}
+}  // namespace
+
+string_view name(MessageType type) {
+  switch (type) {
+    case MessageType::kLobbyCreate:      return "lobbyCreate";
+    case MessageType::kLobbyJoin:        return "lobbyJoin";
+    case MessageType::kCharacterConfirm: return "characterConfirm";
+    case MessageType::kCharacterMove:    return "characterMove";
+    case MessageType::kCheckWin:         return "checkWin";
+    case MessageType::kNewGame:          return "newGame";
+    case MessageType::kPing:             return "ping";
+    case MessageType::kChat:             return "chat";
+    case MessageType::kCount:            break;
+  }
+  return "unknown";
+}
+
+std::size_t Histogram::index_of(uint64_t us) noexcept {
+  if (us < kSubBuckets) {
+    return us;
+  }
+  // Bit width is at least 5 here. The top 5 bits select the sub-bucket.
+  const auto width  = static_cast<std::size_t>(std::bit_width(us));
+  const auto octave = std::min(width - 5, kOctaves - 1);
+  const auto shift  = octave;
+  const auto sub    = std::min<uint64_t>(us >> shift, 2 * kSubBuckets - 1) - kSubBuckets;
+  return kSubBuckets + octave * kSubBuckets + sub;
+}
+
+uint64_t Histogram::lower_bound_of(std::size_t index) noexcept {
+  if (index < kSubBuckets) {
+    return index;
+  }
+  const std::size_t octave = (index - kSubBuckets) / kSubBuckets;
+  const std::size_t sub    = (index - kSubBuckets) % kSubBuckets;
+  return (kSubBuckets + sub) << octave;
+}
+
+void Histogram::record(chrono::nanoseconds latency) noexcept {
+  const auto us = static_cast<uint64_t>(
+      std::max<int64_t>(chrono::duration_cast<chrono::microseconds>(latency).count(), 0));
+
+  buckets_[index_of(us)].fetch_add(1, memory_order_relaxed);
+  count_.fetch_add(1, memory_order_relaxed);
+
+  uint64_t max = max_.load(memory_order_relaxed);
+  while (us > max && !max_.compare_exchange_weak(max, us, memory_order_relaxed)) {
+  }
+}
+
+uint64_t Histogram::count() const noexcept {
+  return count_.load(memory_order_relaxed);
+}
+
+chrono::microseconds Histogram::max() const noexcept {
+  return chrono::microseconds(max_.load(memory_order_relaxed));
+}
+
+chrono::microseconds Histogram::percentile(double quantile) const noexcept {
+  const uint64_t total = count();
+  if (total == 0) {
+    return chrono::microseconds(0);
+  }
+
+  const auto rank = static_cast<uint64_t>(std::ceil(std::clamp(quantile, 0.0, 1.0) * total));
+  uint64_t seen   = 0;
+  for (std::size_t i = 0; i < kBuckets; ++i) {
+    seen += buckets_[i].load(memory_order_relaxed);
+    if (seen >= std::max<uint64_t>(rank, 1)) {
+      return std::min(chrono::microseconds(lower_bound_of(i)), max());
+    }
+  }
+  return max();
+}
+
+void Stats::sent(MessageType type) noexcept {
+  types_[static_cast<std::size_t>(type)].sent.fetch_add(1, memory_order_relaxed);
+}
+
+void Stats::completed(MessageType type, chrono::nanoseconds latency) noexcept {
+  types_[static_cast<std::size_t>(type)].latency.record(latency);
+}
+
+void Stats::progress(std::ostream& out, chrono::steady_clock::duration elapsed) const {
+  uint64_t sent      = 0;
+  uint64_t completed = 0;
+  for (const auto& type : types_) {
+    sent += type.sent.load(memory_order_relaxed);
+    completed += type.latency.count();
+  }
+
+  char line[160];
+  std::snprintf(line,
+                sizeof(line),
+                "[%7.1fs] connected=%llu failed=%llu games=%llu sent=%llu (%.0f/s) completed=%llu",
+                seconds(elapsed),
+                static_cast<unsigned long long>(connected.load(memory_order_relaxed)),
+                static_cast<unsigned long long>(failed.load(memory_order_relaxed)),
+                static_cast<unsigned long long>(games_completed.load(memory_order_relaxed)),
+                static_cast<unsigned long long>(sent),
+                static_cast<double>(sent) / seconds(elapsed),
+                static_cast<unsigned long long>(completed));
+  out << line << '\n';
+}
+
+void Stats::report(std::ostream& out, chrono::steady_clock::duration elapsed) const {
+  const double secs = seconds(elapsed);
+
+  char line[192];
+  std::snprintf(line,
+                sizeof(line),
+                "%-18s %10s %10s %10s %10s %10s %10s %10s %10s\n",
+                "type",
+                "sent",
+                "completed",
+                "rate/s",
+                "p50 ms",
+                "p90 ms",
+                "p99 ms",
+                "p99.9 ms",
+                "max ms");
+  out << line;
+
+  for (std::size_t i = 0; i < types_.size(); ++i) {
+    const PerType& type = types_[i];
+    const uint64_t sent = type.sent.load(memory_order_relaxed);
+    if (sent == 0) {
+      continue;
+    }
+    const Histogram& latency = type.latency;
+    std::snprintf(line,
+                  sizeof(line),
+                  "%-18s %10llu %10llu %10.1f %10.3f %10.3f %10.3f %10.3f %10.3f\n",
+                  name(static_cast<MessageType>(i)).data(),
+                  static_cast<unsigned long long>(sent),
+                  static_cast<unsigned long long>(latency.count()),
+                  static_cast<double>(latency.count()) / secs,
+                  millis(latency.percentile(0.50)),
+                  millis(latency.percentile(0.90)),
+                  millis(latency.percentile(0.99)),
+                  millis(latency.percentile(0.999)),
+                  millis(latency.max()));
+    out << line;
+  }
+
+  out << "connections: " << connected.load(memory_order_relaxed)
+      << " connected, " << failed.load(memory_order_relaxed) << " failed\n"
+      << "games completed: " << games_completed.load(memory_order_relaxed) << '\n'
+      << "protocol errors: " << protocol_errors.load(memory_order_relaxed) << '\n';
+}
+
+}  // namespace io_blair::bot
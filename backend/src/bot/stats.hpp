@@ -0,0 +1,150 @@
+/**
+ * @file stats.hpp
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+
+namespace io_blair::bot {
+
+/**
+ * @brief The client messages whose round trips are measured.
+ */
+enum class MessageType : uint8_t {
+  kLobbyCreate,
+  kLobbyJoin,
+  kCharacterConfirm,
+  kCharacterMove,
+  kCheckWin,
+  kNewGame,
+  kPing,
+  kChat,
+  kCount,
+};
+
+/**
+ * @brief Gets the protocol name of \p type.
+ *
+ * @param type
+ * @return std::string_view
+ */
+std::string_view name(MessageType type);
+
+/**
+ * @brief A lock free log-linear latency histogram with microsecond resolution.
+ * Buckets are 1us wide below 16us and then split every power of two into
+ * 16 sub-buckets, bounding the relative error to about 6%.
+ */
+class Histogram {
+ public:
+  /**
+   * @brief Records a sample. Safe to call from any thread.
+   *
+   * @param latency
+   */
+  void record(std::chrono::nanoseconds latency) noexcept;
+
+  /**
+   * @brief Gets the number of samples recorded.
+   *
+   * @return uint64_t
+   */
+  uint64_t count() const noexcept;
+
+  /**
+   * @brief Gets the largest sample recorded.
+   *
+   * @return std::chrono::microseconds
+   */
+  std::chrono::microseconds max() const noexcept;
+
+  /**
+   * @brief Gets the value below which \p quantile of the samples fall.
+   *
+   * @param quantile In [0, 1].
+   * @return std::chrono::microseconds 0 if there are no samples.
+   */
+  std::chrono::microseconds percentile(double quantile) const noexcept;
+
+ private:
+  static constexpr std::size_t kSubBuckets = 16;
+  static constexpr std::size_t kOctaves    = 28;
+  static constexpr std::size_t kBuckets    = kSubBuckets + kOctaves * kSubBuckets;
+
+  static std::size_t index_of(uint64_t us) noexcept;
+  static uint64_t lower_bound_of(std::size_t index) noexcept;
+
+  std::array<std::atomic<uint64_t>, kBuckets> buckets_{};
+  std::atomic<uint64_t> count_{0};
+  std::atomic<uint64_t> max_{0};
+};
+
+/**
+ * @brief Counters and latencies shared by every bot.
+ */
+class Stats {
+ public:
+  /**
+   * @brief Counts a message sent by a bot.
+   *
+   * @param type
+   */
+  void sent(MessageType type) noexcept;
+
+  /**
+   * @brief Records the round trip of a message sent by a bot.
+   *
+   * @param type
+   * @param latency
+   */
+  void completed(MessageType type, std::chrono::nanoseconds latency) noexcept;
+
+  /**
+   * @brief Connections that completed the websocket handshake.
+   */
+  std::atomic<uint64_t> connected{0};
+  /**
+   * @brief Connections that failed or were closed by the server.
+   */
+  std::atomic<uint64_t> failed{0};
+  /**
+   * @brief Games played to transitionToGameDone, counted once per bot.
+   */
+  std::atomic<uint64_t> games_completed{0};
+  /**
+   * @brief Unexpected server responses, such as a move being reset.
+   */
+  std::atomic<uint64_t> protocol_errors{0};
+
+  /**
+   * @brief Writes a one line progress summary.
+   *
+   * @param out
+   * @param elapsed Time since the run started.
+   */
+  void progress(std::ostream& out, std::chrono::steady_clock::duration elapsed) const;
+
+  /**
+   * @brief Writes per message type throughput and latency percentiles.
+   *
+   * @param out
+   * @param elapsed Time since the run started.
+   */
+  void report(std::ostream& out, std::chrono::steady_clock::duration elapsed) const;
+
+ private:
+  struct PerType {
+    std::atomic<uint64_t> sent{0};
+    Histogram latency;
+  };
+
+  std::array<PerType, static_cast<std::size_t>(MessageType::kCount)> types_;
+};
+
+}  // namespace io_blair::bot
@@ -0,0 +1,359 @@
+#include "config.hpp"
+
+#include <boost/asio/ip/address.hpp>
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <concepts>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "logging.hpp"
+
+
+namespace io_blair {
+using std::nullopt;
+using std::optional;
+using std::string;
+using std::string_view;
+
+namespace {
+// A setting's key and the environment variable it can also be set with.
+struct Setting {
+  string_view key;
+  const char* env;
+};
+
+constexpr std::array kSettings = {
+    Setting{"address", "SERVER_ADDRESS"},
+    Setting{"port", "SERVER_PORT"},
+    Setting{"threads", "SERVER_THREADS"},
+    Setting{"cpu_affinity", "SERVER_CPU_AFFINITY"},
+    Setting{"listen_backlog", "SERVER_LISTEN_BACKLOG"},
+    Setting{"handoff_socket", "HANDOFF_SOCKET"},
+    Setting{"log_level", "LOG_LEVEL"},
+    Setting{"trace_sample_every", "TRACE_SAMPLE_EVERY"},
+    Setting{"trace_file", "TRACE_FILE"},
+    Setting{"replay_file", "REPLAY_FILE"},
+    Setting{"session.single_strand", "SESSION_SINGLE_STRAND"},
+    Setting{"session.upgrade_timeout_s", "SESSION_UPGRADE_TIMEOUT_S"},
+    Setting{"session.handshake_timeout_s", "SESSION_HANDSHAKE_TIMEOUT_S"},
+    Setting{"session.idle_timeout_s", "SESSION_IDLE_TIMEOUT_S"},
+    Setting{"session.keep_alive_pings", "SESSION_KEEPALIVE_PINGS"},
+    Setting{"session.write_stall_timeout_s", "SESSION_WRITE_STALL_TIMEOUT_S"},
+    Setting{"session.drain_timeout_s", "SESSION_DRAIN_TIMEOUT_S"},
+    Setting{"session.handoff_drain_timeout_s", "SESSION_HANDOFF_DRAIN_TIMEOUT_S"},
+    Setting{"lobby.resume_grace_s", "SESSION_RESUME_GRACE_S"},
+    Setting{"lobby.idle_timeout_s", "LOBBY_IDLE_TIMEOUT_S"},
+    Setting{"lobby.half_empty_timeout_s", "LOBBY_HALF_EMPTY_TIMEOUT_S"},
+    Setting{"lobby.snapshot_file", "LOBBY_SNAPSHOT_FILE"},
+    Setting{"admission.max_sessions", "ADMISSION_MAX_SESSIONS"},
+    Setting{"admission.accept_rate", "ADMISSION_ACCEPT_RATE"},
+    Setting{"admission.accept_burst", "ADMISSION_ACCEPT_BURST"},
+    Setting{"admission.max_pending_handshakes", "ADMISSION_MAX_PENDING_HANDSHAKES"},
+    Setting{"admission.max_pending_rejections", "ADMISSION_MAX_PENDING_REJECTIONS"},
+};
+
+// The most threads and the highest CPU a config may name.
+constexpr uint32_t kMaxThreads = 1024;
+constexpr uint32_t kMaxCpu     = 1023;
+
+// The longest timeout a config may set, so durations can't overflow.
+constexpr uint32_t kMaxTimeoutSeconds = 7 * 24 * 60 * 60;
+
+// Raw values by key, as last set by the file, the environment or the command line.
+using Values = std::unordered_map<string_view, string>;
+
+string_view trim(string_view str) {
+  constexpr string_view kSpace = " \t\r";
+  const auto begin             = str.find_first_not_of(kSpace);
+  if (begin == string_view::npos) {
+    return {};
+  }
+  return str.substr(begin, str.find_last_not_of(kSpace) - begin + 1);
+}
+
+// Sets key to value if key is a setting. Keys are stored as views of kSettings.
+bool put(Values& values, string_view key, string_view value) {
+  for (const Setting& setting : kSettings) {
+    if (setting.key == key) {
+      values[setting.key] = string(value);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool read_file(const string& path, Values& values, string& error) {
+  std::ifstream file(path);
+  if (!file) {
+    error = "Can't read config file " + path;
+    return false;
+  }
+
+  string line;
+  for (int number = 1; std::getline(file, line); ++number) {
+    const string_view content = trim(string_view(line).substr(0, line.find('#')));
+    if (content.empty()) {
+      continue;
+    }
+    const auto eq = content.find('=');
+    const auto at = path + ":" + std::to_string(number) + ": ";
+    if (eq == string_view::npos) {
+      error = at + "expected key = value";
+      return false;
+    }
+    const string_view key = trim(content.substr(0, eq));
+    if (!put(values, key, trim(content.substr(eq + 1)))) {
+      error = at + "unknown setting " + string(key);
+      return false;
+    }
+  }
+  return true;
+}
+
+void read_env(Values& values) {
+  for (const Setting& setting : kSettings) {
+    if (const char* value = std::getenv(setting.env)) {
+      values[setting.key] = value;
+    }
+  }
+}
+
+bool read_args(std::span<const string> args, Values& values, string& error) {
+  for (const string& arg : args) {
+    const string_view view(arg);
+    const auto eq = view.find('=');
+    if (!view.starts_with("--") || eq == string_view::npos) {
+      error = "Expected --key=value, got " + arg;
+      return false;
+    }
+    const string_view key = view.substr(2, eq - 2);
+    if (key != "config" && !put(values, key, view.substr(eq + 1))) {
+      error = "Unknown setting " + string(key);
+      return false;
+    }
+  }
+  return true;
+}
+
+// Gets the config file named by --config or CONFIG_FILE, if any.
+optional<string> file_path(std::span<const string> args) {
+  constexpr string_view kFlag = "--config=";
+  for (auto it = args.rbegin(); it != args.rend(); ++it) {
+    if (it->starts_with(kFlag)) {
+      return it->substr(kFlag.size());
+    }
+  }
+  if (const char* path = std::getenv("CONFIG_FILE")) {
+    return path;
+  }
+  return nullopt;
+}
+
+// Parses values into typed settings, recording the first invalid one.
+class Reader {
+ public:
+  Reader(const Values& values, string& error)
+      : values_(values), error_(error) {}
+
+  void read(string_view key, string& out) {
+    if (const string* value = find(key)) {
+      out = *value;
+    }
+  }
+
+  template <std::unsigned_integral T>
+  void read(string_view key, T& out, uint64_t max = std::numeric_limits<T>::max()) {
+    const string* value = find(key);
+    if (value == nullptr) {
+      return;
+    }
+    uint64_t parsed      = 0;
+    const char* end      = value->data() + value->size();
+    const auto [ptr, ec] = std::from_chars(value->data(), end, parsed);
+    if (ec != std::errc() || ptr != end || parsed > max) {
+      fail(key, *value, "a whole number up to " + std::to_string(max));
+      return;
+    }
+    out = static_cast<T>(parsed);
+  }
+
+  void read(string_view key, std::chrono::seconds& out) {
+    uint32_t seconds = 0;
+    if (find(key) != nullptr) {
+      read(key, seconds, kMaxTimeoutSeconds);
+      out = std::chrono::seconds(seconds);
+    }
+  }
+
+  void read(string_view key, bool& out) {
+    const string* value = find(key);
+    if (value == nullptr) {
+      return;
+    }
+    if (*value == "1" || *value == "true") {
+      out = true;
+    } else if (*value == "0" || *value == "false") {
+      out = false;
+    } else {
+      fail(key, *value, "true, false, 1 or 0");
+    }
+  }
+
+  // Reads an IP address, written back in its canonical form so equal
+  // addresses compare equal.
+  void read_address(string_view key, string& out) {
+    const string* value = find(key);
+    if (value == nullptr) {
+      return;
+    }
+    boost::system::error_code ec;
+    const auto address = boost::asio::ip::make_address(*value, ec);
+    if (ec) {
+      fail(key, *value, "an IPv4 or IPv6 address");
+      return;
+    }
+    out = address.to_string();
+  }
+
+  void read(string_view key, logging::Level& out) {
+    const string* value = find(key);
+    if (value == nullptr) {
+      return;
+    }
+    // Only a recognized name parses the same whatever the fallback.
+    const auto level = logging::parse_level(*value, logging::Level::kDebug);
+    if (level != logging::parse_level(*value, logging::Level::kError)) {
+      fail(key, *value, "debug, info, warn or error");
+      return;
+    }
+    out = level;
+  }
+
+  void read(string_view key, std::vector<uint32_t>& out) {
+    const string* value = find(key);
+    if (value == nullptr) {
+      return;
+    }
+    std::vector<uint32_t> cpus;
+    string_view rest = *value;
+    while (!rest.empty()) {
+      const auto comma      = rest.find(',');
+      const string_view cpu = trim(rest.substr(0, comma));
+      uint32_t parsed       = 0;
+      const auto [ptr, ec]  = std::from_chars(cpu.data(), cpu.data() + cpu.size(), parsed);
+      if (cpu.empty() || ec != std::errc() || ptr != cpu.data() + cpu.size() || parsed > kMaxCpu) {
+        fail(key, *value, "a comma separated list of CPUs up to " + std::to_string(kMaxCpu));
+        return;
+      }
+      cpus.push_back(parsed);
+      rest = comma == string_view::npos ? string_view() : rest.substr(comma + 1);
+    }
+    out = std::move(cpus);
+  }
+
+ private:
+  // Gets key's value, or nullptr if it's unset or a setting already failed.
+  const string* find(string_view key) const {
+    if (!error_.empty()) {
+      return nullptr;
+    }
+    const auto it = values_.find(key);
+    return it == values_.end() ? nullptr : &it->second;
+  }
+
+  void fail(string_view key, const string& value, const string& expected) {
+    error_ = "Invalid " + string(key) + " '" + value + "', expected " + expected;
+  }
+
+  const Values& values_;
+  string& error_;
+};
+}  // namespace
+
+optional<Config> load_config(std::span<const string> args, string& error) {
+  error.clear();
+
+  Values values;
+  if (const auto path = file_path(args); path && !read_file(*path, values, error)) {
+    return nullopt;
+  }
+  read_env(values);
+  if (!read_args(args, values, error)) {
+    return nullopt;
+  }
+
+  Config config;
+  Reader reader(values, error);
+  reader.read_address("address", config.address);
+  reader.read("port", config.port);
+  reader.read("threads", config.threads, kMaxThreads);
+  reader.read("cpu_affinity", config.cpu_affinity);
+  reader.read("listen_backlog", config.listen_backlog);
+  reader.read("handoff_socket", config.handoff_socket);
+  reader.read("log_level", config.log_level);
+  reader.read("trace_sample_every", config.trace_sample_every);
+  reader.read("trace_file", config.trace_file);
+  reader.read("replay_file", config.replay_file);
+
+  SessionOptions& session = config.session;
+  reader.read("session.single_strand", session.single_strand);
+  reader.read("session.upgrade_timeout_s", session.upgrade_timeout);
+  reader.read("session.handshake_timeout_s", session.handshake_timeout);
+  reader.read("session.idle_timeout_s", session.idle_timeout);
+  reader.read("session.keep_alive_pings", session.keep_alive_pings);
+  reader.read("session.write_stall_timeout_s", session.write_stall_timeout);
+  reader.read("session.drain_timeout_s", session.drain_timeout);
+  reader.read("session.handoff_drain_timeout_s", session.handoff_drain_timeout);
+
+  LobbyOptions& lobby = config.lobby;
+  reader.read("lobby.resume_grace_s", lobby.resume_grace);
+  reader.read("lobby.idle_timeout_s", lobby.idle_timeout);
+  reader.read("lobby.half_empty_timeout_s", lobby.half_empty_timeout);
+  reader.read("lobby.snapshot_file", lobby.snapshot_path);
+
+  AdmissionOptions& admission = config.admission;
+  reader.read("admission.max_sessions", admission.max_sessions);
+  reader.read("admission.accept_rate", admission.accept_rate);
+  reader.read("admission.accept_burst", admission.accept_burst);
+  reader.read("admission.max_pending_handshakes", admission.max_pending_handshakes);
+  reader.read("admission.max_pending_rejections", admission.max_pending_rejections);
+
+  if (!error.empty()) {
+    return nullopt;
+  }
+  if (config.port == 0) {
+    error = "Set port, e.g. with SERVER_PORT or --port, to run server";
+    return nullopt;
+  }
+  if (config.threads == 0) {
+    config.threads = std::max(1U, std::thread::hardware_concurrency());
+  }
+  return config;
+}
+
+bool needs_restart(const Config& running, const Config& next) {
+  const LobbyOptions& a = running.lobby;
+  const LobbyOptions& b = next.lobby;
+  return running.address != next.address || running.port != next.port
+         || running.threads != next.threads || running.cpu_affinity != next.cpu_affinity
+         || running.listen_backlog != next.listen_backlog
+         || running.handoff_socket != next.handoff_socket
+         || running.trace_file != next.trace_file || running.replay_file != next.replay_file
+         || a.resume_grace != b.resume_grace || a.idle_timeout != b.idle_timeout
+         || a.half_empty_timeout != b.half_empty_timeout || a.snapshot_path != b.snapshot_path;
+}
+
+}  // namespace io_blair
@@ -0,0 +1,124 @@
+/**
+ * @file config.hpp
+ */
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "admission_options.hpp"
+#include "lobby_options.hpp"
+#include "logging.hpp"
+#include "session_options.hpp"
+
+namespace io_blair {
+/**
+ * @brief Every setting the server is tuned with. Loaded by load_config().
+ *
+ * Settings come from a config file, the environment and the command line,
+ * each overriding the one before. The file holds `key = value` lines, with
+ * `#` starting a comment. On the command line a setting is `--key=value`.
+ * Each setting also has an environment variable, e.g. `SERVER_PORT` for
+ * `port`. The file is named by `--config=path` or `CONFIG_FILE`.
+ *
+ * Settings marked reloadable are applied on SIGHUP. The rest only take
+ * effect on restart.
+ */
+struct Config {
+  /**
+   * @brief The address to listen on. Key `address`.
+   */
+  std::string address = "0.0.0.0";
+
+  /**
+   * @brief The port to listen on. Required. Key `port`.
+   */
+  uint16_t port = 0;
+
+  /**
+   * @brief The number of threads running the server. Key `threads`.
+   * load_config() turns 0 into one per hardware thread.
+   */
+  uint32_t threads = 0;
+
+  /**
+   * @brief The CPUs threads are pinned to, round robin. Empty leaves them
+   * unpinned. Key `cpu_affinity`, a comma separated list.
+   */
+  std::vector<uint32_t> cpu_affinity;
+
+  /**
+   * @brief The length of the listening socket's accept queue. Zero uses the
+   * system's maximum. Key `listen_backlog`.
+   */
+  uint32_t listen_backlog = 0;
+
+  /**
+   * @brief The socket a running server hands its listening socket over.
+   * Empty disables handoffs. Key `handoff_socket`.
+   */
+  std::string handoff_socket;
+
+  /**
+   * @brief The lowest level logged. Reloadable. Key `log_level`.
+   */
+  logging::Level log_level = logging::Level::kInfo;
+
+  /**
+   * @brief Traces one in this many inbound messages. Zero disables tracing.
+   * Reloadable. Key `trace_sample_every`.
+   */
+  uint32_t trace_sample_every = 0;
+
+  /**
+   * @brief Where traces are dumped on SIGUSR1. Key `trace_file`.
+   */
+  std::string trace_file;
+
+  /**
+   * @brief Where games are recorded. Empty disables recording. Key `replay_file`.
+   */
+  std::string replay_file;
+
+  /**
+   * @brief Reloadable, applied to sessions started afterwards. Keys `session.*`.
+   */
+  SessionOptions session;
+
+  /**
+   * @brief Keys `lobby.*`.
+   */
+  LobbyOptions lobby;
+
+  /**
+   * @brief Reloadable. Keys `admission.*`.
+   */
+  AdmissionOptions admission;
+};
+
+/**
+ * @brief Loads and validates the config from the file, the environment and
+ * \p args, in increasing precedence.
+ *
+ * @param args The command line arguments, without the program name.
+ * @param error Set to what's wrong if loading fails.
+ * @return std::optional<Config> The config, or nullopt if a setting is
+ * unknown or invalid, or the file can't be read.
+ */
+std::optional<Config> load_config(std::span<const std::string> args, std::string& error);
+
+/**
+ * @brief Determines whether any setting that only takes effect on restart
+ * differs between \p running and \p next.
+ *
+ * @param running
+ * @param next
+ * @return true Reloading \p next leaves some of its settings unapplied.
+ * @return false
+ */
+bool needs_restart(const Config& running, const Config& next);
+
+}  // namespace io_blair
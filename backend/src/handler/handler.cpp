@@ -1,7 +1,8 @@
 #include "handler.hpp"
 
-#include <memory>
+#include <type_traits>
 #include <utility>
+#include <variant>
 
 #include "igame.hpp"
 #include "ilobby.hpp"
@@ -9,58 +10,91 @@
 
 
 namespace io_blair {
-using std::make_unique;
+using std::string;
 using std::string_view;
-using std::unique_ptr;
 namespace jin  = json::in;
 namespace jout = json::out;
 
-Game::Game(SessionContext ctx, unique_ptr<IGameHandler>&& handler)
-    : ctx_(std::move(ctx)), state_(std::move(handler)) {}
+Game::Game(SessionContext ctx, GameState state)
+    : ctx_(std::move(ctx)), state_(std::move(state)) {}
 
-void Game::transition_to(unique_ptr<IGameHandler> handler) {
-  state_ = std::move(handler);
+void Game::transition_to(GameState state) {
+  // Lobby holds references so it can't be assigned. Rebuild the state in place instead.
+  std::visit(
+      [this](auto&& next) {
+        state_.emplace<std::decay_t<decltype(next)>>(std::forward<decltype(next)>(next));
+      },
+      std::move(state));
+}
+
+template <typename Event>
+void Game::forward(const Event& ev) {
+  std::visit(
+      [&](auto& state) {
+        if constexpr (requires { state(static_cast<IGame&>(*this), ctx_, ev); }) {
+          state(*this, ctx_, ev);
+        }
+      },
+      state_);
 }
 
 void Game::operator()(const jin::Ping&) {
   ctx_.session.lock()->async_send(jout::pong_msg());
 }
 void Game::operator()(const jin::LobbyCreate& ev) {
-  (*state_)(*this, ctx_, ev);
+  forward(ev);
 }
 void Game::operator()(const jin::LobbyJoin& ev) {
-  (*state_)(*this, ctx_, ev);
+  forward(ev);
+}
+void Game::operator()(const jin::LobbyResume& ev) {
+  forward(ev);
 }
 void Game::operator()(const jin::LobbyLeave& ev) {
-  (*state_)(*this, ctx_, ev);
+  forward(ev);
 }
 void Game::operator()(const jin::Chat& ev) {
-  (*state_)(*this, ctx_, ev);
+  forward(ev);
 }
 void Game::operator()(const jin::CharacterHover& ev) {
-  (*state_)(*this, ctx_, ev);
+  forward(ev);
 }
 void Game::operator()(const jin::CharacterConfirm& ev) {
-  (*state_)(*this, ctx_, ev);
+  forward(ev);
 }
 void Game::operator()(const jin::CharacterMove& ev) {
-  (*state_)(*this, ctx_, ev);
+  forward(ev);
 }
 void Game::operator()(const jin::CheckWin& ev) {
-  (*state_)(*this, ctx_, ev);
+  forward(ev);
 }
 void Game::operator()(const jin::NewGame& ev) {
-  (*state_)(*this, ctx_, ev);
+  forward(ev);
+}
+void Game::operator()(const jin::Matchmake& ev) {
+  forward(ev);
+}
+void Game::operator()(const jin::MatchmakeCancel& ev) {
+  forward(ev);
+}
+void Game::operator()(const jin::Spectate& ev) {
+  forward(ev);
 }
 void Game::operator()(SessionEvent ev) {
-  (*state_)(*this, ctx_, ev);
+  forward(ev);
 }
 
 void Prelobby::operator()(IGame& game, SessionContext& ctx, const jin::LobbyCreate&) {
+  if (!cancel_matchmaking()) {
+    return;
+  }
   transition_to_lobby(game, ctx.lobby_manager.create(ctx.session));
 }
 
 void Prelobby::operator()(IGame& game, SessionContext& ctx, const jin::LobbyJoin& ev) {
+  if (!cancel_matchmaking()) {
+    return;
+  }
   auto opt = ctx.lobby_manager.join(ctx.session, ev.code);
   if (!opt.has_value()) {
     return;
@@ -69,20 +103,110 @@ void Prelobby::operator()(IGame& game, SessionContext& ctx, const jin::LobbyJoin
   transition_to_lobby(game, std::move(*opt));
 }
 
+void Prelobby::operator()(IGame& game, SessionContext& ctx, const jin::LobbyResume& ev) {
+  if (!cancel_matchmaking()) {
+    return;
+  }
+  auto opt = ctx.lobby_manager.resume(ctx.session, ev.token);
+  if (!opt.has_value()) {
+    return;
+  }
+
+  transition_to_lobby(game, std::move(*opt));
+}
+
+void Prelobby::operator()(IGame&, SessionContext& ctx, const jin::Matchmake& ev) {
+  if (ticket_ && ticket_->state() != MatchTicket::State::kCancelled) {
+    return;
+  }
+  ticket_ = ctx.lobby_manager.matchmake(ctx.session, ev.character.value_or(Character::unknown));
+}
+
+void Prelobby::operator()(IGame&, SessionContext&, const jin::MatchmakeCancel&) {
+  cancel_matchmaking();
+}
+
+void Prelobby::operator()(IGame& game, SessionContext& ctx, const jin::Spectate& ev) {
+  if (!cancel_matchmaking()) {
+    return;
+  }
+  if (ctx.lobby_manager.spectate(ctx.session, ev.code)) {
+    game.transition_to(Spectating(ev.code));
+  }
+}
+
+void Prelobby::operator()(IGame& game, SessionContext& ctx, SessionEvent ev) {
+  switch (ev) {
+    case SessionEvent::kMatchFound:
+      if (ticket_ && ticket_->match.has_value()) {
+        // The transition destroys this, so hold the ticket here until it's done.
+        auto ticket = std::move(ticket_);
+        transition_to_lobby(game, std::move(*ticket->match));
+      }
+      break;
+    case SessionEvent::kCloseSession:
+      if (!cancel_matchmaking()) {
+        ctx.lobby_manager.leave(ctx.session, ticket_->match->code);
+        ticket_.reset();
+      }
+      break;
+    default: break;
+  }
+}
+
 void Prelobby::transition_to_lobby(IGame& game, LobbyContext lob_ctx) {
-  game.transition_to(make_unique<Lobby>(std::move(lob_ctx)));
+  game.transition_to(Lobby(std::move(lob_ctx)));
 }
 
-Lobby::Lobby(LobbyContext ctx, unique_ptr<ILobbyHandler>&& handler)
-    : ctx_(std::move(ctx)), state_(std::move(handler)) {}
+bool Prelobby::cancel_matchmaking() {
+  if (!ticket_) {
+    return true;
+  }
+  if (!ticket_->cancel()) {
+    return false;
+  }
+  ticket_.reset();
+  return true;
+}
+
+Spectating::Spectating(string code)
+    : code_(std::move(code)) {}
+
+void Spectating::operator()(IGame& game, SessionContext& ctx, const jin::LobbyLeave&) {
+  ctx.lobby_manager.unspectate(ctx.session, code_);
+  game.transition_to(Prelobby{});
+}
+
+void Spectating::operator()(IGame& game, SessionContext& ctx, SessionEvent ev) {
+  switch (ev) {
+    case SessionEvent::kCloseSession: ctx.lobby_manager.unspectate(ctx.session, code_); break;
+    // The lobby already let go of its spectators.
+    case SessionEvent::kLobbyClosed: game.transition_to(Prelobby{}); break;
+    default:                         break;
+  }
+}
+
+Lobby::Lobby(LobbyContext ctx, LobbyState state)
+    : ctx_(std::move(ctx)), state_(std::move(state)) {}
 
-void Lobby::transition_to(std::unique_ptr<ILobbyHandler> handler) {
-  state_ = std::move(handler);
+void Lobby::transition_to(LobbyState state) {
+  state_ = std::move(state);
+}
+
+template <typename Event>
+void Lobby::forward(SessionContext& sess_ctx, const Event& ev) {
+  std::visit(
+      [&](auto& state) {
+        if constexpr (requires { state(static_cast<ILobby&>(*this), sess_ctx, ctx_, ev); }) {
+          state(*this, sess_ctx, ctx_, ev);
+        }
+      },
+      state_);
 }
 
 void Lobby::operator()(IGame& game, SessionContext& sess_ctx, const jin::LobbyLeave&) {
   sess_ctx.lobby_manager.leave(sess_ctx.session, ctx_.code);
-  game.transition_to(make_unique<Prelobby>());
+  game.transition_to(Prelobby{});
 }
 
 void Lobby::operator()(IGame&, SessionContext&, const jin::Chat& ev) {
@@ -90,25 +214,30 @@ void Lobby::operator()(IGame&, SessionContext&, const jin::Chat& ev) {
 }
 
 void Lobby::operator()(IGame&, SessionContext& sess_ctx, const jin::CharacterHover& ev) {
-  (*state_)(*this, sess_ctx, ctx_, ev);
+  forward(sess_ctx, ev);
 }
 void Lobby::operator()(IGame&, SessionContext& sess_ctx, const jin::CharacterConfirm& ev) {
-  (*state_)(*this, sess_ctx, ctx_, ev);
+  forward(sess_ctx, ev);
 }
 void Lobby::operator()(IGame&, SessionContext& sess_ctx, const jin::CharacterMove& ev) {
-  (*state_)(*this, sess_ctx, ctx_, ev);
+  forward(sess_ctx, ev);
 }
 void Lobby::operator()(IGame&, SessionContext& sess_ctx, const jin::CheckWin& ev) {
-  (*state_)(*this, sess_ctx, ctx_, ev);
+  forward(sess_ctx, ev);
 }
 void Lobby::operator()(IGame&, SessionContext& sess_ctx, const jin::NewGame& ev) {
-  (*state_)(*this, sess_ctx, ctx_, ev);
+  forward(sess_ctx, ev);
 }
 
 void Lobby::operator()(IGame& game, SessionContext& sess_ctx, SessionEvent ev) {
   switch (ev) {
-    case SessionEvent::kCloseSession: (*this)(game, sess_ctx, jin::LobbyLeave{}); break;
-    default:                          (*state_)(*this, sess_ctx, ctx_, ev); break;
+    case SessionEvent::kCloseSession:
+      // The client may reconnect and resume, so hold its place instead of leaving.
+      sess_ctx.lobby_manager.suspend(sess_ctx.session, ctx_.code);
+      game.transition_to(Prelobby{});
+      break;
+    case SessionEvent::kLobbyClosed: (*this)(game, sess_ctx, jin::LobbyLeave{}); break;
+    default:                         forward(sess_ctx, ev); break;
   }
 }
 
@@ -124,7 +253,7 @@ void CharacterSelect::operator()(ILobby&, SessionContext&, LobbyContext& lob_ctx
 
 void CharacterSelect::operator()(ILobby& lobby, SessionContext&, LobbyContext&, SessionEvent ev) {
   switch (ev) {
-    case SessionEvent::kTransitionToInGame: lobby.transition_to(make_unique<InGame>()); break;
+    case SessionEvent::kTransitionToInGame: lobby.transition_to(InGame{}); break;
     default:                                break;
   }
 }
@@ -143,9 +272,9 @@ void InGame::operator()(ILobby&, SessionContext&, LobbyContext& lob_ctx, const j
 void InGame::operator()(ILobby& lobby, SessionContext&, LobbyContext&, SessionEvent ev) {
   switch (ev) {
     case SessionEvent::kTransitionToCharacterSelect:
-      lobby.transition_to(make_unique<CharacterSelect>());
+      lobby.transition_to(CharacterSelect{});
       break;
-    case SessionEvent::kTransitionToGameDone: lobby.transition_to(make_unique<GameDone>()); break;
+    case SessionEvent::kTransitionToGameDone: lobby.transition_to(GameDone{}); break;
     default:                                  break;
   }
 }
@@ -156,7 +285,7 @@ void GameDone::operator()(ILobby&, SessionContext&, LobbyContext& lob_ctx, const
 
 void GameDone::operator()(ILobby& lobby, SessionContext&, LobbyContext&, SessionEvent ev) {
   switch (ev) {
-    case SessionEvent::kTransitionToInGame: lobby.transition_to(make_unique<InGame>()); break;
+    case SessionEvent::kTransitionToInGame: lobby.transition_to(InGame{}); break;
     default:                                break;
   }
 }
@@ -4,6 +4,7 @@
 #pragma once
 
 #include <memory>
+#include <string>
 
 #include "event.hpp"
 #include "igame.hpp"
@@ -11,133 +12,169 @@
 #include "ilobby.hpp"
 #include "json.hpp"
 #include "lobby_context.hpp"
+#include "matchmaker.hpp"
 #include "session_context.hpp"
 
 
 namespace io_blair {
 /**
- * @brief A state of IGame before the client has joined a lobby.
- * Expecting events to create/join a lobby.
+ * @brief A state of ILobby where the client is selecting their character.
+ * Expecting client messages of character hovering/confirming, chat messages,
+ * and leaving.
  */
-class Prelobby : public IGameHandler {
+class CharacterSelect {
  public:
-  void operator()(IGame&, SessionContext&, const json::in::LobbyCreate&) override;
-  void operator()(IGame&, SessionContext&, const json::in::LobbyJoin&) override;
-
- private:
-  // Transitions the IGame to the Lobby state.
-  static void transition_to_lobby(IGame&, LobbyContext);
+  void operator()(ILobby&, SessionContext&, LobbyContext&, const json::in::CharacterHover&);
+  void operator()(ILobby&, SessionContext&, LobbyContext&, const json::in::CharacterConfirm&);
+  void operator()(ILobby&, SessionContext&, LobbyContext&, SessionEvent);
 };
 
 /**
- * @brief A state context that forwards events to the current state. Possible states
- * are Prelobby and Lobby.
+ * @brief A state of ILobby where the client is trying to finish the game.
  */
-class Game : public IGame, public IHandler {
+class InGame {
  public:
-  /**
-   * @brief Construct a new Game object.
-   * 
-   * @param ctx Context from the Session.
-   */
-  explicit Game(SessionContext ctx,
-                std::unique_ptr<IGameHandler>&& handler = std::make_unique<Prelobby>());
-
-  void transition_to(std::unique_ptr<IGameHandler> handler) override;
-
-  void operator()(const json::in::Ping&) override;
-  void operator()(const json::in::LobbyCreate&) override;
-  void operator()(const json::in::LobbyJoin&) override;
-  void operator()(const json::in::LobbyLeave&) override;
-  void operator()(const json::in::Chat&) override;
-  void operator()(const json::in::CharacterHover&) override;
-  void operator()(const json::in::CharacterConfirm&) override;
-  void operator()(const json::in::CharacterMove&) override;
-  void operator()(const json::in::CheckWin&) override;
-  void operator()(const json::in::NewGame&) override;
-  void operator()(SessionEvent) override;
-
- private:
-  // Session::make() creates a Session that uses Game. That Game
-  // has the same lifetime as the session so that Game's ctx_.session
-  // will always be a valid pointer to the session.
-  SessionContext ctx_;
-
-  // The current state to forward events to.
-  std::unique_ptr<IGameHandler> state_;
+  void operator()(ILobby&, SessionContext&, LobbyContext&, const json::in::CharacterMove&);
+  void operator()(ILobby&, SessionContext&, LobbyContext&, const json::in::CheckWin&);
+  void operator()(ILobby&, SessionContext&, LobbyContext&, SessionEvent);
 };
 
 /**
- * @brief A state of ILobby where the client is selecting their character.
- * Expecting client messages of character hovering/confirming, chat messages,
- * and leaving.
+ * @brief A state of ILobby where the client has completed the game.
  */
-class CharacterSelect : public ILobbyHandler {
+class GameDone {
  public:
-  void operator()(ILobby&, SessionContext&, LobbyContext&,
-                  const json::in::CharacterHover&) override;
-  void operator()(ILobby&, SessionContext&, LobbyContext&,
-                  const json::in::CharacterConfirm&) override;
-  void operator()(ILobby&, SessionContext&, LobbyContext&, SessionEvent) override;
-
- private:
+  void operator()(ILobby&, SessionContext&, LobbyContext&, const json::in::NewGame&);
+  void operator()(ILobby&, SessionContext&, LobbyContext&, SessionEvent);
 };
 
 /**
  * @brief A state of IGame where the client is in a lobby. Lobby itself
  * is a state context that forwards events to the current state.
- * Possible substates are CharacterSelect, InGame, GameFinished.
+ * Possible substates are CharacterSelect, InGame, GameDone.
  */
-class Lobby : public ILobby, public IGameHandler {
+class Lobby : public ILobby {
  public:
   /**
    * @brief Construct a new Lobby object.
-   * 
+   *
    * @param ctx Context from the lobby.
+   * @param state The initial state.
    */
-  explicit Lobby(LobbyContext ctx,
-                 std::unique_ptr<ILobbyHandler>&& handler = std::make_unique<CharacterSelect>());
+  explicit Lobby(LobbyContext ctx, LobbyState state = CharacterSelect{});
 
-  void transition_to(std::unique_ptr<ILobbyHandler>) override;
+  void transition_to(LobbyState state) override;
 
-  void operator()(IGame&, SessionContext&, const json::in::LobbyLeave&) override;
-  void operator()(IGame&, SessionContext&, const json::in::Chat&) override;
-  void operator()(IGame&, SessionContext&, const json::in::CharacterHover&) override;
-  void operator()(IGame&, SessionContext&, const json::in::CharacterConfirm&) override;
-  void operator()(IGame&, SessionContext&, const json::in::CharacterMove&) override;
-  void operator()(IGame&, SessionContext&, const json::in::CheckWin&) override;
-  void operator()(IGame&, SessionContext&, const json::in::NewGame&) override;
-  void operator()(IGame&, SessionContext&, SessionEvent) override;
+  void operator()(IGame&, SessionContext&, const json::in::LobbyLeave&);
+  void operator()(IGame&, SessionContext&, const json::in::Chat&);
+  void operator()(IGame&, SessionContext&, const json::in::CharacterHover&);
+  void operator()(IGame&, SessionContext&, const json::in::CharacterConfirm&);
+  void operator()(IGame&, SessionContext&, const json::in::CharacterMove&);
+  void operator()(IGame&, SessionContext&, const json::in::CheckWin&);
+  void operator()(IGame&, SessionContext&, const json::in::NewGame&);
+  void operator()(IGame&, SessionContext&, SessionEvent);
 
  private:
+  // Forwards ev to the current state. States that don't handle ev ignore it.
+  template <typename Event>
+  void forward(SessionContext& sess_ctx, const Event& ev);
+
   LobbyContext ctx_;
 
   // The current state to forward events to.
-  std::unique_ptr<ILobbyHandler> state_;
+  LobbyState state_;
 };
 
+/**
+ * @brief A state of IGame before the client has joined a lobby.
+ * Expecting events to create/join a lobby or to look for a quick match.
+ */
+class Prelobby {
+ public:
+  void operator()(IGame&, SessionContext&, const json::in::LobbyCreate&);
+  void operator()(IGame&, SessionContext&, const json::in::LobbyJoin&);
+  void operator()(IGame&, SessionContext&, const json::in::LobbyResume&);
+  void operator()(IGame&, SessionContext&, const json::in::Matchmake&);
+  void operator()(IGame&, SessionContext&, const json::in::MatchmakeCancel&);
+  void operator()(IGame&, SessionContext&, const json::in::Spectate&);
+  void operator()(IGame&, SessionContext&, SessionEvent);
+
+ private:
+  // Transitions the IGame to the Lobby state.
+  static void transition_to_lobby(IGame&, LobbyContext);
+
+  // Withdraws from matchmaking. Returns false if the session was already
+  // matched, in which case a SessionEvent::kMatchFound is on its way.
+  bool cancel_matchmaking();
+
+  // The session's place in matchmaking, if it's looking for a match.
+  std::shared_ptr<MatchTicket> ticket_;
+};
 
 /**
- * @brief A state of ILobby where the client is trying to finish the game.
+ * @brief A state of IGame where the client is watching a lobby it isn't
+ * playing in. Expecting the client to leave.
  */
-class InGame : public ILobbyHandler {
+class Spectating {
  public:
-  void operator()(ILobby&, SessionContext&, LobbyContext&, const json::in::CharacterMove&) override;
-  void operator()(ILobby&, SessionContext&, LobbyContext&, const json::in::CheckWin&) override;
-  void operator()(ILobby&, SessionContext&, LobbyContext&, SessionEvent) override;
+  /**
+   * @brief Construct a new Spectating object.
+   *
+   * @param code The join code of the lobby being watched.
+   */
+  explicit Spectating(std::string code);
+
+  void operator()(IGame&, SessionContext&, const json::in::LobbyLeave&);
+  void operator()(IGame&, SessionContext&, SessionEvent);
 
  private:
+  std::string code_;
 };
 
 /**
- * @brief A state of ILobby where the client has completed the game.
+ * @brief A state context that forwards events to the current state. Possible states
+ * are Prelobby, Lobby and Spectating.
  */
-class GameDone : public ILobbyHandler {
+class Game : public IGame, public IHandler {
  public:
-  void operator()(ILobby&, SessionContext&, LobbyContext&, const json::in::NewGame&) override;
-  void operator()(ILobby&, SessionContext&, LobbyContext&, SessionEvent) override;
+  /**
+   * @brief Construct a new Game object.
+   *
+   * @param ctx Context from the Session.
+   * @param state The initial state.
+   */
+  explicit Game(SessionContext ctx, GameState state = Prelobby{});
+
+  void transition_to(GameState state) override;
+
+  void operator()(const json::in::Ping&) override;
+  void operator()(const json::in::LobbyCreate&) override;
+  void operator()(const json::in::LobbyJoin&) override;
+  void operator()(const json::in::LobbyResume&) override;
+  void operator()(const json::in::LobbyLeave&) override;
+  void operator()(const json::in::Chat&) override;
+  void operator()(const json::in::CharacterHover&) override;
+  void operator()(const json::in::CharacterConfirm&) override;
+  void operator()(const json::in::CharacterMove&) override;
+  void operator()(const json::in::CheckWin&) override;
+  void operator()(const json::in::NewGame&) override;
+  void operator()(const json::in::Matchmake&) override;
+  void operator()(const json::in::MatchmakeCancel&) override;
+  void operator()(const json::in::Spectate&) override;
+  void operator()(SessionEvent) override;
 
  private:
+  // Forwards ev to the current state. States that don't handle ev ignore it.
+  template <typename Event>
+  void forward(const Event& ev);
+
+  // Session::make() creates a Session that uses Game. That Game
+  // has the same lifetime as the session so that Game's ctx_.session
+  // will always be a valid pointer to the session.
+  SessionContext ctx_;
+
+  // The current state to forward events to.
+  GameState state_;
 };
 
 }  // namespace io_blair
@@ -3,45 +3,31 @@
  */
 #pragma once
 
-#include <memory>
-
-#include "event.hpp"
-#include "json.hpp"
-#include "session_context.hpp"
+#include <variant>
 
 
 namespace io_blair {
-class IGameHandler;
+class Prelobby;
+class Lobby;
+class Spectating;
 
 /**
- * @brief An interface for a state context of IGameHandler.
+ * @brief The possible states of IGame. States are held inline, so transitioning
+ * between them doesn't allocate.
+ */
+using GameState = std::variant<Prelobby, Lobby, Spectating>;
+
+/**
+ * @brief An interface for a state context of GameState.
  */
 class IGame {
  public:
   /**
-   * @brief Transitions the current state to \p handler.
+   * @brief Transitions the current state to \p state.
    * 
-   * @param handler The new state.
+   * @param state The new state.
    */
-  virtual void transition_to(std::unique_ptr<IGameHandler>) = 0;
-};
-
-/**
- * @brief An interface for a state of IGame. Event handlers do nothing by default.
- */
-class IGameHandler {
- public:
-  virtual ~IGameHandler() = default;
-  virtual void operator()(IGame&, SessionContext&, const json::in::LobbyCreate&);
-  virtual void operator()(IGame&, SessionContext&, const json::in::LobbyJoin&);
-  virtual void operator()(IGame&, SessionContext&, const json::in::LobbyLeave&);
-  virtual void operator()(IGame&, SessionContext&, const json::in::Chat&);
-  virtual void operator()(IGame&, SessionContext&, const json::in::CharacterHover&);
-  virtual void operator()(IGame&, SessionContext&, const json::in::CharacterConfirm&);
-  virtual void operator()(IGame&, SessionContext&, const json::in::CharacterMove&);
-  virtual void operator()(IGame&, SessionContext&, const json::in::CheckWin&);
-  virtual void operator()(IGame&, SessionContext&, const json::in::NewGame&);
-  virtual void operator()(IGame&, SessionContext&, SessionEvent);
+  virtual void transition_to(GameState state) = 0;
 };
 
 }  // namespace io_blair
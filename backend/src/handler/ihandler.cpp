@@ -4,6 +4,7 @@ namespace io_blair {
 void IHandler::operator()(const json::in::Ping&) {}
 void IHandler::operator()(const json::in::LobbyCreate&) {}
 void IHandler::operator()(const json::in::LobbyJoin&) {}
+void IHandler::operator()(const json::in::LobbyResume&) {}
 void IHandler::operator()(const json::in::LobbyLeave&) {}
 void IHandler::operator()(const json::in::Chat&) {}
 void IHandler::operator()(const json::in::CharacterHover&) {}
@@ -11,6 +12,9 @@ void IHandler::operator()(const json::in::CharacterConfirm&) {}
 void IHandler::operator()(const json::in::CharacterMove&) {}
 void IHandler::operator()(const json::in::CheckWin&) {}
 void IHandler::operator()(const json::in::NewGame&) {}
+void IHandler::operator()(const json::in::Matchmake&) {}
+void IHandler::operator()(const json::in::MatchmakeCancel&) {}
+void IHandler::operator()(const json::in::Spectate&) {}
 void IHandler::operator()(SessionEvent) {}
 
 }  // namespace io_blair
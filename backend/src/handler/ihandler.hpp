@@ -17,6 +17,7 @@ class IHandler {
   virtual void operator()(const json::in::Ping&);
   virtual void operator()(const json::in::LobbyCreate&);
   virtual void operator()(const json::in::LobbyJoin&);
+  virtual void operator()(const json::in::LobbyResume&);
   virtual void operator()(const json::in::LobbyLeave&);
   virtual void operator()(const json::in::Chat&);
   virtual void operator()(const json::in::CharacterHover&);
@@ -24,6 +25,9 @@ class IHandler {
   virtual void operator()(const json::in::CharacterMove&);
   virtual void operator()(const json::in::CheckWin&);
   virtual void operator()(const json::in::NewGame&);
+  virtual void operator()(const json::in::Matchmake&);
+  virtual void operator()(const json::in::MatchmakeCancel&);
+  virtual void operator()(const json::in::Spectate&);
   virtual void operator()(SessionEvent);
 };
 
@@ -3,45 +3,31 @@
  */
 #pragma once
 
-#include <memory>
-
-#include "event.hpp"
-#include "json.hpp"
-#include "lobby_context.hpp"
-#include "session_context.hpp"
+#include <variant>
 
 
 namespace io_blair {
-class ILobbyHandler;
+class CharacterSelect;
+class InGame;
+class GameDone;
+
+/**
+ * @brief The possible states of ILobby. States are held inline, so transitioning
+ * between them doesn't allocate.
+ */
+using LobbyState = std::variant<CharacterSelect, InGame, GameDone>;
 
 /**
- * @brief An interface for a state context of ILobbyHandler.
+ * @brief An interface for a state context of LobbyState.
  */
 class ILobby {
  public:
   /**
-   * @brief Transitions the current state to \p handler.
+   * @brief Transitions the current state to \p state.
    * 
-   * @param handler The new state.
+   * @param state The new state.
    */
-  virtual void transition_to(std::unique_ptr<ILobbyHandler>) = 0;
+  virtual void transition_to(LobbyState state) = 0;
 };
 
-/**
- * @brief An interface for a state of ILobby. Event handlers do nothing by default.
- */
-class ILobbyHandler {
- public:
-  virtual ~ILobbyHandler() = default;
-  virtual void operator()(ILobby&, SessionContext&, LobbyContext&, const json::in::CharacterHover&);
-  virtual void operator()(ILobby&, SessionContext&, LobbyContext&,
-                          const json::in::CharacterConfirm&);
-  virtual void operator()(ILobby&, SessionContext&, LobbyContext&,
-                          const json::in::CharacterMove&);
-  virtual void operator()(ILobby&, SessionContext&, LobbyContext&,
-                          const json::in::CheckWin&);
-  virtual void operator()(ILobby&, SessionContext&, LobbyContext&,
-                          const json::in::NewGame&);
-  virtual void operator()(ILobby&, SessionContext&, LobbyContext&, SessionEvent);
-};
 }  // namespace io_blair
@@ -0,0 +1,105 @@
+#include "handoff.hpp"
+
+#include <cstring>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#define IO_BLAIR_HAS_SCM_RIGHTS 1
+#endif
+
+
+namespace io_blair::handoff {
+#ifdef IO_BLAIR_HAS_SCM_RIGHTS
+namespace {
+// How long a new server waits for the running one to answer.
+constexpr timeval kReceiveTimeout = {.tv_sec = 5, .tv_usec = 0};
+}  // namespace
+
+bool send_fd(int socket, int fd) {
+  // At least one byte of ordinary data must go along with the descriptor.
+  char byte = 0;
+  iovec iov{.iov_base = &byte, .iov_len = 1};
+
+  alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+  msghdr msg{};
+  msg.msg_iov        = &iov;
+  msg.msg_iovlen     = 1;
+  msg.msg_control    = control;
+  msg.msg_controllen = sizeof(control);
+
+  cmsghdr* cmsg    = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type  = SCM_RIGHTS;
+  cmsg->cmsg_len   = CMSG_LEN(sizeof(int));
+  std::memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+
+  return ::sendmsg(socket, &msg, 0) == 1;
+}
+
+int receive_fd(int socket) {
+  char byte = 0;
+  iovec iov{.iov_base = &byte, .iov_len = 1};
+
+  alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+  msghdr msg{};
+  msg.msg_iov        = &iov;
+  msg.msg_iovlen     = 1;
+  msg.msg_control    = control;
+  msg.msg_controllen = sizeof(control);
+
+  if (::recvmsg(socket, &msg, 0) != 1) {
+    return -1;
+  }
+
+  const cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  if (cmsg == nullptr || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS ||
+      cmsg->cmsg_len != CMSG_LEN(sizeof(int))) {
+    return -1;
+  }
+  int fd = -1;
+  std::memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+  return fd;
+}
+
+int request_listener(const std::string& path) {
+  sockaddr_un addr{};
+  addr.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(addr.sun_path)) {
+    return -1;
+  }
+  path.copy(addr.sun_path, path.size());
+
+  const int socket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (socket < 0) {
+    return -1;
+  }
+
+  const auto* endpoint         = reinterpret_cast<const sockaddr*>(&addr);
+  const socklen_t timeout_size = sizeof(kReceiveTimeout);
+  int fd                       = -1;
+  if (::setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, &kReceiveTimeout, timeout_size) == 0 &&
+      ::connect(socket, endpoint, sizeof(addr)) == 0) {
+    fd = receive_fd(socket);
+  }
+  ::close(socket);
+  return fd;
+}
+#else
+bool send_fd(int, int) {
+  return false;
+}
+
+int receive_fd(int) {
+  return -1;
+}
+
+int request_listener(const std::string&) {
+  return -1;
+}
+#endif
+
+}  // namespace io_blair::handoff
@@ -0,0 +1,49 @@
+/**
+ * @file handoff.hpp
+ */
+#pragma once
+
+#include <string>
+
+/**
+ * @brief Passing the listening socket from a running server to its
+ * replacement, so an upgrade never refuses connections.
+ *
+ * The running server listens on a Unix domain socket. A new server started
+ * with the same path connects to it and is sent the listening socket's
+ * descriptor (SCM_RIGHTS). Both processes then share the one socket: the new
+ * one starts accepting on it and the old one stops, letting its sessions
+ * finish their games first.
+ *
+ * @note Only supported on POSIX systems. Elsewhere every call fails.
+ */
+namespace io_blair::handoff {
+
+/**
+ * @brief Sends a duplicate of \p fd over the connected Unix domain socket \p socket.
+ *
+ * @param socket
+ * @param fd The descriptor to send. Stays open in the caller.
+ * @return true \p fd was sent.
+ * @return false
+ */
+bool send_fd(int socket, int fd);
+
+/**
+ * @brief Receives a descriptor sent with send_fd().
+ *
+ * @param socket
+ * @return int The received descriptor, or -1 on failure.
+ */
+int receive_fd(int socket);
+
+/**
+ * @brief Connects to the server listening for handoffs at \p path and
+ * receives its listening socket.
+ *
+ * @param path The handoff socket's path.
+ * @return int The listening socket, or -1 if no server handed it over.
+ */
+int request_listener(const std::string& path);
+
+}  // namespace io_blair::handoff
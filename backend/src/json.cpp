@@ -1,8 +1,13 @@
 #include "json.hpp"
 
+#include <array>
+#include <charconv>
+#include <cstring>
 #include <functional>
+#include <type_traits>
 
 #include "ihandler.hpp"
+#include "message.hpp"
 
 namespace io_blair::json {
 using rfl::AddStructName;
@@ -13,10 +18,18 @@ using std::optional;
 using std::string;
 using std::string_view;
 
-void decode(const string& data, IHandler& handler) {
-  if (auto res = rfl::json::read<json::in::AllJsonTypes>(data); res) {
-    (*res).visit([&](const auto& decoded) { std::ref(handler)(decoded); });
+DecodeResult decode(string_view data, IHandler& handler) {
+  auto res = rfl::json::read<json::in::AllJsonTypes>(data);
+  if (!res) {
+    return DecodeResult::kInvalid;
   }
+  return (*res).visit([&](const auto& decoded) {
+    if (data.size() > in::kMaxSize<std::decay_t<decltype(decoded)>>) {
+      return DecodeResult::kTooLarge;
+    }
+    std::ref(handler)(decoded);
+    return DecodeResult::kHandled;
+  });
 }
 
 namespace {
@@ -24,83 +37,205 @@ string encode(const auto& obj) {
   return rfl::json::write<AddStructName<"type">, SnakeCaseToCamelCase, NoOptionals>(obj);
 }
 
+// Encodes a field-less message once and shares the result for every later call.
+template <typename T>
+Message encode_once() {
+  static const Message msg = Message::make_static(encode(T{}));
+  return msg;
+}
+
 constexpr const char* kEmptyStr = "abc";
+
+// Enough room for any message written with Writer.
+constexpr std::size_t kWriterCapacity = 128;
+
+/**
+ * @brief Writes JSON straight into a Message's buffer, skipping the string
+ * rfl would otherwise build. Only used for hot messages made of numbers,
+ * booleans and enum names, which never need escaping. Output matches encode().
+ */
+class Writer {
+ public:
+  explicit Writer(char* out)
+      : begin_(out),
+        out_(out) {}
+
+  Writer& operator<<(string_view str) {
+    std::memcpy(out_, str.data(), str.size());
+    out_ += str.size();
+    return *this;
+  }
+
+  // Without this, string literals would pick the bool overload.
+  Writer& operator<<(const char* str) {
+    return *this << string_view(str);
+  }
+
+  Writer& operator<<(int num) {
+    // Room for the longest int, "-2147483648".
+    out_ = std::to_chars(out_, out_ + 11, num).ptr;
+    return *this;
+  }
+
+  Writer& operator<<(bool b) {
+    return *this << (b ? string_view("true") : string_view("false"));
+  }
+
+  Writer& operator<<(coordinate coordinate) {
+    return *this << "[" << coordinate.first << "," << coordinate.second << "]";
+  }
+
+  std::size_t size() const {
+    return static_cast<std::size_t>(out_ - begin_);
+  }
+
+ private:
+  char* begin_;
+  char* out_;
+};
+
+constexpr std::array<string_view, 4> kDirectionNames = {"up", "right", "down", "left"};
+constexpr std::array<string_view, 3> kCharacterNames = {"unknown", "Io", "Blair"};
 }  // namespace
 
 namespace out {
-string pong_msg() {
-  return encode(pong{});
+Message pong_msg() {
+  return encode_once<pong>();
 }
 
-string lobby_join(const optional<string_view>& code, optional<int> player_count,
-                  optional<Character> other_confirm) {
-  return encode(lobbyJoin{.success       = code.has_value(),
-                          .code          = code.value_or(kEmptyStr),
-                          .player_count  = player_count.value_or(0),
-                          .other_confirm = other_confirm.value_or(Character::unknown)});
+Message lobby_join(const optional<string_view>& code, optional<int> player_count,
+                   optional<Character> other_confirm, string_view resume_token) {
+  return Message(encode(lobbyJoin{.success       = code.has_value(),
+                                  .code          = code.value_or(kEmptyStr),
+                                  .player_count  = player_count.value_or(0),
+                                  .other_confirm = other_confirm.value_or(Character::unknown),
+                                  .resume_token  = resume_token}));
 }
 
-string lobby_other_join() {
-  return encode(lobbyOtherJoin{});
+Message lobby_resume(string_view code, string_view resume_token, int player_count,
+                     Character self, Character other, coordinate position,
+                     coordinate other_position) {
+  return Message(encode(lobbyResume{
+      .success        = true,
+      .code           = code,
+      .resume_token   = resume_token,
+      .player_count   = player_count,
+      .self           = self,
+      .other          = other,
+      .position       = {position.first, position.second},
+      .other_position = {other_position.first, other_position.second}
+  }));
 }
 
-string lobby_other_leave() {
-  return encode(lobbyOtherLeave{});
+Message lobby_resume_failed() {
+  static const Message msg = Message::make_static(encode(lobbyResume{
+      .success        = false,
+      .code           = "",
+      .resume_token   = "",
+      .player_count   = 0,
+      .self           = Character::unknown,
+      .other          = Character::unknown,
+      .position       = {},
+      .other_position = {}
+  }));
+  return msg;
 }
 
-string chat_msg(string_view msg) {
-  return encode(chat{msg});
+Message lobby_other_join() {
+  return encode_once<lobbyOtherJoin>();
 }
 
-string character_hover(Character character) {
-  return encode(characterHover{character});
+Message lobby_other_leave() {
+  return encode_once<lobbyOtherLeave>();
 }
 
-string character_confirm(Character character) {
+Message lobby_closed() {
+  return encode_once<lobbyClosed>();
+}
+
+Message chat_msg(string_view msg) {
+  return Message(encode(chat{msg}));
+}
+
+Message character_hover(Character character) {
+  return Message(encode(characterHover{character}));
+}
+
+Message character_confirm(Character character) {
   optional<Character> opt = character == Character::unknown ? nullopt : optional(character);
-  return encode(characterConfirm{opt});
+  return Message(encode(characterConfirm{opt}));
 }
 
-string transition_to_ingame() {
-  return encode(transitionToInGame{});
+Message transition_to_ingame() {
+  return encode_once<transitionToInGame>();
 }
 
-string ingame_maze(LobbyController::Maze maze, Character self, Character other) {
+Message ingame_maze(LobbyController::Maze maze, Character self, Character other) {
   const auto [startX, startY] = maze.start();
   const auto [endX, endY]     = maze.end();
-  return encode(inGameMaze{
+  return Message(encode(inGameMaze{
       .maze  = maze.serialize_for(self),
       .start = {startX, startY},
       .end   = {endX,   endY  },
       .cell  = maze.at(maze.start()).serialize_for(other)
-  });
+  }));
 }
 
-string character_move(coordinate coordinate, int16_t cell) {
-  const auto [x, y] = coordinate;
-  return encode(characterMove{
-      .coordinate = {x, y},
-        .cell = cell, .reset = false
+Message character_move(coordinate coordinate, int16_t cell) {
+  return Message::build(kWriterCapacity, [&](char* out) {
+    return (Writer(out) << R"({"type":"characterMove","coordinate":)" << coordinate
+                        << R"(,"cell":)" << cell << R"(,"reset":false})")
+        .size();
   });
 }
 
-string character_reset() {
-  return encode(characterMove{.coordinate = {}, .cell = 0, .reset = true});
+Message character_reset() {
+  static const Message msg
+      = Message::make_static(encode(characterMove{.coordinate = {}, .cell = 0, .reset = true}));
+  return msg;
 }
 
-string character_other_move(Direction direction, bool reset) {
-  return encode(characterOtherMove{.direction = direction, .reset = reset});
+Message character_other_move(Direction direction, bool reset) {
+  return Message::build(kWriterCapacity, [&](char* out) {
+    return (Writer(out) << R"({"type":"characterOtherMove","direction":")"
+                        << kDirectionNames[static_cast<std::size_t>(direction)]
+                        << R"(","reset":)" << reset << "}")
+        .size();
+  });
 }
 
-string coin_taken(coordinate coordinate) {
-  const auto [x, y] = coordinate;
-  return encode(coinTaken{
-      .coordinate = {x, y}
+Message coin_taken(coordinate coordinate) {
+  return Message::build(kWriterCapacity, [&](char* out) {
+    return (Writer(out) << R"({"type":"coinTaken","coordinate":)" << coordinate << "}").size();
   });
 }
 
-string transition_to_gamedone() {
-  return encode(transitionToGameDone{});
+Message transition_to_gamedone() {
+  return encode_once<transitionToGameDone>();
+}
+
+Message spectate_join(const optional<string_view>& code) {
+  return Message(encode(spectateJoin{.success = code.has_value(), .code = code.value_or("")}));
+}
+
+Message spectate_maze(const LobbyController::Maze& maze) {
+  const auto [startX, startY] = maze.start();
+  const auto [endX, endY]     = maze.end();
+  return Message(encode(spectateMaze{
+      .io    = maze.serialize_for(Character::Io),
+      .blair = maze.serialize_for(Character::Blair),
+      .start = {startX, startY},
+      .end   = {endX,   endY  }
+  }));
+}
+
+Message spectate_move(Character character, coordinate coordinate, bool reset) {
+  return Message::build(kWriterCapacity, [&](char* out) {
+    return (Writer(out) << R"({"type":"spectateMove","character":")"
+                        << kCharacterNames[static_cast<std::size_t>(character)]
+                        << R"(","coordinate":)" << coordinate << R"(,"reset":)" << reset << "}")
+        .size();
+  });
 }
 
 }  // namespace out
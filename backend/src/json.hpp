@@ -4,6 +4,7 @@
 #pragma once
 
 #include <array>
+#include <cstddef>
 #include <cstdint>
 #include <optional>
 #include <rfl/json.hpp>
@@ -13,6 +14,7 @@
 #include "character.hpp"
 #include "lobby/lobby_controller.hpp"
 #include "maze.hpp"
+#include "message.hpp"
 #include "rfl/Literal.hpp"
 
 namespace io_blair {
@@ -57,6 +59,18 @@ struct LobbyJoin {
   std::string code;
 };
 
+/**
+ * @brief Indicates the client wants to take back its place in a lobby
+ * after reconnecting.
+ */
+struct LobbyResume {
+  using Tag = rfl::Literal<"lobbyResume">;
+  /**
+   * @brief The resume token from the last lobbyJoin or lobbyResume.
+   */
+  std::string token;
+};
+
 /**
  * @brief Indicates the client wants to leave their lobby.
  */
@@ -110,27 +124,102 @@ struct NewGame {
   using Tag = rfl::Literal<"newGame">;
 };
 
+/**
+ * @brief Indicates the client wants to be paired with anyone else looking
+ * for a quick match.
+ */
+struct Matchmake {
+  using Tag = rfl::Literal<"matchmake">;
+  /**
+   * @brief The character the client would like to play. Either if unset.
+   */
+  std::optional<Character> character;
+};
+
+/**
+ * @brief Indicates the client no longer wants a quick match.
+ */
+struct MatchmakeCancel {
+  using Tag = rfl::Literal<"matchmakeCancel">;
+};
+
+/**
+ * @brief Indicates the client wants to watch a lobby without playing.
+ * Spectators leave with lobbyLeave.
+ */
+struct Spectate {
+  using Tag = rfl::Literal<"spectate">;
+  /**
+   * @brief The code for the lobby the client wants to watch.
+   */
+  std::string code;
+};
+
+/**
+ * @brief The exact encoding of Ping sent by clients. Sessions answer it
+ * without going through decode().
+ */
+inline constexpr std::string_view kPingMessage = R"({"type":"ping"})";
+
 /**
  * @brief A union of all possible structs.
  */
 using AllJsonTypes
-    = rfl::TaggedUnion<"type", Ping, LobbyCreate, LobbyJoin, LobbyLeave, Chat, CharacterHover,
-                       CharacterConfirm, CharacterMove, CheckWin, NewGame>;
+    = rfl::TaggedUnion<"type", Ping, LobbyCreate, LobbyJoin, LobbyResume, LobbyLeave, Chat,
+                       CharacterHover, CharacterConfirm, CharacterMove, CheckWin, NewGame,
+                       Matchmake, MatchmakeCancel, Spectate>;
+
+/**
+ * @brief The largest encoding accepted for a message of type T. Messages
+ * without free-form text are tiny, so anything much bigger is abuse.
+ */
+template <typename T>
+inline constexpr std::size_t kMaxSize = 256;
+
+template <>
+inline constexpr std::size_t kMaxSize<Chat> = 2048;
+
+/**
+ * @brief The largest encoding accepted for any message. Frames above this
+ * fail the websocket read before they are buffered.
+ */
+inline constexpr std::size_t kMaxMessageSize = kMaxSize<Chat>;
 
 }  // namespace in
 
+/**
+ * @brief The outcome of decode().
+ */
+enum class DecodeResult {
+  /**
+   * @brief The handler was called.
+   */
+  kHandled,
+  /**
+   * @brief The data wasn't one of the objects or wasn't valid JSON.
+   */
+  kInvalid,
+  /**
+   * @brief The data was larger than its type's in::kMaxSize.
+   */
+  kTooLarge,
+};
+
 /**
  * @brief Decodes JSON into one of the objects in json::in and
  * passes into the handler.
  * 
  * @param data The JSON to parse. If \p data wasn't convertible to
- * one of the objects or wasn't valid JSON, the handler isn't called.
+ * one of the objects, wasn't valid JSON or was too large for its
+ * type, the handler isn't called.
  * @param handler The handler that will receive the parsed object.
+ * @return DecodeResult
  */
-void decode(const std::string& data, IHandler& handler);
+DecodeResult decode(std::string_view data, IHandler& handler);
 
 /**
  * @brief All possible JSON structs the server may send to the client.
+ * Encoders return a Message that can be shared between sessions without copying.
  */
 namespace out {
 // NOLINTBEGIN(readability-identifier-naming)
@@ -140,7 +229,7 @@ namespace out {
  */
 struct pong {};
 
-std::string pong_msg();
+Message pong_msg();
 
 /**
  * @brief In response to the client trying to create/join a lobby.
@@ -150,16 +239,68 @@ struct lobbyJoin {
   std::string_view code;
   int player_count;
   Character other_confirm;
+  /**
+   * @brief Lets a new connection take this one's place with lobbyResume
+   * if this one drops.
+   */
+  std::string_view resume_token;
 };
 
 /**
- * @brief Encodes lobbyJoin as a string.
+ * @brief Encodes lobbyJoin as a Message.
  * 
  * @param code The lobby code. Passing nullopt means lobby joining failed.
- * @return std::string
+ * @param resume_token
+ * @return Message
  */
-std::string lobby_join(const std::optional<std::string_view>& code, std::optional<int> player_count,
-                       std::optional<Character> other_confirm);
+Message lobby_join(const std::optional<std::string_view>& code, std::optional<int> player_count,
+                   std::optional<Character> other_confirm, std::string_view resume_token = "");
+
+/**
+ * @brief In response to the client trying to resume. On success, the
+ * messages that bring the client to the lobby's current state follow,
+ * e.g. transitionToInGame and inGameMaze.
+ */
+struct lobbyResume {
+  bool success;
+  std::string_view code;
+  /**
+   * @brief Replaces the token used to resume, which is no longer valid.
+   */
+  std::string_view resume_token;
+  int player_count;
+  Character self;
+  Character other;
+  /**
+   * @brief Where the client is in the maze. inGameMaze places the client
+   * at the start, so this should be applied after it.
+   */
+  coordinate_arr position;
+  coordinate_arr other_position;
+};
+
+/**
+ * @brief Encodes a successful lobbyResume as a Message.
+ *
+ * @param code The lobby code.
+ * @param resume_token The client's new resume token.
+ * @param player_count
+ * @param self The client's character.
+ * @param other The other client's character.
+ * @param position The client's position.
+ * @param other_position The other client's position.
+ * @return Message
+ */
+Message lobby_resume(std::string_view code, std::string_view resume_token, int player_count,
+                     Character self, Character other, coordinate position,
+                     coordinate other_position);
+
+/**
+ * @brief Encodes a failed lobbyResume as a Message.
+ *
+ * @return Message
+ */
+Message lobby_resume_failed();
 
 /**
  * @brief Indicates another session has joined the lobby.
@@ -167,11 +308,11 @@ std::string lobby_join(const std::optional<std::string_view>& code, std::optiona
 struct lobbyOtherJoin {};
 
 /**
- * @brief Encodes lobbyOtherJoin as a string.
+ * @brief Encodes lobbyOtherJoin as a Message.
  *
- * @return std::string 
+ * @return Message
  */
-std::string lobby_other_join();
+Message lobby_other_join();
 
 /**
  * @brief Indicates the other session in the lobby has left.
@@ -179,11 +320,24 @@ std::string lobby_other_join();
 struct lobbyOtherLeave {};
 
 /**
- * @brief Encodes lobbyOtherLeave as a string.
+ * @brief Encodes lobbyOtherLeave as a Message.
  * 
- * @return std::string 
+ * @return Message
+ */
+Message lobby_other_leave();
+
+/**
+ * @brief Indicates the server closed the lobby, e.g. for sitting idle.
+ * The client is no longer in a lobby.
+ */
+struct lobbyClosed {};
+
+/**
+ * @brief Encodes lobbyClosed as a Message.
+ *
+ * @return Message
  */
-std::string lobby_other_leave();
+Message lobby_closed();
 
 /**
  * @brief Contains a message for the other client.
@@ -193,12 +347,12 @@ struct chat {
 };
 
 /**
- * @brief Encodes chat as a string.
+ * @brief Encodes chat as a Message.
  * 
  * @param msg The chat message to send.
- * @return std::string 
+ * @return Message
  */
-std::string chat_msg(std::string_view msg);
+Message chat_msg(std::string_view msg);
 
 /**
  * @brief Indicates the character hovered by the other client.
@@ -208,12 +362,12 @@ struct characterHover {
 };
 
 /**
- * @brief Encodes characterHover as a string.
+ * @brief Encodes characterHover as a Message.
  * 
  * @param character The character hovered.
- * @return std::string 
+ * @return Message
  */
-std::string character_hover(Character character);
+Message character_hover(Character character);
 
 /**
  * @brief Indicates the character confirmed by the other client.
@@ -223,12 +377,12 @@ struct characterConfirm {
 };
 
 /**
- * @brief Encodes characterConfirm as a string.
+ * @brief Encodes characterConfirm as a Message.
  * 
  * @param character The character confirmed.
- * @return std::string 
+ * @return Message
  */
-std::string character_confirm(Character character);
+Message character_confirm(Character character);
 
 /**
  * @brief Indicates transition to in-game state.
@@ -236,11 +390,11 @@ std::string character_confirm(Character character);
 struct transitionToInGame {};
 
 /**
- * @brief Encodes transitionToInGame as a string.
+ * @brief Encodes transitionToInGame as a Message.
  * 
- * @return std::string 
+ * @return Message
  */
-std::string transition_to_ingame();
+Message transition_to_ingame();
 
 /**
  * @brief Contains the serialized maze and start/end coordinates.
@@ -259,13 +413,13 @@ struct inGameMaze {
 };
 
 /**
- * @brief Encodes inGameMaze as a string.
+ * @brief Encodes inGameMaze as a Message.
  * 
  * @param maze
  * @param character The character to serialize maze for.
- * @return std::string 
+ * @return Message
  */
-std::string ingame_maze(LobbyController::Maze maze, Character self, Character other);
+Message ingame_maze(LobbyController::Maze maze, Character self, Character other);
 
 enum class Direction { up, right, down, left };
 
@@ -285,21 +439,21 @@ struct characterMove {
 };
 
 /**
- * @brief Encodes characterMove as a string.
+ * @brief Encodes characterMove as a Message.
  * 
  * @param coordinate 
  * @param cell 
- * @return std::string 
+ * @return Message
  */
-std::string character_move(coordinate coordinate, int16_t cell);
+Message character_move(coordinate coordinate, int16_t cell);
 
 /**
  * @brief Indicates the client needs to go back to
  * the start of the maze.
  * 
- * @return std::string 
+ * @return Message
  */
-std::string character_reset();
+Message character_reset();
 
 /**
  * @brief Indicates where the other client has moved.
@@ -316,13 +470,13 @@ struct characterOtherMove {
 };
 
 /**
- * @brief Encodes characterOtherMove as a string.
+ * @brief Encodes characterOtherMove as a Message.
  * 
  * @param direction
  * @param reset 
- * @return std::string 
+ * @return Message
  */
-std::string character_other_move(Direction direction, bool reset);
+Message character_other_move(Direction direction, bool reset);
 
 /**
  * @brief Indicates a coin has been taken.
@@ -335,12 +489,12 @@ struct coinTaken {
 };
 
 /**
- * @brief Encodes coinTaken as a string.
+ * @brief Encodes coinTaken as a Message.
  * 
  * @param coordinate The coordinate of the coin taken.
- * @return std::string 
+ * @return Message
  */
-std::string coin_taken(coordinate coordinate);
+Message coin_taken(coordinate coordinate);
 
 /**
  * @brief Indicates the game has finished.
@@ -348,11 +502,75 @@ std::string coin_taken(coordinate coordinate);
 struct transitionToGameDone {};
 
 /**
- * @brief Encodes inGameWin as a string.
+ * @brief Encodes inGameWin as a Message.
+ *
+ * @return Message
+ */
+Message transition_to_gamedone();
+
+/**
+ * @brief In response to the client trying to spectate a lobby. On success,
+ * the messages that bring the spectator to the lobby's current state follow,
+ * e.g. transitionToInGame, spectateMaze and spectateMove.
+ */
+struct spectateJoin {
+  bool success;
+  std::string_view code;
+};
+
+/**
+ * @brief Encodes spectateJoin as a Message.
+ *
+ * @param code The lobby code. Passing nullopt means spectating failed.
+ * @return Message
+ */
+Message spectate_join(const std::optional<std::string_view>& code);
+
+/**
+ * @brief Contains the serialized maze from both characters' perspectives,
+ * for spectators.
+ */
+struct spectateMaze {
+  using M = LobbyController::Maze;
+
+  std::array<std::array<int16_t, M::cols()>, M::rows()> io;
+  std::array<std::array<int16_t, M::cols()>, M::rows()> blair;
+  coordinate_arr start;
+  coordinate_arr end;
+};
+
+/**
+ * @brief Encodes spectateMaze as a Message.
+ *
+ * @param maze
+ * @return Message
+ */
+Message spectate_maze(const LobbyController::Maze& maze);
+
+/**
+ * @brief Indicates where a character moved, for spectators.
+ */
+struct spectateMove {
+  Character character;
+  /**
+   * @brief Where the character is now. The start if reset is true.
+   */
+  coordinate_arr coordinate;
+  /**
+   * @brief Whether they moved to their death.
+   */
+  bool reset;
+};
+
+/**
+ * @brief Encodes spectateMove as a Message.
  *
- * @return std::string 
+ * @param character The character that moved.
+ * @param coordinate Where the character is now.
+ * @param reset
+ * @return Message
  */
-std::string transition_to_gamedone();
+Message spectate_move(Character character, coordinate coordinate, bool reset);
 
 //NOLINTEND(readability-identifier-naming)
 }  // namespace out
@@ -0,0 +1,99 @@
+#include "code_allocator.hpp"
+
+#include <random>
+#include <stdexcept>
+
+
+namespace io_blair {
+namespace {
+// A cheap mixer for the Feistel round function. Not cryptographic, but
+// codes only need to be hard to enumerate, not secret.
+uint32_t mix(uint32_t half, uint64_t key) {
+  uint64_t z = (half ^ key) * 0x9E3779B97F4A7C15;
+  z          = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+  z          = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+  return static_cast<uint32_t>(z ^ (z >> 31)) & 0xFFFF;
+}
+
+CodeAllocator::Key random_key() {
+  std::random_device device;
+  CodeAllocator::Key key;
+  for (auto& round : key) {
+    round = (static_cast<uint64_t>(device()) << 32) | device();
+  }
+  return key;
+}
+}  // namespace
+
+CodeAllocator::CodeAllocator()
+    : CodeAllocator(random_key()) {}
+
+CodeAllocator::CodeAllocator(const Key& key)
+    : key_(key) {}
+
+std::string CodeAllocator::allocate() {
+  if (released_.size() > kQuarantine || (next_ == kCodeSpace && !released_.empty())) {
+    const uint32_t index = released_.front();
+    released_.pop_front();
+    return encode(index);
+  }
+
+  if (next_ == kCodeSpace) {
+    throw std::length_error("Every lobby code is in use");
+  }
+  return encode(permute(next_++));
+}
+
+void CodeAllocator::release(std::string_view code) {
+  if (const uint32_t index = decode(code); index < kCodeSpace) {
+    released_.push_back(index);
+  }
+}
+
+uint32_t CodeAllocator::permute(uint32_t i) const {
+  // The network permutes all 32-bit values. Walking the cycle until it lands
+  // back in range keeps it a permutation of just the codes. 36^6 is about half
+  // of 2^32, so this takes two passes on average.
+  do {
+    i = feistel(i);
+  } while (i >= kCodeSpace);
+  return i;
+}
+
+uint32_t CodeAllocator::feistel(uint32_t x) const {
+  uint32_t left  = x >> 16;
+  uint32_t right = x & 0xFFFF;
+  for (const uint64_t round : key_) {
+    const uint32_t next = left ^ mix(right, round);
+    left                = right;
+    right               = next;
+  }
+  return (left << 16) | right;
+}
+
+std::string CodeAllocator::encode(uint32_t index) {
+  std::string code(kCodeLength, kAlphabet[0]);
+  for (auto it = code.rbegin(); it != code.rend(); ++it) {
+    *it = kAlphabet[index % kAlphabet.size()];
+    index /= kAlphabet.size();
+  }
+  return code;
+}
+
+uint32_t CodeAllocator::decode(std::string_view code) {
+  if (code.size() != kCodeLength) {
+    return kCodeSpace;
+  }
+
+  uint32_t index = 0;
+  for (const char c : code) {
+    const auto digit = kAlphabet.find(c);
+    if (digit == std::string_view::npos) {
+      return kCodeSpace;
+    }
+    index = index * kAlphabet.size() + digit;
+  }
+  return index;
+}
+
+}  // namespace io_blair
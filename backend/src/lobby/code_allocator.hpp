@@ -0,0 +1,104 @@
+/**
+ * @file code_allocator.hpp
+ */
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+
+namespace io_blair {
+/**
+ * @brief Hands out unique lobby join codes in O(1) without checking which
+ * codes are taken.
+ *
+ * Codes come from a counter passed through a keyed permutation of every
+ * possible code, so consecutive codes look unrelated and never collide.
+ * Released codes are reused once kQuarantine more codes have been released
+ * after them, so a stale code doesn't lead straight into a new lobby.
+ *
+ * @note Not thread-safe.
+ */
+class CodeAllocator {
+ public:
+  /**
+   * @brief Characters per code.
+   */
+  static constexpr std::size_t kCodeLength = 6;
+
+  /**
+   * @brief Characters codes are made of.
+   */
+  static constexpr std::string_view kAlphabet = "1234567890ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+  /**
+   * @brief Number of distinct codes, 36^6.
+   */
+  static constexpr uint32_t kCodeSpace = 2'176'782'336;
+
+  /**
+   * @brief Number of released codes held back before any of them is reused.
+   */
+  static constexpr std::size_t kQuarantine = 4096;
+
+  /**
+   * @brief Rounds of the Feistel network behind the permutation.
+   */
+  static constexpr std::size_t kRounds = 4;
+
+  using Key = std::array<uint64_t, kRounds>;
+
+  /**
+   * @brief Construct a new CodeAllocator keyed from std::random_device.
+   */
+  CodeAllocator();
+
+  /**
+   * @brief Construct a new CodeAllocator with a fixed key. The same key
+   * always hands out codes in the same order.
+   *
+   * @param key
+   */
+  explicit CodeAllocator(const Key& key);
+
+  /**
+   * @brief Gets a code that isn't in use.
+   *
+   * @return std::string
+   * @throw std::length_error Every code is in use.
+   */
+  std::string allocate();
+
+  /**
+   * @brief Returns \p code for reuse. Must have come from allocate() and be
+   * released once. Codes that aren't valid are ignored.
+   *
+   * @param code
+   */
+  void release(std::string_view code);
+
+ private:
+  // Maps i in [0, kCodeSpace) to a unique index in the same range.
+  uint32_t permute(uint32_t i) const;
+
+  // One pass through the Feistel network, a permutation of all 32-bit values.
+  uint32_t feistel(uint32_t x) const;
+
+  static std::string encode(uint32_t index);
+
+  // Returns kCodeSpace if code isn't valid.
+  static uint32_t decode(std::string_view code);
+
+  const Key key_;
+
+  // How many fresh codes have been handed out.
+  uint32_t next_ = 0;
+
+  // Released codes, oldest first.
+  std::deque<uint32_t> released_;
+};
+
+}  // namespace io_blair
@@ -3,8 +3,10 @@
  */
 #pragma once
 
+#include <chrono>
 #include <memory>
 #include <optional>
+#include <string_view>
 
 #include "character.hpp"
 #include "isession.hpp"
@@ -74,8 +76,61 @@ class ILobbyController {
    */
   virtual void leave(const std::weak_ptr<ISession>& session) = 0;
 
+  /**
+   * @brief Holds \p session 's player for a new session instead of removing
+   * it. The other session isn't told anything. If \p session isn't in the
+   * lobby, nothing occurs.
+   *
+   * @param session The session that disconnected.
+   * @param deadline When the player is removed unless resumed.
+   */
+  virtual void suspend(const std::weak_ptr<ISession>& session,
+                       std::chrono::steady_clock::time_point deadline)
+      = 0;
+
+  /**
+   * @brief Attempts to put \p session in place of the suspended player
+   * holding \p token.
+   *
+   * @param session The session resuming.
+   * @param token The resume token given to the player's previous session.
+   * @return LobbyContext. The session took over the player.
+   * @return nullopt. No suspended player holds \p token.
+   */
+  virtual std::optional<LobbyContext> resume(std::weak_ptr<ISession> session,
+                                             std::string_view token)
+      = 0;
+
+  /**
+   * @brief Removes suspended players whose deadline has passed, as if their
+   * sessions had left.
+   *
+   * @param now
+   * @return int The number of players removed.
+   */
+  virtual int expire(std::chrono::steady_clock::time_point now) = 0;
+
+  /**
+   * @brief Attempts to add \p session as a spectator. Spectators receive
+   * game updates but don't take a player's place.
+   *
+   * @param session The session that wants to watch.
+   * @return true The session is spectating.
+   * @return false The lobby doesn't take spectators anymore.
+   */
+  virtual bool spectate(std::weak_ptr<ISession> session) = 0;
+
+  /**
+   * @brief Stops sending game updates to \p session. If \p session isn't
+   * spectating, nothing occurs.
+   *
+   * @param session The spectator leaving.
+   */
+  virtual void unspectate(const std::weak_ptr<ISession>& session) = 0;
+
   /**
    * @brief Determines whether the lobby has no sessions in it.
+   * Suspended players count as being in the lobby.
    * 
    * @return true The lobby is empty.
    * @return false The lobby isn't empty.
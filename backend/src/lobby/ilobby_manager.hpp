@@ -3,12 +3,17 @@
  */
 #pragma once
 
+#include <memory>
 #include <optional>
+#include <string_view>
 
+#include "character.hpp"
 #include "isession.hpp"
 #include "lobby_context.hpp"
 
 namespace io_blair {
+class MatchTicket;
+
 /**
  * @brief An interface for a lobby manager that allows sessions to create/join lobbies.
  */
@@ -43,6 +48,62 @@ class ILobbyManager {
    * @param code The join code identifying the lobby to leave.
    */
   virtual void leave(const std::weak_ptr<ISession>& session, std::string_view code) = 0;
+
+  /**
+   * @brief Holds \p session 's place in a preexisting lobby for a while so
+   * that a new session can resume it. If the session isn't in the lobby or
+   * the join code isn't associated with a lobby, nothing occurs.
+   *
+   * @param session The session that disconnected.
+   * @param code The join code identifying the lobby.
+   */
+  virtual void suspend(const std::weak_ptr<ISession>& session, std::string_view code) = 0;
+
+  /**
+   * @brief Attempts to place \p session where the suspended session that was
+   * given \p token was.
+   *
+   * @param session The session trying to resume.
+   * @param token The resume token the client was given.
+   * @return std::optional<LobbyContext>. Context on the lobby resumed
+   * or std::nullopt if the token is unknown or expired.
+   */
+  virtual std::optional<LobbyContext> resume(std::weak_ptr<ISession> session,
+                                             std::string_view token)
+      = 0;
+
+  /**
+   * @brief Attempts to add \p session as a spectator of a preexisting lobby.
+   *
+   * @param session The session that wants to watch.
+   * @param code The join code identifying the lobby to watch.
+   * @return true The session is spectating.
+   * @return false The lobby couldn't be found or is closed.
+   */
+  virtual bool spectate(std::weak_ptr<ISession> session, std::string_view code) = 0;
+
+  /**
+   * @brief Stops \p session from spectating a lobby. If the session isn't
+   * spectating it or the join code isn't associated with a lobby, nothing occurs.
+   *
+   * @param session The spectator leaving.
+   * @param code The join code identifying the lobby.
+   */
+  virtual void unspectate(const std::weak_ptr<ISession>& session, std::string_view code) = 0;
+
+  /**
+   * @brief Queues \p session to be paired with another session looking for a
+   * quick match. Once paired, both are placed in a new lobby and sent
+   * SessionEvent::kMatchFound. Safe to call from any thread.
+   *
+   * @param session The session looking for a match.
+   * @param preference The character the session would like to play, or
+   * Character::unknown for either.
+   * @return std::shared_ptr<MatchTicket>. The session's place in the queue.
+   */
+  virtual std::shared_ptr<MatchTicket> matchmake(std::weak_ptr<ISession> session,
+                                                 Character preference)
+      = 0;
 };
 
 }  // namespace io_blair
@@ -1,14 +1,24 @@
 #include "lobby_controller.hpp"
 
+#include <bitset>
+#include <chrono>
+#include <cstdint>
 #include <memory>
 #include <mutex>
 #include <optional>
+#include <random>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 #include "character.hpp"
 #include "event.hpp"
 #include "json.hpp"
 #include "maze.hpp"
+#include "metrics.hpp"
+#include "replay_writer.hpp"
 #include "session_controller.hpp"
+#include "trace.hpp"
 
 
 namespace io_blair {
@@ -17,14 +27,24 @@ using std::make_unique;
 using std::nullopt;
 using std::optional;
 using std::string;
+using std::string_view;
 using std::weak_ptr;
-using guard    = std::lock_guard<std::recursive_mutex>;
+using guard      = std::lock_guard<std::recursive_mutex>;
+using time_point = std::chrono::steady_clock::time_point;
 namespace jout = json::out;
 
 namespace {
 constexpr coordinate kMazeStart = {1, 4};
 constexpr coordinate kMazeEnd   = {4, 1};
 
+// Separates the lobby code from the random part of a resume token.
+constexpr char kResumeTokenSeparator = '.';
+
+// Determines whether player holds a seat in the lobby, even if its session is away.
+int occupied(const Player& player) {
+  return static_cast<int>(player.exists() || player.suspended());
+}
+
 // Gets the direction start needs to move to reach end.
 // Returns nullopt if coordinates aren't cardinal direction neighbors.
 constexpr optional<jout::Direction> to_dir(coordinate start, coordinate end) {
@@ -51,34 +71,94 @@ constexpr optional<jout::Direction> to_dir(coordinate start, coordinate end) {
 
   return nullopt;
 }
+
+// Rebuilds the maze saved in image.
+LobbyController::Maze restore_maze(const LobbyImage& image) {
+  using Maze = LobbyController::Maze;
+  static_assert(Maze::rows() * Maze::cols() <= LobbyImage::kMaxCells);
+
+  Maze::matrix<Cell> cells;
+  for (int row = 0; row < Maze::rows(); ++row) {
+    for (int col = 0; col < Maze::cols(); ++col) {
+      cells[row][col] = Cell(std::bitset<9>(image.cells[row * Maze::cols() + col]));
+    }
+  }
+  return Maze(kMazeStart, kMazeEnd, cells);
+}
 }  // namespace
 
 LobbyController::LobbyController(string code)
-    : code_(std::move(code)), maze_(kMazeStart, kMazeEnd) {
+    : code_(std::move(code)),
+      maze_(kMazeStart, kMazeEnd),
+      last_activity_(std::chrono::steady_clock::now()) {
   static_assert(Maze::in_range(kMazeStart));
   static_assert(Maze::in_range(kMazeEnd));
 }
 
-optional<LobbyContext> LobbyController::join(weak_ptr<ISession> session) {
-  guard lock(mutex_);
+LobbyController::LobbyController(const LobbyImage& image, time_point deadline)
+    : code_(LobbyImage::get(image.code)),
+      maze_(restore_maze(image)),
+      last_activity_(std::chrono::steady_clock::now()) {
+  for (int i = 0; i < 2; ++i) {
+    const LobbyImage::Seat& seat = image.seats[i];
+    Player& player               = i == 0 ? p1_ : p2_;
+    if (!seat.occupied) {
+      continue;
+    }
+    player.character    = seat.character;
+    player.position     = {seat.x, seat.y};
+    player.resume_token = LobbyImage::get(seat.resume_token);
+    player.suspend(deadline);
+  }
+}
 
-  if (p1_.try_set(session)) {
-    const int player_count = static_cast<int>(p1_.exists()) + static_cast<int>(p2_.exists());
-    p1_.send(jout::lobby_join(code_, player_count, p2_.character));
-    p2_.send(jout::lobby_other_join());
+bool LobbyController::save(LobbyImage& image) const {
+  guard lock(mutex_);
 
-    return LobbyContext{code_, p2_.session(), make_unique<SessionController>(p1_, p2_, *this)};
+  if (!LobbyImage::put(image.code, code_)) {
+    return false;
+  }
+  for (int i = 0; i < 2; ++i) {
+    LobbyImage::Seat& seat = image.seats[i];
+    const Player& player   = i == 0 ? p1_ : p2_;
+    seat.occupied          = static_cast<uint8_t>(occupied(player));
+    seat.character         = player.character;
+    seat.x                 = static_cast<int8_t>(player.position.first);
+    seat.y                 = static_cast<int8_t>(player.position.second);
+    if (!LobbyImage::put(seat.resume_token, player.resume_token)) {
+      return false;
+    }
   }
+  for (int row = 0; row < Maze::rows(); ++row) {
+    for (int col = 0; col < Maze::cols(); ++col) {
+      image.cells[row * Maze::cols() + col] = maze_.at(row, col).bits();
+    }
+  }
+  return true;
+}
+
+optional<LobbyContext> LobbyController::join(weak_ptr<ISession> session) {
+  guard lock(mutex_);
 
-  if (p2_.try_set(session)) {
-    const int player_count = static_cast<int>(p1_.exists()) + static_cast<int>(p2_.exists());
-    p2_.send(jout::lobby_join(code_, player_count, p1_.character));
-    p1_.send(jout::lobby_other_join());
+  if (auto ctx = join_as(p1_, p2_, session)) {
+    return ctx;
+  }
+  return join_as(p2_, p1_, session);
+}
 
-    return LobbyContext{code_, p1_.session(), make_unique<SessionController>(p2_, p1_, *this)};
+optional<LobbyContext> LobbyController::join_as(Player& self, Player& other,
+                                                const weak_ptr<ISession>& session) {
+  if (closed_ || !self.try_set(session)) {
+    return nullopt;
   }
+  touch();
 
-  return nullopt;
+  self.resume_token      = make_resume_token();
+  const int player_count = occupied(self) + occupied(other);
+  self.send(jout::lobby_join(code_, player_count, other.character, self.resume_token));
+  other.send(jout::lobby_other_join());
+
+  return LobbyContext{code_, other.session(), make_unique<SessionController>(self, other, *this)};
 }
 
 void LobbyController::leave(const weak_ptr<ISession>& session) {
@@ -86,31 +166,276 @@ void LobbyController::leave(const weak_ptr<ISession>& session) {
   auto sess = session.lock();
 
   if (sess == p1_) {
-    p1_.reset(true);
+    remove(p1_, p2_);
+    return;
+  }
 
-    p2_.reset(false);
-    p2_.send(jout::lobby_other_leave());
-    p2_.send(SessionEvent::kTransitionToCharacterSelect);
+  if (sess == p2_) {
+    remove(p2_, p1_);
+    return;
+  }
+}
+
+void LobbyController::remove(Player& self, Player& other) {
+  self.reset(true);
+  touch();
+  end_recording();
+  if (closed_) {
+    // Other was told the lobby closed and is leaving too.
+    return;
+  }
+
+  other.reset(false);
+  other.send(jout::lobby_other_leave());
+  other.send(SessionEvent::kTransitionToCharacterSelect);
+}
+
+void LobbyController::suspend(const weak_ptr<ISession>& session, time_point deadline) {
+  guard lock(mutex_);
+  auto sess = session.lock();
+
+  if (sess == p1_) {
+    p1_.suspend(deadline);
     return;
   }
 
   if (sess == p2_) {
-    p2_.reset(true);
+    p2_.suspend(deadline);
+    return;
+  }
+}
+
+optional<LobbyContext> LobbyController::resume(weak_ptr<ISession> session, string_view token) {
+  guard lock(mutex_);
 
-    p1_.reset(false);
-    p1_.send(jout::lobby_other_leave());
-    p1_.send(SessionEvent::kTransitionToCharacterSelect);
+  if (closed_) {
+    return nullopt;
+  }
+
+  if (p1_.suspended() && p1_.resume_token == token) {
+    return resume_as(p1_, p2_, std::move(session));
+  }
+
+  if (p2_.suspended() && p2_.resume_token == token) {
+    return resume_as(p2_, p1_, std::move(session));
+  }
+
+  return nullopt;
+}
+
+LobbyContext LobbyController::resume_as(Player& self, Player& other, weak_ptr<ISession> session) {
+  self.resume(std::move(session));
+  touch();
+  // Tokens are single use so a leaked one can't take the player over later.
+  self.resume_token      = make_resume_token();
+  const int player_count = occupied(self) + occupied(other);
+  self.send(jout::lobby_resume(code_, self.resume_token, player_count, self.character,
+                               other.character, self.position, other.position));
+
+  // Replay the transitions the new session missed. A game is running once
+  // both characters are set.
+  if (self.character != Character::unknown && other.character != Character::unknown) {
+    self.send(jout::transition_to_ingame());
+    self.send(SessionEvent::kTransitionToInGame);
+    self.send(jout::ingame_maze(maze_, self.character, other.character));
+
+    if (finished()) {
+      self.send(jout::transition_to_gamedone());
+      self.send(SessionEvent::kTransitionToGameDone);
+    }
+  }
+
+  return LobbyContext{code_, other.session(), make_unique<SessionController>(self, other, *this)};
+}
+
+template <typename Edit>
+void LobbyController::update_spectators(Edit&& edit) {
+  if (!spectators_) {
+    spectators_ = std::make_shared<Spectators>();
+  } else if (spectators_.use_count() > 1) {
+    // Copies only ever let go of it, so none can pick it up meanwhile.
+    spectators_ = std::make_shared<Spectators>(*spectators_);
+  }
+  edit(*spectators_);
+}
+
+template <typename Encode>
+void LobbyController::publish(Encode&& encode) {
+  if (spectators_ && !spectators_->empty()) {
+    unpublished_.push_back(std::forward<Encode>(encode)());
+  }
+}
+
+LobbyController::PublishLock::PublishLock(LobbyController& lobby,
+                                          std::unique_lock<std::recursive_mutex> lock)
+    : lobby_(lobby), lock_(std::move(lock)) {
+  ++lobby_.publish_locks_;
+}
+
+LobbyController::PublishLock::~PublishLock() {
+  if (--lobby_.publish_locks_ > 0 || lobby_.unpublished_.empty()) {
     return;
   }
+  std::vector<Message> messages;
+  messages.swap(lobby_.unpublished_);
+  const std::shared_ptr<const Spectators> spectators = lobby_.spectators_;
+  lock_.unlock();
+
+  for (const Message& msg : messages) {
+    for (const auto& spectator : *spectators) {
+      if (const auto sess = spectator.lock()) {
+        sess->async_send(msg);
+      }
+    }
+  }
+}
+
+bool LobbyController::spectate(weak_ptr<ISession> session) {
+  guard lock(mutex_);
+
+  const auto sess = session.lock();
+  if (!sess) {
+    return false;
+  }
+  if (closed_) {
+    sess->async_send(jout::spectate_join(nullopt));
+    return false;
+  }
+
+  // Holding mutex_ keeps updates from reaching the spectator before it's resynced.
+  update_spectators([&](Spectators& spectators) { spectators.push_back(session); });
+  Metrics::instance().spectators_active.inc();
+
+  sess->async_send(jout::spectate_join(code_));
+  resync_spectator(*sess);
+  return true;
+}
+
+void LobbyController::unspectate(const weak_ptr<ISession>& session) {
+  // Compare owners so spectators that already closed can still be found.
+  const auto same = [&](const weak_ptr<ISession>& spectator) {
+    return !spectator.owner_before(session) && !session.owner_before(spectator);
+  };
+
+  guard lock(mutex_);
+  bool removed = false;
+  update_spectators([&](Spectators& spectators) { removed = std::erase_if(spectators, same) > 0; });
+  if (removed) {
+    Metrics::instance().spectators_active.dec();
+  }
+}
+
+std::size_t LobbyController::spectators() const {
+  guard lock(mutex_);
+  return spectators_ ? spectators_->size() : 0;
+}
+
+void LobbyController::resync_spectator(ISession& session) const {
+  // Like resume_as, a game is running once both characters are set.
+  if (p1_.character == Character::unknown || p2_.character == Character::unknown) {
+    return;
+  }
+
+  session.async_send(jout::transition_to_ingame());
+  session.async_send(jout::spectate_maze(maze_));
+  for (const Player* player : {&p1_, &p2_}) {
+    session.async_send(jout::spectate_move(player->character, player->position, false));
+  }
+
+  if (finished()) {
+    session.async_send(jout::transition_to_gamedone());
+  }
+}
+
+int LobbyController::expire(time_point now) {
+  guard lock(mutex_);
+
+  int removed = 0;
+  if (p1_.expired(now)) {
+    remove(p1_, p2_);
+    ++removed;
+  }
+  if (p2_.expired(now)) {
+    remove(p2_, p1_);
+    ++removed;
+  }
+  return removed;
 }
 
 bool LobbyController::empty() const {
+  return players() == 0;
+}
+
+int LobbyController::players() const {
   guard lock(mutex_);
-  return !p1_.exists() && !p2_.exists();
+  return occupied(p1_) + occupied(p2_);
 }
 
-void LobbyController::set_character(Player& self, Player& other, Character character) {
+std::chrono::steady_clock::time_point LobbyController::last_activity() const {
+  guard lock(mutex_);
+  return last_activity_;
+}
+
+void LobbyController::close() {
+  std::unique_lock lock(mutex_);
+
+  closed_ = true;
+  end_recording();
+  for (Player* player : {&p1_, &p2_}) {
+    if (player->suspended()) {
+      player->reset(true);
+    } else if (player->exists()) {
+      player->send(jout::lobby_closed());
+      player->send(SessionEvent::kLobbyClosed);
+    }
+  }
+
+  // Sent after unlocking, like published messages.
+  if (const auto spectators = std::exchange(spectators_, nullptr)) {
+    lock.unlock();
+    for (const auto& spectator : *spectators) {
+      if (const auto sess = spectator.lock()) {
+        sess->async_send(jout::lobby_closed());
+        sess->async_handle(SessionEvent::kLobbyClosed);
+      }
+    }
+    Metrics::instance().spectators_active.dec(static_cast<int64_t>(spectators->size()));
+  }
+}
+
+bool LobbyController::closed() const {
   guard lock(mutex_);
+  return closed_;
+}
+
+void LobbyController::touch() {
+  last_activity_ = std::chrono::steady_clock::now();
+}
+
+string_view LobbyController::resume_token_code(string_view token) {
+  return token.substr(0, token.find(kResumeTokenSeparator));
+}
+
+string LobbyController::make_resume_token() const {
+  static constexpr char kHexDigits[] = "0123456789abcdef";
+  static constexpr int kWords        = 4;
+
+  // Tokens grant a seat in the lobby, so draw them from the OS rather than a seeded PRNG.
+  thread_local std::random_device device;
+
+  string token = code_;
+  token.push_back(kResumeTokenSeparator);
+  for (int i = 0; i < kWords; ++i) {
+    uint32_t bits = device();
+    for (int j = 0; j < 8; ++j, bits >>= 4) {
+      token.push_back(kHexDigits[bits & 0xF]);
+    }
+  }
+  return token;
+}
+
+void LobbyController::set_character(Player& self, Player& other, Character character) {
+  PublishLock lock(*this, std::unique_lock(mutex_));
 
   // Self is already character
   if (character == self.character) {
@@ -122,6 +447,7 @@ void LobbyController::set_character(Player& self, Player& other, Character chara
   }
 
   self.character = character;
+  touch();
   other.send(jout::character_confirm(character));
 
   // If either hasn't chosen a character, don't transition to game yet.
@@ -133,57 +459,100 @@ void LobbyController::set_character(Player& self, Player& other, Character chara
 }
 
 void LobbyController::move_character(Player& self, Player& other, coordinate coordinate) {
-  guard lock(mutex_);
+  PublishLock lock(*this, traced_lock());
 
   bool traversable = maze_.traversable(self.position, coordinate);
-
-  self.send(traversable ? jout::character_move(coordinate,
-                                               maze_.at(coordinate).serialize_for(other.character))
-                        : jout::character_reset());
-  other.send(jout::character_other_move(*to_dir(self.position, coordinate), !traversable));
+  touch();
+
+  Message self_msg;
+  Message other_msg;
+  {
+    trace::Span span("encode");
+    self_msg  = traversable ? jout::character_move(
+                                 coordinate, maze_.at(coordinate).serialize_for(other.character))
+                            : jout::character_reset();
+    other_msg = jout::character_other_move(*to_dir(self.position, coordinate), !traversable);
+  }
+  self.send(std::move(self_msg));
+  other.send(std::move(other_msg));
 
   self.position = traversable ? coordinate : kMazeStart;
+  publish([&] { return jout::spectate_move(self.character, self.position, !traversable); });
+  recorder_.record(traversable ? replay::EventKind::kMove : replay::EventKind::kReset, seat(self),
+                   coordinate);
 
   if (traversable && maze_.at(coordinate).coin()) {
     maze_.take_coin(coordinate);
-    broadcast(make_shared<const string>(jout::coin_taken(coordinate)));
+    recorder_.record(replay::EventKind::kCoin, seat(self), coordinate);
+    broadcast(jout::coin_taken(coordinate));
   }
 
+  // Recorded on the move that finishes the game rather than on checkWin,
+  // which a player may leave before sending.
+  if (finished() && recorder_.recording()) {
+    recorder_.record(replay::EventKind::kFinish, 0, maze_.end());
+    end_recording();
+  }
   check_win();
 }
 
 void LobbyController::check_win() {
-  guard lock(mutex_);
+  PublishLock lock(*this, std::unique_lock(mutex_));
 
-  if (p1_.position != maze_.end() || p2_.position != maze_.end() || maze_.any_coin()) {
+  if (!finished()) {
     return;
   }
-  broadcast(make_shared<const string>(jout::transition_to_gamedone()));
+  broadcast(jout::transition_to_gamedone());
   broadcast(SessionEvent::kTransitionToGameDone);
 }
 
+bool LobbyController::finished() const {
+  return p1_.position == maze_.end() && p2_.position == maze_.end() && !maze_.any_coin();
+}
+
 void LobbyController::new_game() {
-  guard lock(mutex_);
+  PublishLock lock(*this, std::unique_lock(mutex_));
+  touch();
 
-  broadcast(make_shared<const string>(jout::transition_to_ingame()));
+  broadcast(jout::transition_to_ingame());
   broadcast(SessionEvent::kTransitionToInGame);
 
+  end_recording();
   maze_.randomize();
   p1_.position = kMazeStart;
   p2_.position = kMazeStart;
+  if (replay::Writer::instance().recording()) {
+    recorder_.begin(maze_, p1_.character, p2_.character);
+  }
 
   p1_.send(jout::ingame_maze(maze_, p1_.character, p2_.character));
   p2_.send(jout::ingame_maze(maze_, p2_.character, p1_.character));
+  publish([&] { return jout::spectate_maze(maze_); });
+}
+
+uint8_t LobbyController::seat(const Player& player) const {
+  return &player == &p1_ ? 0 : 1;
 }
 
+void LobbyController::end_recording() {
+  if (recorder_.recording()) {
+    replay::Writer::instance().submit(recorder_.finish());
+  }
+}
 
-void LobbyController::broadcast(std::shared_ptr<const std::string> msg) {
+void LobbyController::broadcast(Message msg) {
   guard lock(mutex_);
 
+  publish([&] { return msg; });
   p1_.send(msg);
   p2_.send(std::move(msg));
 }
 
+std::unique_lock<std::recursive_mutex> LobbyController::traced_lock() const {
+  trace::Span span("lobby_lock_wait");
+  return std::unique_lock(mutex_);
+}
+
 void LobbyController::broadcast(SessionEvent ev) {
   guard lock(mutex_);
 
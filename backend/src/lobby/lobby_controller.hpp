@@ -3,18 +3,26 @@
  */
 #pragma once
 
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <mutex>
 #include <optional>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include "character.hpp"
 #include "event.hpp"
 #include "ilobby_controller.hpp"
 #include "isession.hpp"
 #include "lobby_context.hpp"
+#include "lobby_snapshot.hpp"
 #include "maze.hpp"
+#include "message.hpp"
 #include "player.hpp"
+#include "replay.hpp"
 
 
 namespace io_blair {
@@ -32,6 +40,24 @@ class LobbyController : public ILobbyController {
    */
   explicit LobbyController(std::string code);
 
+  /**
+   * @brief Restores a lobby saved by save(). Its players are held as if
+   * suspended until \p deadline so their sessions can resume them.
+   *
+   * @param image The saved lobby.
+   * @param deadline When the players are removed unless resumed.
+   */
+  LobbyController(const LobbyImage& image, std::chrono::steady_clock::time_point deadline);
+
+  /**
+   * @brief Saves the lobby's players, characters, positions and maze into \p image.
+   *
+   * @param image
+   * @return true The lobby was saved.
+   * @return false The lobby's code or a resume token was too long to save.
+   */
+  bool save(LobbyImage& image) const;
+
   /**
    * @brief Tries to place \p session into the lobby. The session
    * will be sent a json::out::lobbyJoin object with the result. The other
@@ -53,6 +79,59 @@ class LobbyController : public ILobbyController {
    */
   void leave(const std::weak_ptr<ISession>& session) override;
 
+  /**
+   * @brief Holds \p session 's player until \p deadline so a new session
+   * can resume it. Does nothing if session isn't in this lobby.
+   *
+   * @param session The session that disconnected.
+   * @param deadline When the player is removed unless resumed.
+   */
+  void suspend(const std::weak_ptr<ISession>& session,
+               std::chrono::steady_clock::time_point deadline) override;
+
+  /**
+   * @brief Puts \p session in place of the suspended player holding
+   * \p token. The session is sent a json::out::lobbyResume followed by the
+   * messages that bring it to the lobby's current state, and the player is
+   * given a new token. The session is sent nothing on failure.
+   *
+   * @param session The session resuming.
+   * @param token The resume token given to the player's previous session.
+   * @return std::optional<LobbyContext> The context of the lobby if resuming
+   * was successful, otherwise nullopt.
+   */
+  std::optional<LobbyContext> resume(std::weak_ptr<ISession> session,
+                                     std::string_view token) override;
+
+  /**
+   * @brief Removes suspended players whose deadline has passed. The other
+   * session is sent json::out::lobbyOtherLeave as in leave().
+   *
+   * @param now
+   */
+  int expire(std::chrono::steady_clock::time_point now) override;
+
+  /**
+   * @brief Adds \p session as a spectator. The session is sent a
+   * json::out::spectateJoin with the result, followed on success by the
+   * messages that bring it to the lobby's current state. Fails once the
+   * lobby is closed.
+   *
+   * @param session The session that wants to watch.
+   * @return true The session is spectating.
+   * @return false The lobby is closed.
+   */
+  bool spectate(std::weak_ptr<ISession> session) override;
+
+  void unspectate(const std::weak_ptr<ISession>& session) override;
+
+  /**
+   * @brief Gets the number of spectators.
+   *
+   * @return std::size_t
+   */
+  std::size_t spectators() const;
+
   /**
    * @brief Determines if the lobby has any existing players.
    * 
@@ -91,24 +170,137 @@ class LobbyController : public ILobbyController {
    */
   void new_game() override;
 
+  /**
+   * @brief Gets the number of players in the lobby, counting suspended ones.
+   *
+   * @return int
+   */
+  int players() const;
+
+  /**
+   * @brief Gets when a player last joined, left or played.
+   *
+   * @return std::chrono::steady_clock::time_point
+   */
+  std::chrono::steady_clock::time_point last_activity() const;
+
+  /**
+   * @brief Closes the lobby. Connected sessions and spectators are sent
+   * json::out::lobbyClosed and SessionEvent::kLobbyClosed so they leave, and
+   * suspended players are dropped. Nobody can join or resume afterwards, and leaving no longer
+   * notifies the other player.
+   */
+  void close();
+
+  /**
+   * @brief Determines whether close() was called.
+   *
+   * @return true
+   * @return false
+   */
+  bool closed() const;
+
+  /**
+   * @brief Gets the join code of the lobby that issued \p token.
+   *
+   * @param token A resume token.
+   * @return std::string_view
+   */
+  static std::string_view resume_token_code(std::string_view token);
+
   /**
    * @brief The lobby's join code.
    */
   const std::string code_;
 
  private:
-  // Sends msg to both players.
-  void broadcast(std::shared_ptr<const std::string> msg);
+  // Tries to place session as self. Sends the join messages on success.
+  std::optional<LobbyContext> join_as(Player& self, Player& other,
+                                      const std::weak_ptr<ISession>& session);
+
+  // Removes self and sends other back to character select.
+  void remove(Player& self, Player& other);
+
+  // Attaches session to the suspended self and resyncs it.
+  LobbyContext resume_as(Player& self, Player& other, std::weak_ptr<ISession> session);
+
+  // Gets a new unguessable token that names this lobby.
+  std::string make_resume_token() const;
+
+  // Records that a player did something.
+  void touch();
+
+  // Determines whether both players finished the maze.
+  bool finished() const;
+
+  // Gets the replay seat of player.
+  uint8_t seat(const Player& player) const;
+
+  // Hands the game being recorded, if any, to the replay writer.
+  void end_recording();
+
+  // Sends msg to both players and every spectator.
+  void broadcast(Message msg);
+
+  // Queues the Message returned by encode for every spectator. encode is only
+  // called if there are spectators, and only once, so every spectator is sent
+  // the same payload. Must be called under a PublishLock.
+  template <typename Encode>
+  void publish(Encode&& encode);
+
+  // Sends the spectator the messages that bring it to the lobby's current state.
+  void resync_spectator(ISession& session) const;
+
+  using Spectators = std::vector<std::weak_ptr<ISession>>;
+
+  // Applies edit to spectators_, first copying it if a PublishLock is still
+  // sending to it. Must hold mutex_.
+  template <typename Edit>
+  void update_spectators(Edit&& edit);
+
+  // Locks mutex_ for a call that may publish(). Once the outermost one is
+  // released, what was published is sent to the spectators there were at
+  // the time, after unlocking, so moves don't wait on the sends.
+  class PublishLock {
+   public:
+    PublishLock(LobbyController& lobby, std::unique_lock<std::recursive_mutex> lock);
+    ~PublishLock();
+
+    PublishLock(const PublishLock&)            = delete;
+    PublishLock& operator=(const PublishLock&) = delete;
+
+   private:
+    LobbyController& lobby_;
+    std::unique_lock<std::recursive_mutex> lock_;
+  };
 
   // Sends event to both players.
   void broadcast(SessionEvent);
 
+  // Locks mutex_, tracing how long acquiring it took.
+  std::unique_lock<std::recursive_mutex> traced_lock() const;
+
   mutable std::recursive_mutex mutex_;
 
   Player p1_;
   Player p2_;
 
   Maze maze_;
+
+  // Records the current game while the replay writer is started.
+  replay::GameRecorder recorder_;
+
+  std::chrono::steady_clock::time_point last_activity_;
+
+  bool closed_ = false;
+
+  // Shared with PublishLocks sending to it, which copy it out under mutex_.
+  // Copied on write only while one of them still holds it.
+  std::shared_ptr<Spectators> spectators_;
+
+  // Messages published under the PublishLocks held, and how many are held.
+  std::vector<Message> unpublished_;
+  int publish_locks_ = 0;
 };
 
 }  // namespace io_blair
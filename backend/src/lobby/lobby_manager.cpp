@@ -1,37 +1,93 @@
 #include "lobby_manager.hpp"
 
-#include <algorithm>
-#include <cstring>
 #include <json.hpp>
-#include <random>
+
+#include <cstdio>
+#include <span>
+#include <string>
+
+#include "logging.hpp"
+#include "metrics.hpp"
 
 
 namespace io_blair {
-using std::mt19937;
 using std::nullopt;
 using std::optional;
-using std::random_device;
 using std::string;
 using std::string_view;
-using std::strlen;
-using std::uniform_int_distribution;
 using std::weak_ptr;
-using guard    = std::lock_guard<std::recursive_mutex>;
-namespace jout = json::out;
+using guard      = std::lock_guard<std::recursive_mutex>;
+using time_point = std::chrono::steady_clock::time_point;
+namespace jout   = json::out;
+
+namespace {
+// Gets the id of session for logging, or 0 if it expired.
+uint64_t session_id(const weak_ptr<ISession>& session) {
+  const auto sess = session.lock();
+  return sess ? sess->id() : 0;
+}
+
+// How often lobbies without a timeout are checked for being empty.
+constexpr auto kUntimedReapInterval = std::chrono::minutes(1);
+}  // namespace
+
+LobbyManager::LobbyManager(LobbyOptions options)
+    : options_(options),
+      timers_(kTimerResolution),
+      matchmaker_([this](MatchTicket& a, MatchTicket& b) { on_match(a, b); }) {}
 
 LobbyContext LobbyManager::create(weak_ptr<ISession> session) {
   guard lock(mutex_);
 
-  string code = generate_code();
-
-  auto [it, _] = lobbies_.try_emplace(code, code);
+  const auto it = open();
+  logging::info("Lobby created", {.session = session_id(session), .lobby = it->second.code_});
   return *it->second.join(std::move(session));
 }
 
+LobbyManager::LobbyMap::iterator LobbyManager::open() {
+  string code = codes_.allocate();
+  // Codes from before a restart may still be in use or waiting to be restored.
+  while (lobbies_.contains(code) || restorable_.contains(code)) {
+    code = codes_.allocate();
+  }
+
+  auto [it, _]         = lobbies_.try_emplace(code, code);
+  it->second.generation = ++generations_;
+  Metrics::instance().lobbies_active.inc();
+  schedule(std::chrono::steady_clock::now() + options_.half_empty_timeout, Timer::Kind::kReap, it);
+  return it;
+}
+
+LobbyManager::LobbyMap::iterator LobbyManager::find(string_view code) {
+  if (const auto it = lobbies_.find(code); it != lobbies_.end() || restorable_.empty()) {
+    return it;
+  }
+
+  const auto saved = restorable_.find(code);
+  if (saved == restorable_.end()) {
+    return lobbies_.end();
+  }
+  auto [it, _]         = lobbies_.try_emplace(string(code), *saved->second, restore_deadline_);
+  it->second.generation = ++generations_;
+  restorable_.erase(saved);
+  if (restorable_.empty()) {
+    snapshot_.reset();
+  }
+
+  Metrics::instance().lobbies_active.inc();
+  Metrics::instance().lobbies_restored.inc();
+  // Like a new lobby, plus the grace period its suspended players are held for.
+  schedule(restore_deadline_, Timer::Kind::kResumeGrace, it);
+  schedule(std::chrono::steady_clock::now() + options_.half_empty_timeout, Timer::Kind::kReap, it);
+  logging::info("Lobby restored", {.lobby = it->second.code_});
+  return it;
+}
+
 optional<LobbyContext> LobbyManager::join(weak_ptr<ISession> session, string_view code) {
   guard lock(mutex_);
 
-  if (const auto it = lobbies_.find(code); it != lobbies_.end()) {
+  if (const auto it = find(code); it != lobbies_.end()) {
+    logging::debug("Lobby join", {.session = session_id(session), .lobby = it->second.code_});
     return it->second.join(std::move(session));
   }
 
@@ -45,26 +101,219 @@ void LobbyManager::leave(const std::weak_ptr<ISession>& session, std::string_vie
 
   if (const auto it = lobbies_.find(code); it != lobbies_.end()) {
     it->second.leave(session);
+    erase_if_empty(it, session);
+  }
+}
 
-    if (it->second.empty()) {
-      lobbies_.erase(it);
+void LobbyManager::suspend(const weak_ptr<ISession>& session, string_view code) {
+  if (options_.resume_grace <= std::chrono::seconds::zero()) {
+    leave(session, code);
+    return;
+  }
+
+  guard lock(mutex_);
+
+  if (const auto it = lobbies_.find(code); it != lobbies_.end()) {
+    const time_point deadline = std::chrono::steady_clock::now() + options_.resume_grace;
+    it->second.suspend(session, deadline);
+    schedule(deadline, Timer::Kind::kResumeGrace, it);
+
+    Metrics::instance().sessions_suspended.inc();
+    logging::debug("Lobby suspend", {.session = session_id(session), .lobby = it->second.code_});
+  }
+}
+
+optional<LobbyContext> LobbyManager::resume(weak_ptr<ISession> session, string_view token) {
+  guard lock(mutex_);
+
+  const auto it = find(LobbyController::resume_token_code(token));
+  if (it != lobbies_.end()) {
+    if (auto ctx = it->second.resume(session, token)) {
+      Metrics::instance().sessions_resumed.inc();
+      logging::debug("Lobby resume", {.session = session_id(session), .lobby = it->second.code_});
+      return ctx;
     }
   }
+
+  if (auto sess = session.lock()) {
+    sess->async_send(jout::lobby_resume_failed());
+  }
+  return nullopt;
 }
 
-string LobbyManager::generate_code() {
-  static constexpr int kCodeLength          = 6;
-  static constexpr const char kCharacters[] = "1234567890ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+bool LobbyManager::spectate(weak_ptr<ISession> session, string_view code) {
+  guard lock(mutex_);
 
-  thread_local mt19937 gen{random_device{}()};
-  thread_local uniform_int_distribution<string::size_type> pick(0, strlen(kCharacters) - 1);
+  if (const auto it = find(code); it != lobbies_.end()) {
+    logging::debug("Lobby spectate", {.session = session_id(session), .lobby = it->second.code_});
+    return it->second.spectate(std::move(session));
+  }
+
+  if (auto sess = session.lock()) {
+    sess->async_send(jout::spectate_join(nullopt));
+  }
+  return false;
+}
 
-  // Keep generating until the code is unique.
-  string res(kCodeLength, '#');
-  do {
-    std::generate_n(res.begin(), res.size(), [&] { return kCharacters[pick(gen)]; });
-  } while (lobbies_.contains(res));
+void LobbyManager::unspectate(const weak_ptr<ISession>& session, string_view code) {
+  guard lock(mutex_);
 
-  return res;
+  if (const auto it = lobbies_.find(code); it != lobbies_.end()) {
+    it->second.unspectate(session);
+  }
+}
+
+std::shared_ptr<MatchTicket> LobbyManager::matchmake(weak_ptr<ISession> session,
+                                                     Character preference) {
+  auto ticket = std::make_shared<MatchTicket>(std::move(session), preference);
+  logging::debug("Matchmaking", {.session = session_id(ticket->session)});
+  matchmaker_.enqueue(ticket);
+  return ticket;
 }
+
+void LobbyManager::on_match(MatchTicket& a, MatchTicket& b) {
+  guard lock(mutex_);
+
+  const auto it = open();
+  a.match.emplace(*it->second.join(a.session));
+  b.match.emplace(*it->second.join(b.session));
+  logging::info("Lobby matched", {.session = session_id(a.session), .lobby = it->second.code_});
+}
+
+void LobbyManager::expire(time_point now) {
+  guard lock(mutex_);
+
+  timers_.advance(now, [&](Timer&& timer) { on_timer(std::move(timer), now); });
+  Metrics::instance().lobby_timers.set(static_cast<int64_t>(timers_.size()));
+}
+
+void LobbyManager::on_timer(Timer timer, time_point now) {
+  if (timer.kind == Timer::Kind::kRestoreExpiry) {
+    if (!restorable_.empty()) {
+      logging::info("Dropped " + std::to_string(restorable_.size()) + " unrestored lobbies");
+    }
+    restorable_.clear();
+    snapshot_.reset();
+    return;
+  }
+
+  // The lobby the timer was for may have closed and its code gone to a new one.
+  const auto it = lobbies_.find(timer.code);
+  if (it == lobbies_.end() || it->second.generation != timer.generation) {
+    return;
+  }
+
+  switch (timer.kind) {
+    case Timer::Kind::kResumeGrace:
+      if (const int expired = it->second.expire(now); expired > 0) {
+        Metrics::instance().resumes_expired.inc(expired);
+        erase_if_empty(it, {});
+      }
+      break;
+    case Timer::Kind::kReap:          reap(it, now); break;
+    case Timer::Kind::kRestoreExpiry: break;
+  }
+}
+
+void LobbyManager::schedule(time_point when, Timer::Kind kind, LobbyMap::iterator it) {
+  timers_.schedule(when, {kind, it->first, it->second.generation});
+}
+
+void LobbyManager::reap(LobbyMap::iterator it, time_point now) {
+  LobbyController& lobby = it->second;
+  // Rough, but enough to see what idle lobbies were costing.
+  const auto footprint = sizeof(LobbyMap::value_type) + it->first.capacity();
+
+  if (lobby.empty()) {
+    // Closed lobbies were counted when they were closed.
+    if (!lobby.closed()) {
+      Metrics::instance().lobbies_reaped.inc();
+      Metrics::instance().lobby_bytes_reclaimed.inc(footprint);
+    }
+    erase_if_empty(it, {});
+    return;
+  }
+
+  if (!lobby.closed()) {
+    const auto timeout
+        = lobby.players() < 2 ? options_.half_empty_timeout : options_.idle_timeout;
+    if (timeout <= std::chrono::seconds::zero()) {
+      schedule(now + kUntimedReapInterval, Timer::Kind::kReap, it);
+      return;
+    }
+
+    // Activity pushes the deadline back, so check again then rather than on every touch.
+    if (const time_point deadline = lobby.last_activity() + timeout; deadline > now) {
+      schedule(deadline, Timer::Kind::kReap, it);
+      return;
+    }
+
+    lobby.close();
+    Metrics::instance().lobbies_reaped.inc();
+    Metrics::instance().lobby_bytes_reclaimed.inc(footprint);
+    logging::info("Lobby reaped", {.lobby = lobby.code_});
+  }
+
+  // Sessions leave a closed lobby on their own. Catch the ones that vanish instead.
+  schedule(now + kTimerResolution, Timer::Kind::kReap, it);
+}
+
+void LobbyManager::erase_if_empty(LobbyMap::iterator it, const weak_ptr<ISession>& session) {
+  if (it->second.empty()) {
+    // Sends any spectators away.
+    it->second.close();
+    logging::info("Lobby closed", {.session = session_id(session), .lobby = it->second.code_});
+    codes_.release(it->first);
+    lobbies_.erase(it);
+    Metrics::instance().lobbies_active.dec();
+  }
+}
+
+bool LobbyManager::snapshot(const string& path) {
+  guard lock(mutex_);
+
+  std::size_t saved = 0;
+  const bool ok     = LobbySnapshot::save(
+      path, lobbies_.size() + restorable_.size(), [&](std::span<LobbyImage> images) {
+        for (const auto& [code, lobby] : lobbies_) {
+          if (!lobby.closed() && !lobby.empty() && lobby.save(images[saved])) {
+            ++saved;
+          }
+        }
+        for (const auto& [code, image] : restorable_) {
+          images[saved++] = *image;
+        }
+        return saved;
+      });
+
+  if (ok) {
+    logging::info("Saved " + std::to_string(saved) + " lobbies to snapshot");
+  }
+  return ok;
+}
+
+std::size_t LobbyManager::restore(const string& path) {
+  auto snapshot = LobbySnapshot::open(path);
+  if (!snapshot) {
+    return 0;
+  }
+  // The mapping outlives the file. Removing it keeps a crash from restoring
+  // the same lobbies twice.
+  std::remove(path.c_str());
+
+  guard lock(mutex_);
+  restore_deadline_ = std::chrono::steady_clock::now() + options_.resume_grace;
+  restorable_.reserve(snapshot->images().size());
+  for (const LobbyImage& image : snapshot->images()) {
+    if (const string_view code = LobbyImage::get(image.code); !lobbies_.contains(code)) {
+      restorable_.emplace(code, &image);
+    }
+  }
+  snapshot_ = std::move(snapshot);
+  timers_.schedule(restore_deadline_, {Timer::Kind::kRestoreExpiry, {}, 0});
+
+  logging::info("Restoring " + std::to_string(restorable_.size()) + " lobbies from snapshot");
+  return restorable_.size();
+}
+
 }  // namespace io_blair
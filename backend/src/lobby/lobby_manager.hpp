@@ -3,6 +3,7 @@
  */
 #pragma once
 
+#include <chrono>
 #include <functional>
 #include <memory>
 #include <mutex>
@@ -11,26 +12,155 @@
 #include <string_view>
 #include <unordered_map>
 
+#include "code_allocator.hpp"
 #include "ilobby_manager.hpp"
 #include "isession.hpp"
 #include "lobby_context.hpp"
 #include "lobby_controller.hpp"
+#include "lobby_options.hpp"
+#include "lobby_snapshot.hpp"
+#include "matchmaker.hpp"
 #include "string_hash.hpp"
+#include "timer_wheel.hpp"
 
 namespace io_blair {
 class LobbyManager : public ILobbyManager {
  public:
+  /**
+   * @brief The resolution of grace periods and lobby timeouts.
+   */
+  static constexpr std::chrono::seconds kTimerResolution{1};
+
+  /**
+   * @brief Construct a new LobbyManager object.
+   *
+   * @param options How long places and lobbies are held.
+   */
+  explicit LobbyManager(LobbyOptions options = {});
+
   LobbyContext create(std::weak_ptr<ISession> session) override;
 
   std::optional<LobbyContext> join(std::weak_ptr<ISession> session, std::string_view code) override;
 
   void leave(const std::weak_ptr<ISession>& session, std::string_view code) override;
 
+  void suspend(const std::weak_ptr<ISession>& session, std::string_view code) override;
+
+  std::optional<LobbyContext> resume(std::weak_ptr<ISession> session,
+                                     std::string_view token) override;
+
+  bool spectate(std::weak_ptr<ISession> session, std::string_view code) override;
+
+  void unspectate(const std::weak_ptr<ISession>& session, std::string_view code) override;
+
+  std::shared_ptr<MatchTicket> matchmake(std::weak_ptr<ISession> session,
+                                         Character preference) override;
+
+  /**
+   * @brief Removes suspended sessions whose grace period is over and
+   * reclaims lobbies that are empty or have sat idle past their timeout.
+   * Should be called about once per kTimerResolution.
+   *
+   * @param now
+   */
+  void expire(std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now());
+
+  /**
+   * @brief Saves every lobby with players in it to a LobbySnapshot at \p path,
+   * including restored lobbies no one has come back to yet.
+   *
+   * @param path
+   * @return true The snapshot was written.
+   * @return false The file couldn't be written.
+   */
+  bool snapshot(const std::string& path);
+
+  /**
+   * @brief Maps the snapshot at \p path and removes the file. Lobbies are
+   * only rebuilt once a session joins, resumes or spectates them. Those no one
+   * has come back to by LobbyOptions::resume_grace are dropped.
+   *
+   * @param path
+   * @return std::size_t The number of lobbies that may be restored.
+   */
+  std::size_t restore(const std::string& path);
+
  private:
-  std::string generate_code();
+  // A lobby, told apart from earlier ones that had the same code.
+  struct Lobby : LobbyController {
+    using LobbyController::LobbyController;
+
+    // Set from generations_ when the lobby is opened or restored.
+    uint64_t generation = 0;
+  };
+
+  using LobbyMap   = std::unordered_map<std::string, Lobby, StringHash, std::equal_to<>>;
+  using time_point = std::chrono::steady_clock::time_point;
+
+  // A deadline for the lobby named by code.
+  struct Timer {
+    enum class Kind {
+      // A suspended player's grace period ends.
+      kResumeGrace,
+      // The lobby may have become empty or idle.
+      kReap,
+      // Lobbies from a snapshot that weren't restored by now are dropped. No code.
+      kRestoreExpiry,
+    };
+
+    Kind kind;
+    std::string code;
+    // The generation of the lobby at code when the timer was scheduled.
+    uint64_t generation;
+  };
+
+  // Closes the lobby at it if no one is left in it.
+  void erase_if_empty(LobbyMap::iterator it, const std::weak_ptr<ISession>& session);
+
+  // Handles a timer from timers_ that came due.
+  void on_timer(Timer timer, time_point now);
+
+  // Schedules a timer of kind for the lobby at it.
+  void schedule(time_point when, Timer::Kind kind, LobbyMap::iterator it);
+
+  // Reclaims the lobby at it if it's empty or idle, otherwise schedules the next check.
+  void reap(LobbyMap::iterator it, time_point now);
+
+  // Places a pair from matchmaker_ in a new lobby.
+  void on_match(MatchTicket& a, MatchTicket& b);
+
+  // Creates an empty lobby.
+  LobbyMap::iterator open();
+
+  // Finds the lobby named by code, restoring it from snapshot_ if it's waiting there.
+  LobbyMap::iterator find(std::string_view code);
+
+  const LobbyOptions options_;
 
   std::recursive_mutex mutex_;
-  std::unordered_map<std::string, LobbyController, StringHash, std::equal_to<>> lobbies_;
+  LobbyMap lobbies_;
+
+  // Hands out join codes for new lobbies and takes back those of closed ones.
+  CodeAllocator codes_;
+
+  // Deadlines for every lobby, without scanning lobbies_. Each lobby has a
+  // single kReap timer. Timers left by a closed lobby are skipped by
+  // generation, since its code may be reused by then. kResumeGrace timers
+  // may also be stale if the player resumed or left since.
+  TimerWheel<Timer> timers_;
+
+  // The generation of the last lobby opened or restored.
+  uint64_t generations_ = 0;
+
+  // The snapshot restored from at startup, kept mapped while any of its
+  // lobbies haven't been rebuilt. restorable_ points into it by code.
+  std::optional<LobbySnapshot> snapshot_;
+  std::unordered_map<std::string_view, const LobbyImage*> restorable_;
+  time_point restore_deadline_;
+
+  // Pairs sessions looking for a quick match without taking mutex_. Last so
+  // it's destroyed first, while lobbies_ is still alive.
+  Matchmaker matchmaker_;
 };
 
 }  // namespace io_blair
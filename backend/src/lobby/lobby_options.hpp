@@ -0,0 +1,40 @@
+/**
+ * @file lobby_options.hpp
+ */
+#pragma once
+
+#include <chrono>
+#include <string>
+
+namespace io_blair {
+/**
+ * @brief Settings for how LobbyManager holds and reclaims lobbies.
+ */
+struct LobbyOptions {
+  /**
+   * @brief How long a session that drops while in a lobby keeps its place
+   * for a reconnecting client to resume. Zero makes dropping the same as leaving.
+   */
+  std::chrono::seconds resume_grace{30};
+
+  /**
+   * @brief How long a full lobby may go without anyone joining, leaving or
+   * playing before it's closed. Zero disables closing idle lobbies.
+   */
+  std::chrono::seconds idle_timeout{std::chrono::minutes(30)};
+
+  /**
+   * @brief How long a lobby may wait for a second player before it's
+   * closed. Zero disables closing half-empty lobbies.
+   */
+  std::chrono::seconds half_empty_timeout{std::chrono::minutes(10)};
+
+  /**
+   * @brief Where lobbies are saved when the server exits and restored from
+   * when it starts, so a restart doesn't end games in progress. Restored
+   * players are held for resume_grace. Empty disables snapshots.
+   */
+  std::string snapshot_path{};
+};
+
+}  // namespace io_blair
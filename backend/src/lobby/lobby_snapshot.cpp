@@ -0,0 +1,167 @@
+#include "lobby_snapshot.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <optional>
+#include <string>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define IO_BLAIR_HAS_MMAP 1
+#endif
+
+
+namespace io_blair {
+using std::nullopt;
+using std::optional;
+using std::string;
+
+namespace {
+// Reads "IOBS" in the file.
+constexpr uint32_t kMagic = 0x53424F49;
+
+// Written at the start of the file. Padded so images start cache line aligned.
+struct Header {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t image_size;
+  uint32_t reserved;
+  uint64_t count;
+};
+constexpr std::size_t kHeaderSize = 64;
+static_assert(sizeof(Header) <= kHeaderSize);
+
+Header* header_of(void* mapping) {
+  return static_cast<Header*>(mapping);
+}
+
+LobbyImage* images_of(void* mapping) {
+  return reinterpret_cast<LobbyImage*>(static_cast<char*>(mapping) + kHeaderSize);
+}
+}  // namespace
+
+LobbySnapshot::LobbySnapshot(LobbySnapshot&& other) noexcept
+    : path_(std::move(other.path_)),
+      mapping_(std::exchange(other.mapping_, nullptr)),
+      length_(std::exchange(other.length_, 0)),
+      images_(std::exchange(other.images_, nullptr)),
+      count_(std::exchange(other.count_, 0)) {}
+
+LobbySnapshot& LobbySnapshot::operator=(LobbySnapshot&& other) noexcept {
+  if (this != &other) {
+    unmap();
+    path_    = std::move(other.path_);
+    mapping_ = std::exchange(other.mapping_, nullptr);
+    length_  = std::exchange(other.length_, 0);
+    images_  = std::exchange(other.images_, nullptr);
+    count_   = std::exchange(other.count_, 0);
+  }
+  return *this;
+}
+
+LobbySnapshot::~LobbySnapshot() {
+  unmap();
+}
+
+#ifdef IO_BLAIR_HAS_MMAP
+bool LobbySnapshot::create(const string& path, std::size_t count) {
+  const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    return false;
+  }
+
+  const std::size_t length = kHeaderSize + count * sizeof(LobbyImage);
+  void* mapping            = MAP_FAILED;
+  if (::ftruncate(fd, static_cast<off_t>(length)) == 0) {
+    mapping = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  ::close(fd);
+  if (mapping == MAP_FAILED) {
+    ::unlink(path.c_str());
+    return false;
+  }
+
+  path_    = path;
+  mapping_ = mapping;
+  length_  = length;
+  images_  = images_of(mapping);
+  return true;
+}
+
+bool LobbySnapshot::commit(const string& path, std::size_t count) {
+  *header_of(mapping_) = {
+      .magic      = kMagic,
+      .version    = kVersion,
+      .image_size = sizeof(LobbyImage),
+      .reserved   = 0,
+      .count      = count,
+  };
+  count_ = count;
+
+  const bool ok = ::msync(mapping_, length_, MS_SYNC) == 0 &&
+                  std::rename(path_.c_str(), path.c_str()) == 0;
+  if (!ok) {
+    ::unlink(path_.c_str());
+  }
+  return ok;
+}
+
+optional<LobbySnapshot> LobbySnapshot::open(const string& path) {
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return nullopt;
+  }
+
+  struct stat st {};
+  void* mapping = MAP_FAILED;
+  if (::fstat(fd, &st) == 0 && static_cast<std::size_t>(st.st_size) >= kHeaderSize) {
+    mapping = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  }
+  ::close(fd);
+  if (mapping == MAP_FAILED) {
+    return nullopt;
+  }
+
+  LobbySnapshot snapshot;
+  snapshot.path_    = path;
+  snapshot.mapping_ = mapping;
+  snapshot.length_  = static_cast<std::size_t>(st.st_size);
+
+  const Header& header = *header_of(mapping);
+  if (header.magic != kMagic || header.version != kVersion ||
+      header.image_size != sizeof(LobbyImage) ||
+      header.count > (snapshot.length_ - kHeaderSize) / sizeof(LobbyImage)) {
+    return nullopt;
+  }
+  snapshot.images_ = images_of(mapping);
+  snapshot.count_  = header.count;
+  return snapshot;
+}
+
+void LobbySnapshot::unmap() {
+  if (mapping_ != nullptr) {
+    ::munmap(mapping_, length_);
+    mapping_ = nullptr;
+  }
+}
+#else
+bool LobbySnapshot::create(const string&, std::size_t) {
+  return false;
+}
+
+bool LobbySnapshot::commit(const string&, std::size_t) {
+  return false;
+}
+
+optional<LobbySnapshot> LobbySnapshot::open(const string&) {
+  return nullopt;
+}
+
+void LobbySnapshot::unmap() {}
+#endif
+
+}  // namespace io_blair
@@ -0,0 +1,158 @@
+/**
+ * @file lobby_snapshot.hpp
+ */
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "character.hpp"
+
+namespace io_blair {
+/**
+ * @brief The saved state of one lobby. Fixed size and trivially copyable so
+ * images are written and read in place in a LobbySnapshot.
+ */
+struct LobbyImage {
+  /**
+   * @brief The longest join code an image holds.
+   */
+  static constexpr std::size_t kMaxCode = 15;
+  /**
+   * @brief The longest resume token an image holds.
+   */
+  static constexpr std::size_t kMaxToken = 47;
+  /**
+   * @brief The number of maze cells an image holds.
+   */
+  static constexpr std::size_t kMaxCells = 64;
+
+  /**
+   * @brief One of the lobby's two players.
+   */
+  struct Seat {
+    /**
+     * @brief Whether a player holds the seat. The rest is unset if not.
+     */
+    uint8_t occupied;
+    Character character;
+    int8_t x;
+    int8_t y;
+    std::array<char, kMaxToken + 1> resume_token;
+  };
+
+  std::array<char, kMaxCode + 1> code;
+  std::array<Seat, 2> seats;
+  /**
+   * @brief Cell::bits() of every maze cell, row by row.
+   */
+  std::array<uint16_t, kMaxCells> cells;
+
+  /**
+   * @brief Copies \p str into \p field, NUL padded.
+   *
+   * @return true \p str fit.
+   * @return false \p str was too long. \p field is left empty.
+   */
+  template <std::size_t N>
+  static bool put(std::array<char, N>& field, std::string_view str) {
+    field.fill('\0');
+    if (str.size() >= N) {
+      return false;
+    }
+    str.copy(field.data(), str.size());
+    return true;
+  }
+
+  /**
+   * @brief Reads a field written by put().
+   */
+  template <std::size_t N>
+  static std::string_view get(const std::array<char, N>& field) {
+    const std::string_view str(field.data(), N);
+    return str.substr(0, str.find('\0'));
+  }
+};
+static_assert(std::is_trivially_copyable_v<LobbyImage>);
+
+/**
+ * @brief A versioned, memory-mapped file of LobbyImage's, used to carry
+ * lobbies across a restart. Images are read straight out of the mapping.
+ *
+ * @note Only supported on POSIX systems. Elsewhere saving and opening fail.
+ */
+class LobbySnapshot {
+ public:
+  /**
+   * @brief The version of the file layout, bumped whenever LobbyImage changes.
+   */
+  static constexpr uint32_t kVersion = 1;
+
+  /**
+   * @brief Writes \p count images to \p path. The file is written beside
+   * \p path and renamed over it once complete, so a reader never sees a
+   * partial snapshot.
+   *
+   * @param path
+   * @param count The most images \p fill may write.
+   * @param fill Called with room for \p count images. Returns how many it wrote.
+   * @return true The snapshot was written.
+   * @return false The file couldn't be written.
+   */
+  template <typename Fill>
+  static bool save(const std::string& path, std::size_t count, Fill&& fill) {
+    LobbySnapshot snapshot;
+    if (!snapshot.create(path + ".tmp", count)) {
+      return false;
+    }
+    return snapshot.commit(path, fill(std::span<LobbyImage>(snapshot.images_, count)));
+  }
+
+  /**
+   * @brief Maps the snapshot at \p path.
+   *
+   * @param path
+   * @return std::optional<LobbySnapshot> The snapshot, or nullopt if it
+   * doesn't exist or wasn't written by this version.
+   */
+  static std::optional<LobbySnapshot> open(const std::string& path);
+
+  LobbySnapshot(LobbySnapshot&& other) noexcept;
+  LobbySnapshot& operator=(LobbySnapshot&& other) noexcept;
+
+  ~LobbySnapshot();
+
+  /**
+   * @brief Gets the saved lobbies.
+   *
+   * @return std::span<const LobbyImage>
+   */
+  std::span<const LobbyImage> images() const {
+    return {images_, count_};
+  }
+
+ private:
+  LobbySnapshot() = default;
+
+  // Creates and maps a file with room for count images.
+  bool create(const std::string& path, std::size_t count);
+
+  // Records count, flushes the mapping and renames it to path.
+  bool commit(const std::string& path, std::size_t count);
+
+  void unmap();
+
+  std::string path_;
+  void* mapping_      = nullptr;
+  std::size_t length_ = 0;
+  LobbyImage* images_ = nullptr;
+  std::size_t count_  = 0;
+};
+
+}  // namespace io_blair
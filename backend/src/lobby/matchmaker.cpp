@@ -0,0 +1,196 @@
+#include "matchmaker.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+
+#include "event.hpp"
+#include "metrics.hpp"
+
+
+namespace io_blair {
+using std::shared_ptr;
+using State = MatchTicket::State;
+
+MatchTicket::MatchTicket(std::weak_ptr<ISession> session, Character preference,
+                         time_point enqueued)
+    : session(std::move(session)),
+      preference(preference),
+      enqueued(enqueued) {}
+
+bool MatchTicket::cancel() {
+  State state = State::kWaiting;
+  while (!state_.compare_exchange_weak(state, State::kCancelled, std::memory_order_acq_rel,
+                                       std::memory_order_acquire)) {
+    switch (state) {
+      case State::kCancelled: return true;
+      case State::kMatched:   return false;
+      // Pairing settles quickly either way, so wait it out.
+      case State::kClaiming: std::this_thread::yield(); break;
+      case State::kWaiting:  break;
+    }
+    state = State::kWaiting;
+  }
+
+  Metrics::instance().matchmaking_queue_depth.dec();
+  return true;
+}
+
+MatchTicket::State MatchTicket::state() const {
+  return state_.load(std::memory_order_acquire);
+}
+
+bool MatchTicket::transition(State from, State to) {
+  return state_.compare_exchange_strong(from, to, std::memory_order_acq_rel);
+}
+
+Matchmaker::Matchmaker(OnMatch on_match)
+    : on_match_(std::move(on_match)) {}
+
+Matchmaker::~Matchmaker() {
+  incoming_.drain([this](Ticket&& ticket) {
+    waiting_[static_cast<std::size_t>(ticket->preference)].push_back(std::move(ticket));
+  });
+  for (Queue& queue : waiting_) {
+    for (const Ticket& ticket : queue) {
+      if (ticket->transition(State::kWaiting, State::kCancelled)) {
+        Metrics::instance().matchmaking_queue_depth.dec();
+      }
+    }
+  }
+}
+
+void Matchmaker::enqueue(shared_ptr<MatchTicket> ticket) {
+  Metrics::instance().matchmaking_queue_depth.inc();
+  incoming_.push(std::move(ticket));
+  enqueued_.fetch_add(1);
+  pair();
+}
+
+void Matchmaker::pair() {
+  while (!pairing_.test_and_set()) {
+    const uint64_t seen = enqueued_.load();
+
+    incoming_.drain([this](Ticket&& ticket) {
+      waiting_[static_cast<std::size_t>(ticket->preference)].push_back(std::move(ticket));
+    });
+    for (std::size_t i = 0; i < waiting_.size(); ++i) {
+      sweep(i);
+    }
+
+    auto& any   = waiting_[static_cast<std::size_t>(Character::unknown)];
+    auto& io    = waiting_[static_cast<std::size_t>(Character::Io)];
+    auto& blair = waiting_[static_cast<std::size_t>(Character::Blair)];
+    // Exact preferences first so those who don't mind are left for those who do.
+    pair_queues(io, blair);
+    pair_queues(io, any);
+    pair_queues(blair, any);
+    pair_queues(any, any);
+
+    pairing_.clear();
+    // A thread that enqueued while this one was pairing left its ticket here.
+    if (enqueued_.load() == seen) {
+      return;
+    }
+  }
+}
+
+void Matchmaker::pair_queues(Queue& a, Queue& b) {
+  auto& metrics = Metrics::instance();
+
+  while (true) {
+    Ticket first = take(a);
+    if (!first) {
+      return;
+    }
+    Ticket second = take(b);
+    if (!second) {
+      first->state_.store(State::kWaiting, std::memory_order_release);
+      a.push_front(std::move(first));
+      return;
+    }
+
+    const auto first_session  = first->session.lock();
+    const auto second_session = second->session.lock();
+    if (!first_session || !second_session) {
+      // One of them closed since being taken. Put the other back where it was.
+      const auto restore = [&](Ticket& ticket, bool alive, Queue& queue) {
+        if (alive) {
+          ticket->state_.store(State::kWaiting, std::memory_order_release);
+          queue.push_front(std::move(ticket));
+        } else {
+          ticket->state_.store(State::kCancelled, std::memory_order_release);
+          metrics.matchmaking_queue_depth.dec();
+        }
+      };
+      // Second first, so first stays ahead when both came from the same queue.
+      restore(second, second_session != nullptr, b);
+      restore(first, first_session != nullptr, a);
+      continue;
+    }
+
+    on_match_(*first, *second);
+    first->state_.store(State::kMatched, std::memory_order_release);
+    second->state_.store(State::kMatched, std::memory_order_release);
+    first_session->async_handle(SessionEvent::kMatchFound);
+    second_session->async_handle(SessionEvent::kMatchFound);
+
+    const auto now = MatchTicket::clock::now();
+    for (const Ticket& ticket : {first, second}) {
+      metrics.matchmaking_wait_seconds.observe(
+          std::chrono::duration<double>(now - ticket->enqueued).count());
+    }
+    metrics.matchmaking_queue_depth.dec(2);
+    metrics.matches_made.inc();
+  }
+}
+
+std::size_t Matchmaker::size() const {
+  std::size_t size = 0;
+  for (const Queue& queue : waiting_) {
+    size += queue.size();
+  }
+  return size;
+}
+
+void Matchmaker::sweep(std::size_t index) {
+  // Small queues aren't worth sweeping.
+  constexpr std::size_t kMinSweep = 16;
+
+  Queue& queue = waiting_[index];
+  if (queue.size() < 2 * std::max(swept_[index], kMinSweep)) {
+    return;
+  }
+  std::erase_if(queue, [](const Ticket& ticket) {
+    if (!ticket->session.expired()) {
+      return ticket->state() == State::kCancelled;
+    }
+    if (ticket->transition(State::kWaiting, State::kCancelled)) {
+      Metrics::instance().matchmaking_queue_depth.dec();
+    }
+    return true;
+  });
+  swept_[index] = queue.size();
+}
+
+Matchmaker::Ticket Matchmaker::take(Queue& queue) {
+  while (!queue.empty()) {
+    Ticket ticket = std::move(queue.front());
+    queue.pop_front();
+
+    // Tickets of sessions that closed without cancelling are dropped here.
+    if (ticket->session.expired()) {
+      if (ticket->transition(State::kWaiting, State::kCancelled)) {
+        Metrics::instance().matchmaking_queue_depth.dec();
+      }
+      continue;
+    }
+    // Cancelled tickets are dropped here too.
+    if (ticket->transition(State::kWaiting, State::kClaiming)) {
+      return ticket;
+    }
+  }
+  return nullptr;
+}
+
+}  // namespace io_blair
@@ -0,0 +1,184 @@
+/**
+ * @file matchmaker.hpp
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <optional>
+
+#include "character.hpp"
+#include "isession.hpp"
+#include "lobby_context.hpp"
+#include "mailbox.hpp"
+
+namespace io_blair {
+/**
+ * @brief A session's place in the Matchmaker queue. The session keeps the
+ * ticket to cancel it or to pick up the lobby it was matched into.
+ */
+class MatchTicket {
+ public:
+  using clock      = std::chrono::steady_clock;
+  using time_point = clock::time_point;
+
+  /**
+   * @brief Where the ticket is in its lifetime.
+   */
+  enum class State : uint8_t {
+    /**
+     * @brief Queued to be paired.
+     */
+    kWaiting,
+    /**
+     * @brief Being paired. Settles on kWaiting or kMatched shortly.
+     */
+    kClaiming,
+    /**
+     * @brief Paired. match holds the lobby joined.
+     */
+    kMatched,
+    /**
+     * @brief Withdrawn before being paired.
+     */
+    kCancelled,
+  };
+
+  /**
+   * @brief Construct a new MatchTicket.
+   *
+   * @param session The session waiting to be paired.
+   * @param preference The character the session would like to play, or
+   * Character::unknown for either.
+   * @param enqueued When the session started waiting.
+   */
+  MatchTicket(std::weak_ptr<ISession> session, Character preference,
+              time_point enqueued = clock::now());
+
+  /**
+   * @brief Withdraws the ticket unless it was already paired. Safe to call
+   * from any thread.
+   *
+   * @return true The ticket won't be paired.
+   * @return false The ticket was already paired. match is set.
+   */
+  bool cancel();
+
+  /**
+   * @brief Gets the current state.
+   *
+   * @return State
+   */
+  State state() const;
+
+  const std::weak_ptr<ISession> session;
+  const Character preference;
+  const time_point enqueued;
+
+  /**
+   * @brief Context on the lobby the session was placed in. Set before the
+   * ticket becomes State::kMatched and only read by the ticket's session after.
+   */
+  std::optional<LobbyContext> match;
+
+ private:
+  friend class Matchmaker;
+
+  // Moves the ticket from from to to if it's still in from.
+  bool transition(State from, State to);
+
+  std::atomic<State> state_{State::kWaiting};
+};
+
+/**
+ * @brief Pairs sessions looking for a quick match, oldest first. Sessions
+ * that asked for a character are paired with someone who asked for the
+ * other one, or with someone who doesn't mind, before anyone else.
+ *
+ * Enqueuing is lock-free. Pairing runs on whichever enqueuing thread finds
+ * no one else pairing, so the queue is never behind a lock and threads that
+ * arrive mid-pair leave their tickets for the pairing thread to pick up.
+ */
+class Matchmaker {
+ public:
+  /**
+   * @brief Called with the two tickets of each pair while they're
+   * State::kClaiming. It should set both tickets' match. Both sessions are
+   * then sent SessionEvent::kMatchFound.
+   */
+  using OnMatch = std::function<void(MatchTicket&, MatchTicket&)>;
+
+  /**
+   * @brief Construct a new Matchmaker.
+   *
+   * @param on_match Places each pair in a lobby. Never called concurrently.
+   */
+  explicit Matchmaker(OnMatch on_match);
+
+  Matchmaker(const Matchmaker&)            = delete;
+  Matchmaker& operator=(const Matchmaker&) = delete;
+
+  ~Matchmaker();
+
+  /**
+   * @brief Queues \p ticket and pairs whoever can be paired. Safe to call
+   * from any thread.
+   *
+   * @param ticket
+   */
+  void enqueue(std::shared_ptr<MatchTicket> ticket);
+
+  /**
+   * @brief Gets the number of tickets held, including cancelled ones not yet
+   * dropped. Not safe to call while another thread enqueues.
+   *
+   * @return std::size_t
+   */
+  std::size_t size() const;
+
+ private:
+  using Ticket = std::shared_ptr<MatchTicket>;
+  using Queue  = std::deque<Ticket>;
+
+  // Moves incoming tickets into waiting_ and pairs them until no one is left
+  // to pair. Returns immediately if another thread is already pairing.
+  void pair();
+
+  // Pairs the oldest tickets of a and b until one of them runs out. a and b
+  // may be the same queue.
+  void pair_queues(Queue& a, Queue& b);
+
+  // Pops and claims the oldest ticket in queue that can still be paired,
+  // dropping the ones before it. Returns nullptr if there are none.
+  static Ticket take(Queue& queue);
+
+  // Drops the cancelled and closed tickets anywhere in waiting_[index] once
+  // it has doubled since it was last swept. take() only drops them from the
+  // front, which a ticket no one can be paired with yet may hold indefinitely.
+  void sweep(std::size_t index);
+
+  const OnMatch on_match_;
+
+  // Tickets enqueued since the last pair().
+  Mailbox<Ticket> incoming_;
+
+  // Counts enqueues so the pairing thread can tell it missed some.
+  std::atomic<uint64_t> enqueued_{0};
+
+  // Set while a thread is pairing. Everything below belongs to that thread.
+  std::atomic_flag pairing_;
+
+  // Waiting tickets by preference, indexed by Character.
+  std::array<Queue, 3> waiting_;
+
+  // The size of each of waiting_ after it was last swept.
+  std::array<std::size_t, 3> swept_{};
+};
+
+}  // namespace io_blair
@@ -7,11 +7,7 @@
 
 
 namespace io_blair {
-void Player::send(std::shared_ptr<const std::string> msg) {
-  session_.async_send(std::move(msg));
-}
-
-void Player::send(std::string msg) {
+void Player::send(Message msg) {
   session_.async_send(std::move(msg));
 }
 
@@ -20,7 +16,8 @@ void Player::send(SessionEvent ev) {
 }
 
 bool Player::try_set(std::weak_ptr<ISession> session) {
-  return session_.try_set(std::move(session));
+  // A suspended player is held for its own session to come back.
+  return !suspended() && session_.try_set(std::move(session));
 }
 
 void Player::reset(bool reset_session) {
@@ -29,9 +26,29 @@ void Player::reset(bool reset_session) {
 
   if (reset_session) {
     session_.reset();
+    resume_token.clear();
+    resume_deadline_.reset();
   }
 }
 
+void Player::suspend(std::chrono::steady_clock::time_point deadline) {
+  session_.reset();
+  resume_deadline_ = deadline;
+}
+
+void Player::resume(std::weak_ptr<ISession> session) {
+  session_.try_set(std::move(session));
+  resume_deadline_.reset();
+}
+
+bool Player::suspended() const {
+  return resume_deadline_.has_value();
+}
+
+bool Player::expired(std::chrono::steady_clock::time_point now) const {
+  return suspended() && *resume_deadline_ <= now;
+}
+
 bool Player::exists() const {
   return !session_.expired();
 }
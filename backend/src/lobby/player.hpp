@@ -3,13 +3,16 @@
  */
 #pragma once
 
+#include <chrono>
 #include <memory>
+#include <optional>
 #include <string>
 
 #include "character.hpp"
 #include "event.hpp"
 #include "isession.hpp"
 #include "maze.hpp"
+#include "message.hpp"
 #include "session_view.hpp"
 
 
@@ -24,14 +27,7 @@ class Player {
    * 
    * @param msg 
    */
-  void send(std::shared_ptr<const std::string> msg);
-
-  /**
-   * @brief Convenience method that forwards to Player::session().
-   * 
-   * @param msg 
-   */
-  void send(std::string msg);
+  void send(Message msg);
 
   /**
    * @brief Convenience method that forwards to Player::session()'s
@@ -42,7 +38,8 @@ class Player {
   void send(SessionEvent ev);
 
   /**
-   * @brief Convenience method for underlying SessionView.
+   * @brief Convenience method for underlying SessionView. Fails while
+   * the player is suspended.
    * 
    * @param session
    * @return true 
@@ -57,6 +54,38 @@ class Player {
    */
   void reset(bool reset_session);
 
+  /**
+   * @brief Detaches the session but keeps the player's character and
+   * position so a new session can take its place with resume().
+   *
+   * @param deadline When the player stops being resumable.
+   */
+  void suspend(std::chrono::steady_clock::time_point deadline);
+
+  /**
+   * @brief Attaches \p session to a suspended player.
+   *
+   * @param session
+   */
+  void resume(std::weak_ptr<ISession> session);
+
+  /**
+   * @brief Determines if the player is waiting for its session to resume.
+   *
+   * @return true The player is suspended.
+   * @return false The player isn't suspended.
+   */
+  bool suspended() const;
+
+  /**
+   * @brief Determines if the player has been suspended past its deadline.
+   *
+   * @param now
+   * @return true The player can no longer be resumed.
+   * @return false The player isn't suspended or can still be resumed.
+   */
+  bool expired(std::chrono::steady_clock::time_point now) const;
+
   /**
    * @brief Determines if session hasn't expired.
    * 
@@ -92,8 +121,17 @@ class Player {
    */
   coordinate position;
 
+  /**
+   * @brief The token a new session presents to take over this player.
+   * Empty when the player is vacant.
+   */
+  std::string resume_token;
+
  private:
   SessionView session_;
+
+  // Set while suspended.
+  std::optional<std::chrono::steady_clock::time_point> resume_deadline_;
 };
 
 }  // namespace io_blair
@@ -1,6 +1,7 @@
 #include "session_controller.hpp"
 
 #include "maze.hpp"
+#include "trace.hpp"
 
 
 namespace io_blair {
@@ -12,6 +13,7 @@ void SessionController::set_character(Character character) {
 }
 
 void SessionController::move_character(coordinate coordinate) {
+  trace::Span span("move_character");
   controller_.move_character(self_, other_, coordinate);
 }
 
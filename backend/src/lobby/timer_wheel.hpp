@@ -0,0 +1,175 @@
+/**
+ * @file timer_wheel.hpp
+ */
+#pragma once
+
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace io_blair {
+/**
+ * @brief A hierarchical timer wheel. Scheduling is O(1) and advancing costs
+ * O(1) per elapsed tick plus the timers that fire, so timers can be kept for
+ * many objects without ever scanning all of them.
+ *
+ * Each level has kSlots slots, each kSlots times coarser than the one
+ * below. Timers beyond the first level cascade down a level whenever the
+ * level below wraps around, until they land in the first level and fire.
+ * Timers fire on the first advance() at or past their deadline, rounded up
+ * to a whole tick. Timers can't be cancelled, so owners should check whether
+ * a fired timer is still relevant.
+ *
+ * @tparam T The value handed back when a timer fires.
+ */
+template <typename T>
+class TimerWheel {
+ public:
+  using clock      = std::chrono::steady_clock;
+  using time_point = clock::time_point;
+  using duration   = clock::duration;
+
+  /**
+   * @brief Slots per level. A power of two so indexing is a mask.
+   */
+  static constexpr std::size_t kSlots = 64;
+
+  /**
+   * @brief Number of levels. With kSlots slots, timers up to
+   * kSlots^kLevels ticks out are placed directly. Later ones wait in the
+   * last level and are placed again when it comes around.
+   */
+  static constexpr std::size_t kLevels = 4;
+
+  /**
+   * @brief Construct a new TimerWheel.
+   *
+   * @param tick The wheel's resolution.
+   * @param start The time of the first tick.
+   */
+  explicit TimerWheel(duration tick, time_point start = clock::now())
+      : tick_(tick),
+        start_(start) {}
+
+  /**
+   * @brief Schedules \p value to fire at \p when. Deadlines that already
+   * passed fire on the next tick.
+   *
+   * @param when
+   * @param value
+   */
+  void schedule(time_point when, T value) {
+    const auto since = when - start_;
+    // Round up so a timer never fires early.
+    const uint64_t tick = since <= duration::zero()
+                            ? 0
+                            : static_cast<uint64_t>((since + tick_ - duration(1)) / tick_);
+    place(tick, std::move(value));
+    ++size_;
+  }
+
+  /**
+   * @brief Advances the wheel to \p now, passing the value of every timer
+   * that's due to \p fire. \p fire may schedule more timers.
+   *
+   * @param now
+   * @param fire Called with T&&.
+   */
+  template <typename Fn>
+  void advance(time_point now, Fn&& fire) {
+    if (now < start_) {
+      return;
+    }
+    const auto target = static_cast<uint64_t>((now - start_) / tick_);
+
+    while (next_ <= target) {
+      if (index(next_, 0) == 0) {
+        cascade();
+      }
+
+      // Fired timers may schedule into this same slot, so take it first.
+      auto due = std::move(levels_[0][index(next_, 0)]);
+      levels_[0][index(next_, 0)].clear();
+      ++next_;
+
+      size_ -= due.size();
+      for (auto& timer : due) {
+        fire(std::move(timer.value));
+      }
+    }
+  }
+
+  /**
+   * @brief Gets the number of timers waiting to fire.
+   *
+   * @return std::size_t
+   */
+  std::size_t size() const {
+    return size_;
+  }
+
+ private:
+  static constexpr std::size_t kSlotBits = std::countr_zero(kSlots);
+  static_assert(std::has_single_bit(kSlots));
+
+  struct Timer {
+    uint64_t tick;
+    T value;
+  };
+  using Slot = std::vector<Timer>;
+
+  // Gets the slot tick falls into on level.
+  static std::size_t index(uint64_t tick, std::size_t level) {
+    return static_cast<std::size_t>(tick >> (kSlotBits * level)) & (kSlots - 1);
+  }
+
+  // Places a timer by how far away it is, without counting it.
+  void place(uint64_t tick, T value) {
+    if (tick < next_) {
+      tick = next_;
+    }
+
+    constexpr uint64_t kSpan = uint64_t{1} << (kSlotBits * kLevels);
+
+    const uint64_t delta = tick - next_;
+    std::size_t level    = 0;
+    while (level + 1 < kLevels && delta >= (uint64_t{1} << (kSlotBits * (level + 1)))) {
+      ++level;
+    }
+    // Too far out to place. Park it in the furthest slot to be placed again later.
+    const uint64_t slot_tick = delta < kSpan ? tick : next_ + kSpan - 1;
+
+    levels_[level][index(slot_tick, level)].push_back({tick, std::move(value)});
+  }
+
+  // Moves timers down from the levels that just wrapped around.
+  void cascade() {
+    for (std::size_t level = 1; level < kLevels; ++level) {
+      Slot slot = std::move(levels_[level][index(next_, level)]);
+      levels_[level][index(next_, level)].clear();
+      for (auto& timer : slot) {
+        place(timer.tick, std::move(timer.value));
+      }
+      // Higher levels only move when this one wraps as well.
+      if (index(next_, level) != 0) {
+        break;
+      }
+    }
+  }
+
+  const duration tick_;
+  const time_point start_;
+
+  // The next tick to fire.
+  uint64_t next_ = 0;
+
+  std::size_t size_ = 0;
+
+  std::array<std::array<Slot, kSlots>, kLevels> levels_;
+};
+
+}  // namespace io_blair
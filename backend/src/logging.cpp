@@ -0,0 +1,278 @@
+#include "logging.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "metrics.hpp"
+
+
+namespace io_blair::logging {
+using std::memory_order_acquire;
+using std::memory_order_relaxed;
+using std::memory_order_release;
+using std::string;
+using std::string_view;
+using guard = std::lock_guard<std::mutex>;
+namespace chrono = std::chrono;
+
+namespace {
+// How long the background thread sleeps when there was nothing to format.
+constexpr auto kIdleInterval = chrono::milliseconds(5);
+
+string_view level_name(Level level) {
+  switch (level) {
+    case Level::kDebug: return "debug";
+    case Level::kInfo:  return "info";
+    case Level::kWarn:  return "warn";
+    case Level::kError: return "error";
+  }
+  return "unknown";
+}
+
+// Appends str to out, escaped as the contents of a JSON string.
+void append_escaped(string& out, string_view str) {
+  static constexpr char kHex[] = "0123456789abcdef";
+  for (const char c : str) {
+    switch (c) {
+      case '"':  out += "\\\""; break;
+      case '\\': out += "\\\\"; break;
+      case '\n': out += "\\n"; break;
+      case '\r': out += "\\r"; break;
+      case '\t': out += "\\t"; break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          out += "\\u00";
+          out += kHex[(c >> 4) & 0xF];
+          out += kHex[c & 0xF];
+        } else {
+          out += c;
+        }
+    }
+  }
+}
+
+// Appends time_ns as an RFC 3339 UTC timestamp with millisecond precision.
+void append_timestamp(string& out, int64_t time_ns) {
+  const chrono::sys_time<chrono::milliseconds> time{
+      chrono::duration_cast<chrono::milliseconds>(chrono::nanoseconds(time_ns))};
+  const auto days = chrono::floor<chrono::days>(time);
+  const chrono::year_month_day ymd{days};
+  const chrono::hh_mm_ss hms{time - days};
+
+  char buf[32];
+  const int len = std::snprintf(buf,
+                                sizeof(buf),
+                                "%04d-%02u-%02uT%02d:%02d:%02d.%03dZ",
+                                static_cast<int>(ymd.year()),
+                                static_cast<unsigned>(ymd.month()),
+                                static_cast<unsigned>(ymd.day()),
+                                static_cast<int>(hms.hours().count()),
+                                static_cast<int>(hms.minutes().count()),
+                                static_cast<int>(hms.seconds().count()),
+                                static_cast<int>(hms.subseconds().count()));
+  out.append(buf, len);
+}
+
+void format(string& out, const Record& record) {
+  out += "{\"ts\":\"";
+  append_timestamp(out, record.time_ns);
+  out += "\",\"level\":\"";
+  out += level_name(record.level);
+  out += "\",\"msg\":\"";
+  append_escaped(out, {record.message.data(), record.message_length});
+  out += '"';
+  if (record.session != 0) {
+    out += ",\"session\":";
+    out += std::to_string(record.session);
+  }
+  if (record.lobby_length != 0) {
+    out += ",\"lobby\":\"";
+    append_escaped(out, {record.lobby.data(), record.lobby_length});
+    out += '"';
+  }
+  out += "}\n";
+}
+
+// Marks the owning thread's ring as orphaned when the thread exits.
+struct RingHandle {
+  std::shared_ptr<RecordRing> ring;
+
+  ~RingHandle() {
+    if (ring) {
+      ring->orphaned.store(true, memory_order_release);
+    }
+  }
+};
+}  // namespace
+
+Level parse_level(string_view name, Level fallback) {
+  if (name == "debug") return Level::kDebug;
+  if (name == "info") return Level::kInfo;
+  if (name == "warn") return Level::kWarn;
+  if (name == "error") return Level::kError;
+  return fallback;
+}
+
+bool RecordRing::push(const Record& record) {
+  const std::size_t tail = tail_.load(memory_order_relaxed);
+  if (tail - head_.load(memory_order_acquire) == kCapacity) {
+    return false;
+  }
+  records_[tail % kCapacity] = record;
+  tail_.store(tail + 1, memory_order_release);
+  return true;
+}
+
+bool RecordRing::pop(Record& record) {
+  const std::size_t head = head_.load(memory_order_relaxed);
+  if (head == tail_.load(memory_order_acquire)) {
+    return false;
+  }
+  record = records_[head % kCapacity];
+  head_.store(head + 1, memory_order_release);
+  return true;
+}
+
+bool RecordRing::empty() const {
+  return head_.load(memory_order_relaxed) == tail_.load(memory_order_acquire);
+}
+
+Logger& Logger::instance() {
+  static Logger logger;
+  return logger;
+}
+
+Logger::~Logger() {
+  stop();
+}
+
+void Logger::start(std::FILE* out) {
+  guard lock(run_mutex_);
+  if (running_) {
+    return;
+  }
+
+  {
+    guard drain_lock(drain_mutex_);
+    out_ = out;
+  }
+  running_ = true;
+  thread_  = std::thread([this] { run(); });
+}
+
+void Logger::stop() {
+  bool was_running = false;
+  {
+    guard lock(run_mutex_);
+    was_running = std::exchange(running_, false);
+  }
+  if (was_running) {
+    run_cv_.notify_all();
+    thread_.join();
+  }
+
+  flush();
+}
+
+void Logger::flush() {
+  while (drain() != 0) {
+  }
+}
+
+void Logger::set_level(Level level) {
+  level_.store(level, memory_order_relaxed);
+}
+
+void Logger::write(Level level, string_view msg, Fields fields) {
+  Record record;
+  record.time_ns = chrono::duration_cast<chrono::nanoseconds>(
+                       chrono::system_clock::now().time_since_epoch())
+                       .count();
+  record.session = fields.session;
+  record.level   = level;
+
+  record.lobby_length = static_cast<uint8_t>(std::min(fields.lobby.size(), Record::kMaxLobby));
+  std::copy_n(fields.lobby.data(), record.lobby_length, record.lobby.data());
+
+  record.message_length = static_cast<uint16_t>(std::min(msg.size(), Record::kMaxMessage));
+  std::copy_n(msg.data(), record.message_length, record.message.data());
+
+  if (!local_ring().push(record)) {
+    dropped_.fetch_add(1, memory_order_relaxed);
+    Metrics::instance().log_records_dropped.inc();
+  }
+}
+
+RecordRing& Logger::local_ring() {
+  thread_local RingHandle handle;
+  if (!handle.ring) {
+    handle.ring = std::make_shared<RecordRing>();
+    guard lock(rings_mutex_);
+    rings_.push_back(handle.ring);
+  }
+  return *handle.ring;
+}
+
+std::size_t Logger::drain() {
+  guard lock(drain_mutex_);
+
+  std::vector<std::shared_ptr<RecordRing>> rings;
+  {
+    guard rings_lock(rings_mutex_);
+    rings = rings_;
+  }
+
+  line_.clear();
+  std::size_t count = 0;
+  Record record;
+  for (const auto& ring : rings) {
+    while (ring->pop(record)) {
+      format(line_, record);
+      ++count;
+    }
+  }
+
+  // Report drops in band so they're visible next to the gap they caused.
+  if (const uint64_t dropped = dropped_.load(memory_order_relaxed); dropped != reported_dropped_) {
+    line_ += "{\"level\":\"warn\",\"msg\":\"Dropped log records\",\"dropped\":";
+    line_ += std::to_string(dropped - reported_dropped_);
+    line_ += "}\n";
+    reported_dropped_ = dropped;
+  }
+
+  if (!line_.empty()) {
+    std::fwrite(line_.data(), 1, line_.size(), out_);
+    std::fflush(out_);
+  }
+
+  // Forget rings whose threads have exited and that have nothing left to format.
+  {
+    guard rings_lock(rings_mutex_);
+    std::erase_if(rings_, [](const auto& ring) {
+      return ring->orphaned.load(memory_order_acquire) && ring->empty();
+    });
+  }
+
+  return count;
+}
+
+void Logger::run() {
+  std::unique_lock lock(run_mutex_);
+  while (running_) {
+    lock.unlock();
+    const std::size_t count = drain();
+    lock.lock();
+
+    if (count == 0) {
+      run_cv_.wait_for(lock, kIdleInterval, [this] { return !running_; });
+    }
+  }
+}
+
+}  // namespace io_blair::logging
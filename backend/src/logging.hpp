@@ -0,0 +1,256 @@
+/**
+ * @file logging.hpp
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Asynchronous structured logging.
+ *
+ * Logging threads copy fixed size binary records into their own single producer
+ * ring buffer and immediately return. A background thread drains the rings and
+ * formats each record as a JSON line. When a ring is full the record is dropped
+ * and counted instead of blocking the caller.
+ */
+namespace io_blair::logging {
+
+/**
+ * @brief Severity of a record.
+ */
+enum class Level : uint8_t { kDebug, kInfo, kWarn, kError };
+
+/**
+ * @brief Parses a level name such as "info".
+ *
+ * @param name The level's name.
+ * @param fallback The level to return if \p name isn't recognized.
+ * @return Level
+ */
+Level parse_level(std::string_view name, Level fallback);
+
+/**
+ * @brief Structured context attached to a record.
+ */
+struct Fields {
+  /**
+   * @brief The id of the session the record is about. 0 means none.
+   */
+  uint64_t session = 0;
+  /**
+   * @brief The code of the lobby the record is about. Empty means none.
+   */
+  std::string_view lobby = {};
+};
+
+/**
+ * @brief A fixed size log record. Messages longer than kMaxMessage are truncated.
+ */
+struct Record {
+  static constexpr std::size_t kMaxMessage = 200;
+  static constexpr std::size_t kMaxLobby   = 8;
+
+  int64_t time_ns;
+  uint64_t session;
+  Level level;
+  uint8_t lobby_length;
+  uint16_t message_length;
+  std::array<char, kMaxLobby> lobby;
+  std::array<char, kMaxMessage> message;
+};
+
+/**
+ * @brief A single producer single consumer ring of records.
+ */
+class RecordRing {
+ public:
+  /**
+   * @brief The number of records a ring can hold.
+   */
+  static constexpr std::size_t kCapacity = 256;
+
+  /**
+   * @brief Copies \p record into the ring. Only called by the owning thread.
+   *
+   * @param record
+   * @return true The record was queued.
+   * @return false The ring was full.
+   */
+  bool push(const Record& record);
+
+  /**
+   * @brief Removes the oldest record. Only called by the consumer.
+   *
+   * @param record Receives the record.
+   * @return true A record was removed.
+   * @return false The ring was empty.
+   */
+  bool pop(Record& record);
+
+  /**
+   * @brief Determines whether the ring has no records. Only called by the consumer.
+   *
+   * @return true
+   * @return false
+   */
+  bool empty() const;
+
+  /**
+   * @brief Whether the owning thread has exited. The ring is
+   * discarded once it's orphaned and drained.
+   */
+  std::atomic<bool> orphaned{false};
+
+ private:
+  alignas(64) std::atomic<std::size_t> head_{0};
+  alignas(64) std::atomic<std::size_t> tail_{0};
+  std::array<Record, kCapacity> records_;
+};
+
+/**
+ * @brief Owns the per-thread rings and the background formatting thread.
+ */
+class Logger {
+ public:
+  /**
+   * @brief Gets the process wide logger.
+   *
+   * @return Logger&
+   */
+  static Logger& instance();
+
+  ~Logger();
+
+  /**
+   * @brief Starts the background thread. Records written before starting
+   * are kept until the logger is started or flushed.
+   *
+   * @param out Where JSON lines are written.
+   */
+  void start(std::FILE* out = stdout);
+
+  /**
+   * @brief Stops the background thread, if running, and drains every ring.
+   */
+  void stop();
+
+  /**
+   * @brief Synchronously drains every ring on the calling thread.
+   */
+  void flush();
+
+  /**
+   * @brief Sets the minimum level of records that are kept.
+   *
+   * @param level
+   */
+  void set_level(Level level);
+
+  /**
+   * @brief Determines whether records of \p level are kept.
+   *
+   * @param level
+   * @return true
+   * @return false
+   */
+  bool enabled(Level level) const {
+    return level >= level_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Queues a record. Never blocks.
+   *
+   * @param level
+   * @param msg
+   * @param fields
+   */
+  void write(Level level, std::string_view msg, Fields fields);
+
+  /**
+   * @brief Gets the number of records dropped because a ring was full.
+   *
+   * @return uint64_t
+   */
+  uint64_t dropped() const {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  Logger() = default;
+
+  // Gets the calling thread's ring, registering it on first use.
+  RecordRing& local_ring();
+
+  // Formats every queued record. Returns the number of records written.
+  std::size_t drain();
+
+  // The background thread's loop.
+  void run();
+
+  std::atomic<Level> level_{Level::kInfo};
+  std::atomic<uint64_t> dropped_{0};
+
+  // Guards rings_.
+  std::mutex rings_mutex_;
+  std::vector<std::shared_ptr<RecordRing>> rings_;
+
+  // Held while consuming so that flush() and the background thread don't race.
+  std::mutex drain_mutex_;
+  std::FILE* out_ = stdout;
+  std::string line_;
+  uint64_t reported_dropped_ = 0;
+
+  std::mutex run_mutex_;
+  std::condition_variable run_cv_;
+  bool running_ = false;
+  std::thread thread_;
+};
+
+/**
+ * @brief Logs \p msg at Level::kDebug.
+ */
+inline void debug(std::string_view msg, Fields fields = {}) {
+  if (Logger::instance().enabled(Level::kDebug)) {
+    Logger::instance().write(Level::kDebug, msg, fields);
+  }
+}
+
+/**
+ * @brief Logs \p msg at Level::kInfo.
+ */
+inline void info(std::string_view msg, Fields fields = {}) {
+  if (Logger::instance().enabled(Level::kInfo)) {
+    Logger::instance().write(Level::kInfo, msg, fields);
+  }
+}
+
+/**
+ * @brief Logs \p msg at Level::kWarn.
+ */
+inline void warn(std::string_view msg, Fields fields = {}) {
+  if (Logger::instance().enabled(Level::kWarn)) {
+    Logger::instance().write(Level::kWarn, msg, fields);
+  }
+}
+
+/**
+ * @brief Logs \p msg at Level::kError.
+ */
+inline void error(std::string_view msg, Fields fields = {}) {
+  if (Logger::instance().enabled(Level::kError)) {
+    Logger::instance().write(Level::kError, msg, fields);
+  }
+}
+
+}  // namespace io_blair::logging
@@ -1,21 +1,54 @@
-#include <cstdint>
 #include <cstdlib>
 #include <iostream>
 #include <memory>
-#include <thread>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
 
+#include "config.hpp"
+#include "logging.hpp"
+#include "replay_writer.hpp"
 #include "server.hpp"
+#include "trace.hpp"
 
-int main() {
-  const char* port_str = std::getenv("SERVER_PORT");
-  if (port_str == nullptr) {
-    std::cerr << "Set SERVER_PORT env to run server.\n";
-    return 0;
+int main(int argc, char** argv) {
+  // Kept to load the config again on SIGHUP.
+  const std::vector<std::string> args(argv + 1, argv + argc);
+
+  std::string error;
+  auto config = io_blair::load_config(args, error);
+  if (!config) {
+    std::cerr << error << "\n";
+    return EXIT_FAILURE;
+  }
+
+  auto& logger = io_blair::logging::Logger::instance();
+  logger.set_level(config->log_level);
+  logger.start();
+
+  // Optional sampled tracing, dumped to trace_file on SIGUSR1.
+  io_blair::trace::Tracer::instance().set_sample_every(config->trace_sample_every);
+  if (!config->trace_file.empty()) {
+    io_blair::trace::Tracer::instance().set_dump_path(config->trace_file);
+  }
+
+  // Optional recording of every game, appended to replay_file.
+  auto& replays = io_blair::replay::Writer::instance();
+  if (!config->replay_file.empty() && !replays.start(config->replay_file)) {
+    io_blair::logging::warn("Couldn't open replay file");
   }
 
-  constexpr const char* kAddress = "0.0.0.0";
-  const auto port                = static_cast<uint16_t>(std::atoi(port_str));
-  const auto threads             = std::thread::hardware_concurrency();
+  auto reload = [args]() -> std::optional<io_blair::Config> {
+    std::string error;
+    auto config = io_blair::load_config(args, error);
+    if (!config) {
+      io_blair::logging::warn(error);
+    }
+    return config;
+  };
+  std::make_shared<io_blair::Server>(*std::move(config), std::move(reload))->run();
 
-  std::make_shared<io_blair::Server>(kAddress, port, threads)->run();
+  replays.stop();
+  logger.stop();
 }
@@ -242,6 +242,16 @@ class Cell {
     return bits_[kCoinIdx];
   }
 
+  /**
+   * @brief Gets every flag of this cell as stored, which Cell(std::bitset<9>)
+   * takes back. Unlike serialize_for, nothing is left out for either character.
+   *
+   * @return uint16_t
+   */
+  uint16_t bits() const {
+    return static_cast<uint16_t>(bits_.to_ulong());
+  }
+
   /**
    * @brief Changes whether the character represented by \p dir
    * can see the path in that direction.
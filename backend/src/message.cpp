@@ -0,0 +1,108 @@
+#include "message.hpp"
+
+#include <array>
+#include <cstring>
+#include <new>
+#include <vector>
+
+
+namespace io_blair {
+namespace {
+// Payload capacities of the pooled block sizes. Nearly every message fits in
+// the first. Only mazes and long chat messages need bigger blocks, and those
+// larger than the last class are allocated individually.
+constexpr std::array<std::size_t, 2> kClassCapacity = {256, 1024};
+constexpr uint8_t kUnpooled                         = kClassCapacity.size();
+
+// The most free blocks a thread keeps per class. Anything above is deleted.
+constexpr std::size_t kMaxFreePerClass = 256;
+
+// Set once the calling thread's pool has been destroyed, so that messages
+// released during thread exit are deleted rather than pooled.
+thread_local bool pool_destroyed = false;
+
+/**
+ * @brief Free blocks of the calling thread. Blocks go back to the pool of
+ * whichever thread drops the last reference, which is usually the thread
+ * that will encode the next message.
+ */
+struct Pool {
+  std::array<std::vector<void*>, kClassCapacity.size()> free;
+
+  ~Pool() {
+    pool_destroyed = true;
+    for (auto& blocks : free) {
+      for (void* block : blocks) {
+        ::operator delete(block);
+      }
+    }
+  }
+};
+
+Pool* pool() {
+  if (pool_destroyed) {
+    return nullptr;
+  }
+  thread_local Pool pool;
+  return &pool;
+}
+
+uint8_t size_class(std::size_t capacity) {
+  for (uint8_t i = 0; i < kClassCapacity.size(); ++i) {
+    if (capacity <= kClassCapacity[i]) {
+      return i;
+    }
+  }
+  return kUnpooled;
+}
+}  // namespace
+
+Message::Message(std::string_view payload)
+    : Message(build(payload.size(), [payload](char* out) {
+        std::memcpy(out, payload.data(), payload.size());
+        return payload.size();
+      })) {}
+
+Message Message::make_static(std::string_view payload) {
+  Message msg(payload);
+  msg.block_->immortal = true;
+  return msg;
+}
+
+Message::Block* Message::allocate(std::size_t capacity) {
+  const uint8_t cls = size_class(capacity);
+  if (cls != kUnpooled) {
+    capacity = kClassCapacity[cls];
+  }
+
+  void* mem = nullptr;
+  if (Pool* p = pool(); p != nullptr && cls != kUnpooled && !p->free[cls].empty()) {
+    mem = p->free[cls].back();
+    p->free[cls].pop_back();
+  } else {
+    mem = ::operator new(sizeof(Block) + capacity);
+  }
+
+  return new (mem) Block{.refs       = 1,
+                         .size       = 0,
+                         .capacity   = static_cast<uint32_t>(capacity),
+                         .size_class = cls,
+                         .immortal   = false};
+}
+
+void Message::deallocate(Block* block) noexcept {
+  const uint8_t cls = block->size_class;
+  block->~Block();
+
+  if (Pool* p = pool(); p != nullptr && cls != kUnpooled && p->free[cls].size() < kMaxFreePerClass) {
+    try {
+      p->free[cls].push_back(block);
+      return;
+    } catch (const std::bad_alloc&) {
+      // Fall through and free the block instead.
+    }
+  }
+  ::operator delete(block);
+}
+
+}  // namespace io_blair
@@ -0,0 +1,182 @@
+/**
+ * @file message.hpp
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+#include <utility>
+
+namespace io_blair {
+/**
+ * @brief An immutable, reference counted buffer holding an encoded message.
+ *
+ * The reference count and the payload share one block, so a message costs at
+ * most one allocation. Small blocks are recycled through a per-thread pool,
+ * making that allocation free on pool hits. Copies share the block and are
+ * safe to hand to other threads.
+ */
+class Message {
+ public:
+  /**
+   * @brief Construct an empty Message.
+   */
+  Message() noexcept = default;
+
+  /**
+   * @brief Construct a new Message holding a copy of \p payload.
+   *
+   * @param payload
+   */
+  explicit Message(std::string_view payload);
+
+  /**
+   * @brief Creates a Message that is never freed and whose copies skip the
+   * reference count. Meant for function-local statics of fixed messages.
+   *
+   * @param payload
+   * @return Message
+   */
+  static Message make_static(std::string_view payload);
+
+  /**
+   * @brief Creates a Message by letting \p fill write the payload in place.
+   *
+   * @param capacity The most bytes \p fill may write.
+   * @param fill Called with a char* to \p capacity writable bytes. Returns the
+   * number of bytes written.
+   * @return Message
+   */
+  template <typename Fill>
+  static Message build(std::size_t capacity, Fill&& fill) {
+    Message msg(allocate(capacity));
+    msg.block_->size = static_cast<uint32_t>(std::forward<Fill>(fill)(msg.block_->data()));
+    return msg;
+  }
+
+  Message(const Message& other) noexcept
+      : block_(other.block_) {
+    retain();
+  }
+
+  Message(Message&& other) noexcept
+      : block_(std::exchange(other.block_, nullptr)) {}
+
+  Message& operator=(const Message& other) noexcept {
+    Message(other).swap(*this);
+    return *this;
+  }
+
+  Message& operator=(Message&& other) noexcept {
+    Message(std::move(other)).swap(*this);
+    return *this;
+  }
+
+  ~Message() {
+    release();
+  }
+
+  void swap(Message& other) noexcept {
+    std::swap(block_, other.block_);
+  }
+
+  /**
+   * @brief Gets the payload. Empty if the Message is empty.
+   *
+   * @return const char*
+   */
+  const char* data() const noexcept {
+    return block_ != nullptr ? block_->data() : "";
+  }
+
+  /**
+   * @brief Gets the payload's size in bytes.
+   *
+   * @return std::size_t
+   */
+  std::size_t size() const noexcept {
+    return block_ != nullptr ? block_->size : 0;
+  }
+
+  /**
+   * @brief Determines whether the payload is empty.
+   *
+   * @return true
+   * @return false
+   */
+  bool empty() const noexcept {
+    return size() == 0;
+  }
+
+  /**
+   * @brief Gets the payload as a string_view.
+   *
+   * @return std::string_view
+   */
+  std::string_view view() const noexcept {
+    return {data(), size()};
+  }
+
+  // NOLINTNEXTLINE(google-explicit-constructor)
+  operator std::string_view() const noexcept {
+    return view();
+  }
+
+  friend bool operator==(const Message& lhs, const Message& rhs) noexcept {
+    return lhs.view() == rhs.view();
+  }
+
+  friend bool operator==(const Message& lhs, std::string_view rhs) noexcept {
+    return lhs.view() == rhs;
+  }
+
+  friend std::ostream& operator<<(std::ostream& out, const Message& msg) {
+    return out << msg.view();
+  }
+
+ private:
+  // The header in front of every payload.
+  struct Block {
+    std::atomic<uint32_t> refs;
+    uint32_t size;
+    uint32_t capacity;
+    // Index of the pool the block returns to. See message.cpp.
+    uint8_t size_class;
+    // Immortal blocks are never freed and aren't reference counted.
+    bool immortal;
+
+    char* data() noexcept {
+      return reinterpret_cast<char*>(this + 1);
+    }
+  };
+
+  explicit Message(Block* block) noexcept
+      : block_(block) {}
+
+  // Gets a block with room for capacity bytes and a reference count of 1.
+  static Block* allocate(std::size_t capacity);
+
+  // Returns a block whose reference count reached 0.
+  static void deallocate(Block* block) noexcept;
+
+  void retain() const noexcept {
+    if (block_ != nullptr && !block_->immortal) {
+      block_->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  void release() noexcept {
+    if (block_ != nullptr && !block_->immortal
+        && block_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      deallocate(block_);
+    }
+    block_ = nullptr;
+  }
+
+  Block* block_ = nullptr;
+};
+
+}  // namespace io_blair
@@ -0,0 +1,149 @@
+#include "metrics.hpp"
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+
+namespace io_blair {
+using std::make_shared;
+using std::shared_ptr;
+using std::string;
+using std::string_view;
+
+namespace {
+// The label of each CloseReason.
+constexpr std::array<string_view, static_cast<std::size_t>(CloseReason::kCount)>
+    kCloseReasonLabels = {"upgrade_timeout", "handshake_timeout", "idle_timeout",
+                          "write_stall",     "oversized",         "going_away"};
+
+// Appends a single metric family with one sample.
+void write_metric(string& out, string_view name, string_view type, string_view help,
+                  auto value) {
+  out.append("# HELP ").append(name).append(" ").append(help).append("\n");
+  out.append("# TYPE ").append(name).append(" ").append(type).append("\n");
+  out.append(name).append(" ").append(std::to_string(value)).append("\n");
+}
+
+// Appends a metric family with one sample per label value.
+template <std::size_t N>
+void write_labeled(string& out, string_view name, string_view type, string_view help,
+                   string_view label, const std::array<string_view, N>& values,
+                   const std::array<Counter, N>& counters) {
+  out.append("# HELP ").append(name).append(" ").append(help).append("\n");
+  out.append("# TYPE ").append(name).append(" ").append(type).append("\n");
+  for (std::size_t i = 0; i < N; ++i) {
+    out.append(name).append("{").append(label).append("=\"").append(values[i]).append("\"} ");
+    out.append(std::to_string(counters[i].value())).append("\n");
+  }
+}
+
+// Appends a histogram family with cumulative buckets, the sum and the count.
+template <std::size_t N>
+void write_histogram(string& out, string_view name, string_view help,
+                     const Histogram<N>& histogram) {
+  out.append("# HELP ").append(name).append(" ").append(help).append("\n");
+  out.append("# TYPE ").append(name).append(" histogram\n");
+
+  uint64_t cumulative = 0;
+  for (std::size_t i = 0; i <= N; ++i) {
+    cumulative += histogram.bucket(i);
+    const string le = i < N ? std::to_string(histogram.bounds()[i]) : "+Inf";
+    out.append(name).append("_bucket{le=\"").append(le).append("\"} ");
+    out.append(std::to_string(cumulative)).append("\n");
+  }
+  out.append(name).append("_sum ").append(std::to_string(histogram.sum())).append("\n");
+  out.append(name).append("_count ").append(std::to_string(cumulative)).append("\n");
+}
+}  // namespace
+
+Metrics& Metrics::instance() {
+  static Metrics metrics;
+  return metrics;
+}
+
+Metrics::Metrics()
+    : snapshot_(make_shared<const string>()) {}
+
+string Metrics::render() const {
+  string out;
+  out.reserve(4096);
+
+  write_metric(out, "io_blair_sessions_active", "gauge", "Websocket sessions currently alive.",
+               sessions_active.value());
+  write_metric(out, "io_blair_sessions_total", "counter", "Websocket sessions created.",
+               sessions_total.value());
+  write_metric(out, "io_blair_lobbies_active", "gauge", "Lobbies currently open.",
+               lobbies_active.value());
+  write_metric(out, "io_blair_sessions_suspended_total", "counter",
+               "Sessions that dropped while in a lobby and had their place held.",
+               sessions_suspended.value());
+  write_metric(out, "io_blair_sessions_resumed_total", "counter",
+               "Suspended places taken back by a new session.", sessions_resumed.value());
+  write_metric(out, "io_blair_resumes_expired_total", "counter",
+               "Suspended places given up after their grace period.", resumes_expired.value());
+  write_metric(out, "io_blair_lobbies_reaped_total", "counter",
+               "Lobbies closed for being empty or idle.", lobbies_reaped.value());
+  write_metric(out, "io_blair_lobbies_restored_total", "counter",
+               "Lobbies rebuilt from a snapshot taken before a restart.", lobbies_restored.value());
+  write_metric(out, "io_blair_lobby_bytes_reclaimed_total", "counter",
+               "Approximate bytes of lobby state freed by closing empty or idle lobbies.",
+               lobby_bytes_reclaimed.value());
+  write_metric(out, "io_blair_lobby_timers", "gauge", "Pending lobby timers.",
+               lobby_timers.value());
+  write_metric(out, "io_blair_spectators_active", "gauge", "Sessions spectating a lobby.",
+               spectators_active.value());
+  write_metric(out, "io_blair_matchmaking_queue_depth", "gauge",
+               "Sessions waiting in the matchmaking queue.", matchmaking_queue_depth.value());
+  write_metric(out, "io_blair_matches_made_total", "counter",
+               "Lobbies created by matchmaking.", matches_made.value());
+  write_histogram(out, "io_blair_matchmaking_wait_seconds",
+                  "Time matched sessions waited in the matchmaking queue.",
+                  matchmaking_wait_seconds);
+  write_metric(out, "io_blair_messages_received_total", "counter",
+               "Websocket messages read from clients.", messages_received.value());
+  write_metric(out, "io_blair_messages_spilled_total", "counter",
+               "Websocket messages too big for the session's inline buffer.",
+               messages_spilled.value());
+  write_metric(out, "io_blair_messages_oversized_total", "counter",
+               "Websocket messages over the size limit. The connection is closed.",
+               messages_oversized.value());
+  write_metric(out, "io_blair_messages_rejected_total", "counter",
+               "Websocket messages dropped for being larger than their type allows.",
+               messages_rejected.value());
+  write_metric(out, "io_blair_pings_fast_path_total", "counter",
+               "JSON pings answered without being decoded.", pings_fast_path.value());
+  write_metric(out, "io_blair_messages_sent_total", "counter",
+               "Websocket messages written to clients.", messages_sent.value());
+  write_metric(out, "io_blair_http_requests_total", "counter",
+               "Plain HTTP requests answered on the game port.", http_requests.value());
+  write_metric(out, "io_blair_connections_rejected_total", "counter",
+               "Connections turned away by admission control.", connections_rejected.value());
+  write_labeled(out, "io_blair_connections_closed_total", "counter",
+                "Connections closed by the server, by reason.", "reason", kCloseReasonLabels,
+                connections_closed);
+  write_metric(out, "io_blair_log_records_dropped_total", "counter",
+               "Log records dropped because the logging backend fell behind.",
+               log_records_dropped.value());
+  write_metric(out, "io_blair_replay_games_written_total", "counter",
+               "Game records written to the replay log.", replay_games_written.value());
+  write_metric(out, "io_blair_replay_bytes_written_total", "counter",
+               "Bytes written to the replay log.", replay_bytes_written.value());
+  write_metric(out, "io_blair_replay_games_dropped_total", "counter",
+               "Game records dropped because the replay writer fell behind.",
+               replay_games_dropped.value());
+
+  return out;
+}
+
+void Metrics::refresh() {
+  snapshot_.store(make_shared<const string>(render()));
+}
+
+shared_ptr<const string> Metrics::snapshot() const {
+  return snapshot_.load();
+}
+
+}  // namespace io_blair
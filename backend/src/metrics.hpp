@@ -0,0 +1,349 @@
+/**
+ * @file metrics.hpp
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace io_blair {
+/**
+ * @brief Size used to keep independently updated metrics on separate cache lines.
+ */
+inline constexpr std::size_t kCacheLineSize = 64;
+
+/**
+ * @brief A monotonically increasing value. Safe to update from any thread.
+ */
+class alignas(kCacheLineSize) Counter {
+ public:
+  /**
+   * @brief Increments the counter.
+   *
+   * @param n The amount to increment by.
+   */
+  void inc(uint64_t n = 1) noexcept {
+    value_.fetch_add(n, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Gets the current value.
+   *
+   * @return uint64_t
+   */
+  uint64_t value() const noexcept {
+    return value_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  std::atomic<uint64_t> value_{0};
+};
+
+/**
+ * @brief A value that may go up and down. Safe to update from any thread.
+ */
+class alignas(kCacheLineSize) Gauge {
+ public:
+  /**
+   * @brief Increments the gauge.
+   *
+   * @param n The amount to increment by.
+   */
+  void inc(int64_t n = 1) noexcept {
+    value_.fetch_add(n, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Decrements the gauge.
+   *
+   * @param n The amount to decrement by.
+   */
+  void dec(int64_t n = 1) noexcept {
+    value_.fetch_sub(n, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Overwrites the current value.
+   *
+   * @param value The new value.
+   */
+  void set(int64_t value) noexcept {
+    value_.store(value, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Gets the current value.
+   *
+   * @return int64_t
+   */
+  int64_t value() const noexcept {
+    return value_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  std::atomic<int64_t> value_{0};
+};
+
+/**
+ * @brief Why the server closed a connection. Counted by Metrics::closed().
+ */
+enum class CloseReason : uint8_t {
+  /**
+   * @brief The client didn't send its HTTP request in time.
+   */
+  kUpgradeTimeout,
+  /**
+   * @brief The websocket handshake didn't finish in time.
+   */
+  kHandshakeTimeout,
+  /**
+   * @brief Nothing was received from the client in time.
+   */
+  kIdleTimeout,
+  /**
+   * @brief A write to the client made no progress in time.
+   */
+  kWriteStall,
+  /**
+   * @brief The client sent a message over the size limit.
+   */
+  kOversized,
+  /**
+   * @brief The server is shutting down.
+   */
+  kGoingAway,
+  kCount,
+};
+
+/**
+ * @brief Counts observations into fixed buckets. Safe to update from any thread.
+ *
+ * @tparam N The number of buckets, not counting the implicit +Inf bucket.
+ */
+template <std::size_t N>
+class alignas(kCacheLineSize) Histogram {
+ public:
+  /**
+   * @brief Construct a new Histogram.
+   *
+   * @param bounds The inclusive upper bound of each bucket, in increasing order.
+   */
+  explicit constexpr Histogram(const std::array<double, N>& bounds)
+      : bounds_(bounds) {}
+
+  /**
+   * @brief Records \p value.
+   *
+   * @param value
+   */
+  void observe(double value) noexcept {
+    std::size_t i = 0;
+    while (i < N && value > bounds_[i]) {
+      ++i;
+    }
+    buckets_[i].fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Gets the bucket bounds.
+   *
+   * @return const std::array<double, N>&
+   */
+  const std::array<double, N>& bounds() const noexcept {
+    return bounds_;
+  }
+
+  /**
+   * @brief Gets the number of observations in bucket \p i alone. Bucket N
+   * holds those above every bound.
+   *
+   * @param i
+   * @return uint64_t
+   */
+  uint64_t bucket(std::size_t i) const noexcept {
+    return buckets_[i].load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Gets the sum of every observation.
+   *
+   * @return double
+   */
+  double sum() const noexcept {
+    return sum_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  const std::array<double, N> bounds_;
+  std::array<std::atomic<uint64_t>, N + 1> buckets_{};
+  std::atomic<double> sum_{0};
+};
+
+/**
+ * @brief Process wide server metrics. Metrics are updated in place by the
+ * parts of the server they describe and are periodically rendered into a
+ * preformatted snapshot so that readers never contend with the hot path.
+ */
+class Metrics {
+ public:
+  /**
+   * @brief Gets the process wide metrics.
+   *
+   * @return Metrics&
+   */
+  static Metrics& instance();
+
+  /**
+   * @brief Renders every metric in the Prometheus text exposition format.
+   *
+   * @return std::string
+   */
+  std::string render() const;
+
+  /**
+   * @brief Re-renders the snapshot returned by Metrics::snapshot().
+   */
+  void refresh();
+
+  /**
+   * @brief Gets the most recently rendered snapshot. Cheap enough to call per request.
+   *
+   * @return std::shared_ptr<const std::string>
+   */
+  std::shared_ptr<const std::string> snapshot() const;
+
+  /**
+   * @brief Gets the counter of connections closed for \p reason.
+   *
+   * @param reason
+   * @return Counter&
+   */
+  Counter& closed(CloseReason reason) noexcept {
+    return connections_closed[static_cast<std::size_t>(reason)];
+  }
+
+  /**
+   * @brief Number of websocket sessions currently alive.
+   */
+  Gauge sessions_active;
+  /**
+   * @brief Number of websocket sessions created since startup.
+   */
+  Counter sessions_total;
+  /**
+   * @brief Number of lobbies currently held by the lobby manager.
+   */
+  Gauge lobbies_active;
+  /**
+   * @brief Number of sessions that dropped while in a lobby and had their place held.
+   */
+  Counter sessions_suspended;
+  /**
+   * @brief Number of suspended places taken back by a new session.
+   */
+  Counter sessions_resumed;
+  /**
+   * @brief Number of suspended places given up after their grace period.
+   */
+  Counter resumes_expired;
+  /**
+   * @brief Number of lobbies closed for being empty or idle.
+   */
+  Counter lobbies_reaped;
+  /**
+   * @brief Number of lobbies rebuilt from a snapshot taken before a restart.
+   */
+  Counter lobbies_restored;
+  /**
+   * @brief Approximate bytes of lobby state freed by closing empty or idle lobbies.
+   */
+  Counter lobby_bytes_reclaimed;
+  /**
+   * @brief Number of pending lobby timers, i.e. reaper checks and resume grace periods.
+   */
+  Gauge lobby_timers;
+  /**
+   * @brief Number of sessions spectating a lobby.
+   */
+  Gauge spectators_active;
+  /**
+   * @brief Number of sessions waiting in the matchmaking queue.
+   */
+  Gauge matchmaking_queue_depth;
+  /**
+   * @brief Number of lobbies created by matchmaking.
+   */
+  Counter matches_made;
+  /**
+   * @brief How long matched sessions waited in the matchmaking queue, in seconds.
+   */
+  Histogram<8> matchmaking_wait_seconds{
+      {0.1, 0.5, 1, 2.5, 5, 10, 30, 60}
+  };
+  /**
+   * @brief Number of websocket messages read from clients.
+   */
+  Counter messages_received;
+  /**
+   * @brief Number of websocket messages that didn't fit the session's inline buffer.
+   */
+  Counter messages_spilled;
+  /**
+   * @brief Number of websocket messages larger than json::in::kMaxMessageSize.
+   * The connection is closed.
+   */
+  Counter messages_oversized;
+  /**
+   * @brief Number of websocket messages dropped for being larger than their
+   * type allows.
+   */
+  Counter messages_rejected;
+  /**
+   * @brief Number of JSON pings answered without being decoded.
+   */
+  Counter pings_fast_path;
+  /**
+   * @brief Number of websocket messages written to clients.
+   */
+  Counter messages_sent;
+  /**
+   * @brief Number of plain HTTP requests answered without a websocket upgrade.
+   */
+  Counter http_requests;
+  /**
+   * @brief Number of connections turned away by admission control.
+   */
+  Counter connections_rejected;
+  /**
+   * @brief Number of connections the server closed, indexed by CloseReason.
+   */
+  std::array<Counter, static_cast<std::size_t>(CloseReason::kCount)> connections_closed;
+  /**
+   * @brief Number of log records dropped because the logging backend fell behind.
+   */
+  Counter log_records_dropped;
+  /**
+   * @brief Number of game records written to the replay log.
+   */
+  Counter replay_games_written;
+  /**
+   * @brief Number of bytes written to the replay log.
+   */
+  Counter replay_bytes_written;
+  /**
+   * @brief Number of game records dropped because the replay writer fell behind.
+   */
+  Counter replay_games_dropped;
+
+ private:
+  Metrics();
+
+  std::atomic<std::shared_ptr<const std::string>> snapshot_;
+};
+
+}  // namespace io_blair
@@ -0,0 +1,81 @@
+#include "pool_allocator.hpp"
+
+#include <array>
+#include <bit>
+#include <vector>
+
+
+namespace io_blair::block_pool {
+namespace {
+// Size classes are powers of two from kMinBlock to kMaxBlock. Larger requests
+// go straight to operator new.
+constexpr std::size_t kMinBlock = 64;
+constexpr std::size_t kMaxBlock = 64 * 1024;
+constexpr std::size_t kClasses  = std::countr_zero(kMaxBlock / kMinBlock) + 1;
+
+// The most free blocks a thread keeps per class. Anything above is deleted.
+constexpr std::size_t kMaxFreePerClass = 64;
+
+// Set once the calling thread's pool has been destroyed, so that blocks
+// freed during thread exit are deleted rather than pooled.
+thread_local bool pool_destroyed = false;
+
+struct Pool {
+  std::array<std::vector<void*>, kClasses> free;
+
+  ~Pool() {
+    pool_destroyed = true;
+    for (auto& blocks : free) {
+      for (void* block : blocks) {
+        ::operator delete(block);
+      }
+    }
+  }
+};
+
+Pool* pool() {
+  if (pool_destroyed) {
+    return nullptr;
+  }
+  thread_local Pool pool;
+  return &pool;
+}
+
+std::size_t size_class(std::size_t size) {
+  if (size <= kMinBlock) {
+    return 0;
+  }
+  return std::bit_width(size - 1) - std::countr_zero(kMinBlock);
+}
+}  // namespace
+
+void* allocate(std::size_t size) {
+  if (size > kMaxBlock) {
+    return ::operator new(size);
+  }
+
+  const std::size_t cls = size_class(size);
+  if (Pool* p = pool(); p != nullptr && !p->free[cls].empty()) {
+    void* block = p->free[cls].back();
+    p->free[cls].pop_back();
+    return block;
+  }
+  return ::operator new(kMinBlock << cls);
+}
+
+void deallocate(void* ptr, std::size_t size) noexcept {
+  if (size <= kMaxBlock) {
+    const std::size_t cls = size_class(size);
+    if (Pool* p = pool(); p != nullptr && p->free[cls].size() < kMaxFreePerClass) {
+      try {
+        p->free[cls].push_back(ptr);
+        return;
+      } catch (const std::bad_alloc&) {
+        // Fall through and free the block instead.
+      }
+    }
+  }
+  ::operator delete(ptr);
+}
+
+}  // namespace io_blair::block_pool
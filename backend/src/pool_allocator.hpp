@@ -0,0 +1,67 @@
+/**
+ * @file pool_allocator.hpp
+ */
+#pragma once
+
+#include <cstddef>
+#include <new>
+
+
+namespace io_blair {
+/**
+ * @brief Per-thread free lists of memory blocks grouped by size. Freed blocks
+ * are kept by the freeing thread and handed out again for the next request of
+ * the same size class, so objects that are repeatedly created and destroyed
+ * stop going through the global allocator once their threads are warm.
+ */
+namespace block_pool {
+/**
+ * @brief Allocates at least \p size bytes.
+ *
+ * @param size
+ * @return void*
+ */
+void* allocate(std::size_t size);
+
+/**
+ * @brief Frees memory returned by allocate().
+ *
+ * @param ptr
+ * @param size The size passed to allocate().
+ */
+void deallocate(void* ptr, std::size_t size) noexcept;
+}  // namespace block_pool
+
+/**
+ * @brief An allocator backed by block_pool.
+ *
+ * @tparam T
+ */
+template <typename T>
+class PoolAllocator {
+ public:
+  static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__,
+                "block_pool only guarantees operator new's alignment");
+
+  using value_type = T;
+
+  PoolAllocator() noexcept = default;
+
+  template <typename U>
+  PoolAllocator(const PoolAllocator<U>&) noexcept {}  // NOLINT(google-explicit-constructor)
+
+  T* allocate(std::size_t n) {
+    return static_cast<T*>(block_pool::allocate(n * sizeof(T)));
+  }
+
+  void deallocate(T* ptr, std::size_t n) noexcept {
+    block_pool::deallocate(ptr, n * sizeof(T));
+  }
+
+  template <typename U>
+  bool operator==(const PoolAllocator<U>&) const noexcept {
+    return true;
+  }
+};
+
+}  // namespace io_blair
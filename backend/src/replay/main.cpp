@@ -0,0 +1,104 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string_view>
+#include <vector>
+
+#include "lobby_controller.hpp"
+#include "replay.hpp"
+
+namespace {
+using io_blair::replay::Game;
+using io_blair::replay::Reader;
+using io_blair::replay::Verdict;
+using Maze         = io_blair::LobbyController::Maze;
+namespace chrono = std::chrono;
+
+constexpr const char* kUsage =
+    "Usage: io_blair_server_replay [--verbose] <replay log>...\n"
+    "Reconstructs every game in the logs and verifies it could have been\n"
+    "played as recorded. Exits with 1 if any game fails.\n";
+
+struct Totals {
+  std::size_t games   = 0;
+  std::size_t events  = 0;
+  std::size_t failed  = 0;
+  std::size_t corrupt = 0;
+};
+
+// Verifies every game in the log at path, adding to totals.
+void replay_file(const char* path, bool verbose, Totals& totals) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    std::cerr << path << ": couldn't open\n";
+    ++totals.corrupt;
+    return;
+  }
+  const std::vector<uint8_t> log{std::istreambuf_iterator<char>(file),
+                                 std::istreambuf_iterator<char>()};
+
+  Reader reader(log);
+  Game game;
+  std::size_t offset = reader.offset();
+  while (reader.next(game)) {
+    ++totals.games;
+    totals.events += game.events.size();
+
+    if (const Verdict verdict = io_blair::replay::verify<Maze::rows(), Maze::cols()>(game);
+        !verdict.ok) {
+      ++totals.failed;
+      if (verbose) {
+        std::cout << path << ": game at offset " << offset << " failed at event "
+                  << verdict.event << ": " << verdict.reason << '\n';
+      }
+    }
+    offset = reader.offset();
+  }
+
+  if (!reader.error().empty()) {
+    ++totals.corrupt;
+    std::cerr << path << ": " << reader.error() << " at offset " << reader.offset() << '\n';
+  }
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  bool verbose = false;
+  std::vector<const char*> paths;
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view arg = argv[i];
+    if (arg == "--verbose" || arg == "-v") {
+      verbose = true;
+    } else if (arg == "--help" || arg == "-h") {
+      std::cout << kUsage;
+      return 0;
+    } else {
+      paths.push_back(argv[i]);
+    }
+  }
+  if (paths.empty()) {
+    std::cerr << kUsage;
+    return 2;
+  }
+
+  Totals totals;
+  const auto start = chrono::steady_clock::now();
+  for (const char* path : paths) {
+    replay_file(path, verbose, totals);
+  }
+  const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+  // A log too small to time has no meaningful rate.
+  const uint64_t rate
+      = elapsed.count() > 0 ? static_cast<uint64_t>(totals.events / elapsed.count()) : 0;
+
+  std::cout << "games=" << totals.games << " events=" << totals.events
+            << " failed=" << totals.failed << " corrupt=" << totals.corrupt
+            << " seconds=" << elapsed.count()
+            << " events_per_second=" << rate
+            << '\n';
+
+  return totals.failed == 0 && totals.corrupt == 0 ? 0 : 1;
+}
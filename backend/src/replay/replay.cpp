@@ -0,0 +1,161 @@
+#include "replay.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+
+namespace io_blair::replay {
+using std::vector;
+namespace chrono = std::chrono;
+
+namespace {
+// The offset of the event count, which is only known once the game ends.
+constexpr std::size_t kEventCountOffset = 24;
+
+void put_u32(uint8_t* out, uint32_t value) {
+  for (int i = 0; i < 4; ++i, value >>= 8) {
+    out[i] = static_cast<uint8_t>(value);
+  }
+}
+
+void put_u64(uint8_t* out, uint64_t value) {
+  put_u32(out, static_cast<uint32_t>(value));
+  put_u32(out + 4, static_cast<uint32_t>(value >> 32));
+}
+
+uint16_t get_u16(const uint8_t* in) {
+  return static_cast<uint16_t>(in[0] | (in[1] << 8));
+}
+
+uint32_t get_u32(const uint8_t* in) {
+  return static_cast<uint32_t>(in[0]) | (static_cast<uint32_t>(in[1]) << 8) |
+         (static_cast<uint32_t>(in[2]) << 16) | (static_cast<uint32_t>(in[3]) << 24);
+}
+
+uint64_t get_u64(const uint8_t* in) {
+  return static_cast<uint64_t>(get_u32(in)) | (static_cast<uint64_t>(get_u32(in + 4)) << 32);
+}
+
+Character to_character(uint8_t value) {
+  return value <= static_cast<uint8_t>(Character::Blair) ? static_cast<Character>(value)
+                                                          : Character::unknown;
+}
+}  // namespace
+
+void GameRecorder::begin(int rows, int cols, coordinate start, coordinate end, Character seat0,
+                         Character seat1) {
+  buffer_.assign(kHeaderSize, 0);
+  buffer_.reserve(kHeaderSize + 2 * rows * cols + 64 * kEventSize);
+  started_   = clock::now();
+  events_    = 0;
+  recording_ = true;
+
+  const int64_t started_ms =
+      chrono::duration_cast<chrono::milliseconds>(chrono::system_clock::now().time_since_epoch())
+          .count();
+
+  uint8_t* header = buffer_.data();
+  put_u32(header, kMagic);
+  header[4]  = kVersion;
+  header[5]  = static_cast<uint8_t>(rows);
+  header[6]  = static_cast<uint8_t>(cols);
+  header[7]  = static_cast<uint8_t>(seat0);
+  header[8]  = static_cast<uint8_t>(seat1);
+  header[9]  = static_cast<uint8_t>(start.first);
+  header[10] = static_cast<uint8_t>(start.second);
+  header[11] = static_cast<uint8_t>(end.first);
+  header[12] = static_cast<uint8_t>(end.second);
+  put_u64(header + 16, static_cast<uint64_t>(started_ms));
+}
+
+void GameRecorder::append(EventKind kind, uint8_t seat, coordinate coordinate) {
+  const auto elapsed = chrono::duration_cast<chrono::milliseconds>(clock::now() - started_);
+
+  const std::size_t at = buffer_.size();
+  buffer_.resize(at + kEventSize);
+  uint8_t* event = buffer_.data() + at;
+  put_u32(event, static_cast<uint32_t>(elapsed.count()));
+  event[4] = static_cast<uint8_t>(kind);
+  event[5] = seat;
+  event[6] = static_cast<uint8_t>(coordinate.first);
+  event[7] = static_cast<uint8_t>(coordinate.second);
+  ++events_;
+}
+
+void GameRecorder::put_u16(uint16_t value) {
+  buffer_.push_back(static_cast<uint8_t>(value));
+  buffer_.push_back(static_cast<uint8_t>(value >> 8));
+}
+
+vector<uint8_t> GameRecorder::finish() {
+  if (!std::exchange(recording_, false)) {
+    return {};
+  }
+  put_u32(buffer_.data() + kEventCountOffset, events_);
+  return std::exchange(buffer_, {});
+}
+
+Reader::Reader(std::span<const uint8_t> log)
+    : log_(log) {}
+
+bool Reader::next(Game& game) {
+  error_ = {};
+  const std::size_t left = log_.size() - offset_;
+  if (left == 0) {
+    return false;
+  }
+  if (left < kHeaderSize) {
+    error_ = "truncated header";
+    return false;
+  }
+
+  const uint8_t* header = log_.data() + offset_;
+  if (get_u32(header) != kMagic) {
+    error_ = "bad magic";
+    return false;
+  }
+  if (header[4] != kVersion) {
+    error_ = "unsupported version";
+    return false;
+  }
+
+  game.rows          = header[5];
+  game.cols          = header[6];
+  game.characters[0] = to_character(header[7]);
+  game.characters[1] = to_character(header[8]);
+  game.start         = {header[9], header[10]};
+  game.end           = {header[11], header[12]};
+  game.started_ms    = static_cast<int64_t>(get_u64(header + 16));
+
+  const std::size_t cells  = static_cast<std::size_t>(game.rows) * game.cols;
+  const std::size_t events = get_u32(header + kEventCountOffset);
+  const std::size_t size   = kHeaderSize + 2 * cells + kEventSize * events;
+  if (left < size) {
+    error_ = "truncated record";
+    return false;
+  }
+
+  const uint8_t* in = header + kHeaderSize;
+  game.cells.resize(cells);
+  for (uint16_t& cell : game.cells) {
+    cell = get_u16(in);
+    in += 2;
+  }
+
+  game.events.resize(events);
+  for (Event& event : game.events) {
+    event.time_ms = get_u32(in);
+    event.kind    = static_cast<EventKind>(in[4]);
+    event.seat    = in[5];
+    event.coord   = {in[6], in[7]};
+    in += kEventSize;
+  }
+
+  offset_ += size;
+  return true;
+}
+
+}  // namespace io_blair::replay
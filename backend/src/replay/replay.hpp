@@ -0,0 +1,350 @@
+/**
+ * @file replay.hpp
+ */
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "character.hpp"
+#include "maze.hpp"
+
+/**
+ * @brief Compact binary recordings of played games.
+ *
+ * A replay log is a sequence of game records, each laid out little-endian as:
+ *
+ * | Offset | Size          | Field                                      |
+ * |--------|---------------|--------------------------------------------|
+ * | 0      | 4             | kMagic                                     |
+ * | 4      | 1             | kVersion                                   |
+ * | 5      | 1             | Rows                                       |
+ * | 6      | 1             | Cols                                       |
+ * | 7      | 2             | Character of seat 0 and seat 1             |
+ * | 9      | 4             | Start x, y and end x, y                    |
+ * | 13     | 3             | Reserved, zero                             |
+ * | 16     | 8             | Start of the game, in Unix milliseconds    |
+ * | 24     | 4             | Event count                                |
+ * | 28     | 2 * Rows*Cols | Cell::bits() of every cell, row by row     |
+ * | ...    | 8 * count     | Events, see Event                          |
+ *
+ * Mazes are stored cell by cell rather than as a seed since they're
+ * generated from an unseeded source.
+ */
+namespace io_blair::replay {
+/**
+ * @brief Marks the start of a game record. Reads "IOBR" in the file.
+ */
+inline constexpr uint32_t kMagic = 0x52424F49;
+
+/**
+ * @brief The version of the record layout written.
+ */
+inline constexpr uint8_t kVersion = 1;
+
+/**
+ * @brief The size of a record's fixed header.
+ */
+inline constexpr std::size_t kHeaderSize = 28;
+
+/**
+ * @brief The size of an encoded Event.
+ */
+inline constexpr std::size_t kEventSize = 8;
+
+/**
+ * @brief What happened in an Event.
+ */
+enum class EventKind : uint8_t {
+  /**
+   * @brief The seat moved to the coordinate.
+   */
+  kMove,
+  /**
+   * @brief The seat tried to move to the coordinate and was sent back to the start.
+   */
+  kReset,
+  /**
+   * @brief The seat took the coin at the coordinate.
+   */
+  kCoin,
+  /**
+   * @brief Both seats finished. The coordinate is the maze's end.
+   */
+  kFinish,
+};
+
+/**
+ * @brief Something a player did during a game.
+ */
+struct Event {
+  /**
+   * @brief Milliseconds since the start of the game.
+   */
+  uint32_t time_ms;
+  EventKind kind;
+  /**
+   * @brief 0 for the lobby's first player and 1 for the second.
+   */
+  uint8_t seat;
+  /**
+   * @brief Where the seat moved, tried to move, or took a coin.
+   */
+  coordinate coord;
+
+  bool operator==(const Event&) const = default;
+};
+
+/**
+ * @brief A decoded game record.
+ */
+struct Game {
+  int64_t started_ms = 0;
+  int rows           = 0;
+  int cols           = 0;
+  std::array<Character, 2> characters{};
+  coordinate start;
+  coordinate end;
+  /**
+   * @brief Cell::bits() of every cell, row by row.
+   */
+  std::vector<uint16_t> cells;
+  std::vector<Event> events;
+};
+
+/**
+ * @brief Builds the record of the game being played in a lobby. Not thread-safe.
+ */
+class GameRecorder {
+ public:
+  using clock = std::chrono::steady_clock;
+
+  /**
+   * @brief Starts recording a new game, discarding any unfinished one.
+   *
+   * @param maze The maze at the start of the game.
+   * @param seat0 The character of the lobby's first player.
+   * @param seat1 The character of the lobby's second player.
+   */
+  template <int Rows, int Cols>
+  void begin(const Maze<Rows, Cols>& maze, Character seat0, Character seat1) {
+    begin(Rows, Cols, maze.start(), maze.end(), seat0, seat1);
+    for (int row = 0; row < Rows; ++row) {
+      for (int col = 0; col < Cols; ++col) {
+        put_u16(maze.at(row, col).bits());
+      }
+    }
+  }
+
+  /**
+   * @brief Appends an event to the game being recorded. Does nothing if
+   * no game is being recorded.
+   *
+   * @param kind
+   * @param seat
+   * @param coordinate
+   */
+  void record(EventKind kind, uint8_t seat, coordinate coordinate) {
+    if (recording_) {
+      append(kind, seat, coordinate);
+    }
+  }
+
+  /**
+   * @brief Determines whether a game is being recorded.
+   *
+   * @return true
+   * @return false
+   */
+  bool recording() const {
+    return recording_;
+  }
+
+  /**
+   * @brief Stops recording.
+   *
+   * @return std::vector<uint8_t> The complete record of the game, or
+   * empty if no game was being recorded.
+   */
+  std::vector<uint8_t> finish();
+
+ private:
+  // Writes the header of a game without its cells.
+  void begin(int rows, int cols, coordinate start, coordinate end, Character seat0,
+             Character seat1);
+
+  void append(EventKind kind, uint8_t seat, coordinate coordinate);
+
+  void put_u16(uint16_t value);
+
+  std::vector<uint8_t> buffer_;
+  clock::time_point started_;
+  uint32_t events_ = 0;
+  bool recording_  = false;
+};
+
+/**
+ * @brief Reads game records out of a replay log without copying it.
+ */
+class Reader {
+ public:
+  /**
+   * @brief Construct a new Reader.
+   *
+   * @param log One or more game records. Must outlive the reader.
+   */
+  explicit Reader(std::span<const uint8_t> log);
+
+  /**
+   * @brief Decodes the next record into \p game, reusing its storage.
+   *
+   * @param game
+   * @return true \p game holds the next record.
+   * @return false There are no more records, or the next one is malformed.
+   * See error().
+   */
+  bool next(Game& game);
+
+  /**
+   * @brief Describes why the last call to next() failed, or is empty if
+   * the log ended cleanly.
+   *
+   * @return std::string_view
+   */
+  std::string_view error() const {
+    return error_;
+  }
+
+  /**
+   * @brief Gets the offset of the next record in the log.
+   *
+   * @return std::size_t
+   */
+  std::size_t offset() const {
+    return offset_;
+  }
+
+ private:
+  std::span<const uint8_t> log_;
+  std::size_t offset_ = 0;
+  std::string_view error_;
+};
+
+/**
+ * @brief The result of verifying a game.
+ */
+struct Verdict {
+  /**
+   * @brief Whether the game could have been played as recorded.
+   */
+  bool ok = true;
+  /**
+   * @brief The index of the first event that couldn't have happened.
+   */
+  std::size_t event = 0;
+  /**
+   * @brief Why the event couldn't have happened.
+   */
+  std::string_view reason;
+};
+
+/**
+ * @brief Replays \p game against its maze with the rules LobbyController
+ * enforces, checking every event is what the server would have recorded.
+ *
+ * @tparam Rows The number of rows \p game must have.
+ * @tparam Cols The number of columns \p game must have.
+ * @param game
+ * @return Verdict
+ */
+template <int Rows, int Cols>
+Verdict verify(const Game& game) {
+  using MazeT = Maze<Rows, Cols>;
+
+  if (game.rows != Rows || game.cols != Cols ||
+      game.cells.size() != static_cast<std::size_t>(Rows * Cols)) {
+    return {false, 0, "maze size"};
+  }
+  if (!MazeT::in_range(game.start) || !MazeT::in_range(game.end)) {
+    return {false, 0, "maze bounds"};
+  }
+
+  typename MazeT::template matrix<Cell> cells;
+  for (int row = 0; row < Rows; ++row) {
+    for (int col = 0; col < Cols; ++col) {
+      cells[row][col] = Cell(std::bitset<9>(game.cells[row * Cols + col]));
+    }
+  }
+  MazeT maze(game.start, game.end, cells);
+
+  std::array<coordinate, 2> positions{game.start, game.start};
+  const auto finished = [&] {
+    return positions[0] == maze.end() && positions[1] == maze.end() && !maze.any_coin();
+  };
+
+  uint32_t last_time = 0;
+  bool done          = false;
+  for (std::size_t i = 0; i < game.events.size(); ++i) {
+    const Event& event = game.events[i];
+    const Event* next  = i + 1 < game.events.size() ? &game.events[i + 1] : nullptr;
+
+    if (done) {
+      return {false, i, "event after finish"};
+    }
+    if (event.time_ms < last_time) {
+      return {false, i, "time went backwards"};
+    }
+    last_time = event.time_ms;
+    if (event.seat > 1) {
+      return {false, i, "seat"};
+    }
+    coordinate& position = positions[event.seat];
+
+    switch (event.kind) {
+      case EventKind::kMove:
+        if (!maze.traversable(position, event.coord)) {
+          return {false, i, "move through a wall"};
+        }
+        position = event.coord;
+        // Coins are taken as soon as they're reached.
+        if (maze.at(position).coin() &&
+            (next == nullptr || next->kind != EventKind::kCoin || next->seat != event.seat)) {
+          return {false, i, "coin not taken"};
+        }
+        break;
+      case EventKind::kReset:
+        if (maze.traversable(position, event.coord)) {
+          return {false, i, "reset on an open path"};
+        }
+        position = maze.start();
+        break;
+      case EventKind::kCoin:
+        if (position != event.coord || !maze.at(position).coin()) {
+          return {false, i, "no coin to take"};
+        }
+        maze.take_coin(position);
+        break;
+      case EventKind::kFinish:
+        if (!finished()) {
+          return {false, i, "finish before the end"};
+        }
+        done = true;
+        continue;
+      default: return {false, i, "event kind"};
+    }
+
+    if (finished() && (next == nullptr || next->kind != EventKind::kFinish)) {
+      return {false, i, "finish not recorded"};
+    }
+  }
+
+  return {};
+}
+
+}  // namespace io_blair::replay
@@ -0,0 +1,122 @@
+#include "replay_writer.hpp"
+
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "logging.hpp"
+#include "metrics.hpp"
+
+
+namespace io_blair::replay {
+using std::memory_order_relaxed;
+using std::vector;
+using guard = std::lock_guard<std::mutex>;
+
+Writer& Writer::instance() {
+  static Writer writer;
+  return writer;
+}
+
+Writer::~Writer() {
+  stop();
+}
+
+bool Writer::start(const std::string& path) {
+  guard lock(run_mutex_);
+  if (running_) {
+    return false;
+  }
+
+  {
+    guard drain_lock(drain_mutex_);
+    out_ = std::fopen(path.c_str(), "ab");
+    if (out_ == nullptr) {
+      return false;
+    }
+  }
+  running_ = true;
+  recording_.store(true, memory_order_relaxed);
+  thread_ = std::thread([this] { run(); });
+  return true;
+}
+
+void Writer::stop() {
+  bool was_running = false;
+  {
+    guard lock(run_mutex_);
+    was_running = std::exchange(running_, false);
+  }
+  if (!was_running) {
+    return;
+  }
+
+  recording_.store(false, memory_order_relaxed);
+  run_cv_.notify_all();
+  thread_.join();
+
+  drain();
+  guard drain_lock(drain_mutex_);
+  if (out_ != nullptr) {
+    std::fclose(std::exchange(out_, nullptr));
+  }
+}
+
+void Writer::submit(vector<uint8_t> game) {
+  const std::size_t size = game.size();
+  if (pending_bytes_.fetch_add(size, memory_order_relaxed) + size > kMaxPendingBytes) {
+    pending_bytes_.fetch_sub(size, memory_order_relaxed);
+    Metrics::instance().replay_games_dropped.inc();
+    return;
+  }
+  games_.push(std::move(game));
+}
+
+std::size_t Writer::drain() {
+  guard lock(drain_mutex_);
+
+  batch_.clear();
+  std::size_t count = 0;
+  games_.drain([&](vector<uint8_t>&& game) {
+    batch_.insert(batch_.end(), game.begin(), game.end());
+    ++count;
+  });
+  if (count == 0) {
+    return 0;
+  }
+
+  pending_bytes_.fetch_sub(batch_.size(), memory_order_relaxed);
+  if (out_ == nullptr) {
+    return 0;
+  }
+  const bool written = std::fwrite(batch_.data(), 1, batch_.size(), out_) == batch_.size();
+  if (!written || std::fflush(out_) != 0) {
+    // A full or failing disk won't recover by itself, so stop recording
+    // rather than fail on every batch.
+    logging::error("Failed to write replay log, recording stopped");
+    recording_.store(false, memory_order_relaxed);
+    std::fclose(std::exchange(out_, nullptr));
+    return 0;
+  }
+
+  auto& metrics = Metrics::instance();
+  metrics.replay_games_written.inc(count);
+  metrics.replay_bytes_written.inc(batch_.size());
+  return count;
+}
+
+void Writer::run() {
+  std::unique_lock lock(run_mutex_);
+  while (running_) {
+    lock.unlock();
+    drain();
+    lock.lock();
+
+    // Sleep regardless of what was written so records are batched.
+    run_cv_.wait_for(lock, kFlushInterval, [this] { return !running_; });
+  }
+}
+
+}  // namespace io_blair::replay
@@ -0,0 +1,104 @@
+/**
+ * @file replay_writer.hpp
+ */
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "mailbox.hpp"
+
+namespace io_blair::replay {
+/**
+ * @brief Appends finished game records to a replay log from a background
+ * thread. Lobbies hand records over without waiting on the disk, and the
+ * thread writes whatever has arrived in one batch every kFlushInterval.
+ */
+class Writer {
+ public:
+  /**
+   * @brief How often queued records are written.
+   */
+  static constexpr auto kFlushInterval = std::chrono::milliseconds(100);
+
+  /**
+   * @brief The most bytes of records queued before new ones are dropped.
+   */
+  static constexpr std::size_t kMaxPendingBytes = std::size_t{32} << 20;
+
+  /**
+   * @brief Gets the process wide writer.
+   *
+   * @return Writer&
+   */
+  static Writer& instance();
+
+  ~Writer();
+
+  /**
+   * @brief Opens \p path for appending and starts the background thread.
+   * Games are only recorded while the writer is started, and stop being
+   * recorded if writing to \p path fails.
+   *
+   * @param path The replay log.
+   * @return true The writer started.
+   * @return false \p path couldn't be opened, or the writer was already started.
+   */
+  bool start(const std::string& path);
+
+  /**
+   * @brief Stops the background thread, writes every queued record, and closes the log.
+   */
+  void stop();
+
+  /**
+   * @brief Determines whether games should be recorded.
+   *
+   * @return true
+   * @return false
+   */
+  bool recording() const {
+    return recording_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Queues a game record. Never blocks. The record is dropped if
+   * kMaxPendingBytes are already queued.
+   *
+   * @param game A record from GameRecorder::finish().
+   */
+  void submit(std::vector<uint8_t> game);
+
+ private:
+  Writer() = default;
+
+  // Writes every queued record. Returns the number of records written.
+  std::size_t drain();
+
+  // The background thread's loop.
+  void run();
+
+  std::atomic<bool> recording_{false};
+  std::atomic<std::size_t> pending_bytes_{0};
+  Mailbox<std::vector<uint8_t>> games_;
+
+  // Held while consuming so that stop() and the background thread don't race.
+  std::mutex drain_mutex_;
+  std::FILE* out_ = nullptr;
+  std::vector<uint8_t> batch_;
+
+  std::mutex run_mutex_;
+  std::condition_variable run_cv_;
+  bool running_ = false;
+  std::thread thread_;
+};
+
+}  // namespace io_blair::replay
@@ -1,39 +1,110 @@
 #include "server.hpp"
 
+#include <algorithm>
+#include <chrono>
 #include <csignal>
+#include <cstddef>
 #include <cstdint>
+#include <cstdio>
 #include <cstdlib>
-#include <iostream>
+#include <functional>
 #include <memory>
+#include <optional>
+#include <string>
+#include <utility>
 
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "config.hpp"
+#include "handoff.hpp"
+#include "http_session.hpp"
+#include "logging.hpp"
+#include "metrics.hpp"
 #include "session.hpp"
+#include "trace.hpp"
 
 namespace io_blair {
 
-using std::cerr;
 using std::string_view;
 
 namespace ip = net::ip;
 
-Server::Server(string_view address, uint16_t port, uint8_t threads)
-    : acceptor_(ctx_), exit_signals_(ctx_, SIGINT, SIGTERM), threads_(threads) {
-  prepare_acceptor(address, port);
+namespace {
+// How stale the metrics snapshot served over HTTP may be.
+constexpr auto kMetricsRefreshInterval = std::chrono::seconds(1);
+
+// How often a draining server checks whether its sessions have closed.
+constexpr auto kShutdownPollInterval = std::chrono::milliseconds(100);
+}  // namespace
+
+Server::Server(Config config, std::function<std::optional<Config>()> reload)
+    : admission_(config.admission),
+      ctx_(static_cast<int>(config.threads)),
+      strand_(net::make_strand(ctx_)),
+      acceptor_(ctx_),
+      exit_signals_(ctx_, SIGINT, SIGTERM),
+      trace_signals_(ctx_),
+      reload_signals_(ctx_),
+      metrics_timer_(ctx_),
+      lobby_timer_(ctx_),
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+      handoff_acceptor_(ctx_),
+#endif
+      drain_timer_(ctx_),
+      manager_(config.lobby),
+      config_(std::move(config)),
+      reload_(std::move(reload)) {
+  if (!config_.lobby.snapshot_path.empty()) {
+    manager_.restore(config_.lobby.snapshot_path);
+  }
+  if (!adopt_acceptor(config_.address)) {
+    prepare_acceptor(config_.address, config_.port);
+  }
+  prepare_handoff();
   prepare_exit();
+  prepare_trace_dump();
+#ifdef SIGHUP
+  if (reload_) {
+    reload_signals_.add(SIGHUP);
+    wait_reload();
+  }
+#endif
 }
 
 void Server::run() {
-  acceptor_.async_accept(ctx_, beast::bind_front_handler(&Server::on_accept, shared_from_this()));
+  acceptor_.async_accept(
+      ctx_,
+      net::bind_executor(strand_,
+                         beast::bind_front_handler(&Server::on_accept, shared_from_this())));
+  schedule_metrics_refresh();
+  schedule_lobby_timers();
+  wait_handoff();
 
-  if (threads_ > 1) {
-    for (uint8_t i = 0; i < threads_ - 1; ++i) {
-      pool_.emplace_back([self = shared_from_this()] { self->ctx_.run(); });
-    }
+  for (uint32_t i = 1; i < config_.threads; ++i) {
+    pool_.emplace_back([self = shared_from_this(), i] {
+      self->pin_thread(i);
+      self->ctx_.run();
+    });
   }
+  pin_thread(0);
   ctx_.run();
+
+  for (auto& thread : pool_) {
+    thread.join();
+  }
+
+  const std::string& snapshot_path = config_.lobby.snapshot_path;
+  if (!handed_off_ && !snapshot_path.empty() && !manager_.snapshot(snapshot_path)) {
+    logging::warn("Failed to write lobby snapshot");
+  }
 }
 
 void Server::log_fatal(error_code ec, const char* what) {
-  cerr << what << ": " << ec << '\n';
+  logging::error(std::string(what) + ": " + ec.message());
+  logging::Logger::instance().stop();
   exit(EXIT_FAILURE);
 }
 
@@ -56,32 +127,253 @@ void Server::prepare_acceptor(std::string_view address, uint16_t port) {
     log_fatal(ec, "Failed to bind to endpoint");
   }
 
-  acceptor_.listen(net::socket_base::max_listen_connections, ec);
+  const int backlog = config_.listen_backlog == 0 ? net::socket_base::max_listen_connections
+                                                  : static_cast<int>(config_.listen_backlog);
+  acceptor_.listen(backlog, ec);
   if (ec) {
     log_fatal(ec, "Failed to set acceptor to listen state");
   }
 }
 
+bool Server::adopt_acceptor(string_view address) {
+  if (config_.handoff_socket.empty()) {
+    return false;
+  }
+  const int fd = handoff::request_listener(config_.handoff_socket);
+  if (fd < 0) {
+    return false;
+  }
+
+  error_code ec;
+  acceptor_.assign(ip::make_address(address).is_v6() ? tcp::v6() : tcp::v4(), fd, ec);
+  if (ec) {
+    log_fatal(ec, "Failed to adopt handed off acceptor");
+  }
+  logging::info("Took over listening socket from running server");
+  return true;
+}
+
+void Server::prepare_handoff() {
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+  if (config_.handoff_socket.empty()) {
+    return;
+  }
+
+  // Left behind by the server that handed off to this one, or by one that crashed.
+  std::remove(config_.handoff_socket.c_str());
+
+  const net::local::stream_protocol::endpoint endpoint(config_.handoff_socket);
+  error_code ec;
+  handoff_acceptor_.open(endpoint.protocol(), ec);
+  if (!ec) {
+    handoff_acceptor_.bind(endpoint, ec);
+  }
+  if (!ec) {
+    handoff_acceptor_.listen(1, ec);
+  }
+  if (ec) {
+    logging::warn("Failed to listen for handoffs: " + ec.message());
+    handoff_acceptor_.close(ec);
+  }
+#endif
+}
+
+void Server::wait_handoff() {
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+  if (!handoff_acceptor_.is_open()) {
+    return;
+  }
+
+  auto on_handoff = [self = shared_from_this()](error_code ec,
+                                                 net::local::stream_protocol::socket socket) {
+    if (ec) {
+      return;
+    }
+    if (!handoff::send_fd(socket.native_handle(), self->acceptor_.native_handle())) {
+      logging::warn("Failed to hand off listening socket");
+      self->wait_handoff();
+      return;
+    }
+
+    // The next server holds its own copy of the listening socket, so
+    // closing ours only stops this one accepting.
+    logging::info("Handed off listening socket, draining");
+    self->handed_off_ = true;
+    self->stop_accepting();
+    self->shutdown_deadline_
+        = std::chrono::steady_clock::now() + self->config_.session.handoff_drain_timeout;
+    self->drain();
+  };
+  handoff_acceptor_.async_accept(net::bind_executor(strand_, std::move(on_handoff)));
+#endif
+}
+
+void Server::stop_accepting() {
+  error_code ec;
+  acceptor_.close(ec);
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+  handoff_acceptor_.close(ec);
+#endif
+}
+
 void Server::prepare_exit() {
-  exit_signals_.async_wait([this](error_code, int) {
+  exit_signals_.async_wait(net::bind_executor(strand_, [this](error_code ec, int) {
+    if (ec) {
+      return;
+    }
+    logging::info("Shutting down");
+    shut_down();
+  }));
+}
+
+void Server::shut_down() {
+  if (closing_sessions_) {
+    return;
+  }
+  closing_sessions_ = true;
+  stop_accepting();
+  const auto deadline = std::chrono::steady_clock::now() + config_.session.drain_timeout;
+  shutdown_deadline_  = shutdown_deadline_ ? std::min(*shutdown_deadline_, deadline) : deadline;
+  drain();
+}
+
+void Server::drain() {
+  const int64_t remaining = Metrics::instance().sessions_active.value();
+  if (remaining == 0) {
+    ctx_.stop();
+    return;
+  }
+  if (std::chrono::steady_clock::now() >= *shutdown_deadline_) {
+    logging::warn("Drain timed out, dropping " + std::to_string(remaining) + " sessions");
     ctx_.stop();
+    return;
+  }
+  if (remaining != sessions_reported_) {
+    logging::info("Draining, " + std::to_string(remaining) + " sessions remaining");
+    sessions_reported_ = remaining;
+  }
 
-    if (acceptor_.is_open()) {
-      acceptor_.close();
+  if (closing_sessions_) {
+    // Repeated to catch sessions that finished their handshake since.
+    Session::close_all();
+  }
+
+  // Replaces the wait in progress, if any.
+  drain_timer_.expires_after(kShutdownPollInterval);
+  drain_timer_.async_wait(net::bind_executor(strand_, [self = shared_from_this()](error_code ec) {
+    if (!ec) {
+      self->drain();
     }
+  }));
+}
+
+void Server::prepare_trace_dump() {
+#ifdef SIGUSR1
+  trace_signals_.add(SIGUSR1);
+  wait_trace_dump();
+#endif
+}
 
-    for (auto& thread : pool_) {
-      if (thread.joinable()) {
-        thread.join();
-      }
+void Server::wait_trace_dump() {
+  trace_signals_.async_wait([this](error_code ec, int) {
+    if (ec) {
+      return;
     }
+    if (!trace::Tracer::instance().dump()) {
+      logging::warn("Failed to write trace dump");
+    }
+    wait_trace_dump();
   });
 }
 
+void Server::wait_reload() {
+  reload_signals_.async_wait(net::bind_executor(strand_, [this](error_code ec, int) {
+    if (ec) {
+      return;
+    }
+    // load_config() reads files, but reloads are rare and short.
+    if (auto next = reload_()) {
+      apply(*next);
+    } else {
+      logging::warn("Kept running config, reload failed");
+    }
+    wait_reload();
+  }));
+}
+
+void Server::apply(const Config& next) {
+  if (needs_restart(config_, next)) {
+    logging::warn("Some changed settings only take effect on restart");
+  }
+
+  logging::Logger::instance().set_level(next.log_level);
+  trace::Tracer::instance().set_sample_every(next.trace_sample_every);
+  admission_.update(next.admission);
+  config_.log_level          = next.log_level;
+  config_.trace_sample_every = next.trace_sample_every;
+  config_.admission          = next.admission;
+  config_.session            = next.session;
+  logging::info("Reloaded config");
+}
+
+void Server::pin_thread([[maybe_unused]] std::size_t i) const {
+#ifdef __linux__
+  if (config_.cpu_affinity.empty()) {
+    return;
+  }
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  CPU_SET(config_.cpu_affinity[i % config_.cpu_affinity.size()], &cpus);
+  if (pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) != 0) {
+    logging::warn("Failed to pin thread to CPU");
+  }
+#endif
+}
+
 void Server::on_accept(error_code ec, tcp::socket socket) {
   if (!ec) {
-    Session::make(ctx_, std::move(socket), manager_)->run();
+    auto ticket = admission_.admit(Metrics::instance().sessions_active.value());
+    if (ticket.dropped()) {
+      // Enough turned away connections are being answered already, so
+      // this one gets no state at all.
+      Metrics::instance().connections_rejected.inc();
+      error_code ignored;
+      socket.close(ignored);
+    } else {
+      std::make_shared<HttpSession>(
+          ctx_, std::move(socket), manager_, config_.session, std::move(ticket))
+          ->run();
+    }
+  }
+  // Closed on exit or once handed off.
+  if (ec == net::error::operation_aborted || !acceptor_.is_open()) {
+    return;
   }
-  acceptor_.async_accept(ctx_, beast::bind_front_handler(&Server::on_accept, shared_from_this()));
+  acceptor_.async_accept(
+      ctx_,
+      net::bind_executor(strand_,
+                         beast::bind_front_handler(&Server::on_accept, shared_from_this())));
+}
+
+void Server::schedule_metrics_refresh() {
+  Metrics::instance().refresh();
+
+  metrics_timer_.expires_after(kMetricsRefreshInterval);
+  metrics_timer_.async_wait([self = shared_from_this()](error_code ec) {
+    if (!ec) {
+      self->schedule_metrics_refresh();
+    }
+  });
+}
+
+void Server::schedule_lobby_timers() {
+  manager_.expire();
+
+  lobby_timer_.expires_after(LobbyManager::kTimerResolution);
+  lobby_timer_.async_wait([self = shared_from_this()](error_code ec) {
+    if (!ec) {
+      self->schedule_lobby_timers();
+    }
+  });
 }
 }  // namespace io_blair
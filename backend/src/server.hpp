@@ -5,12 +5,18 @@
 
 #include <boost/asio.hpp>
 #include <boost/system.hpp>
+#include <atomic>
+#include <chrono>
 #include <cstdint>
+#include <functional>
 #include <memory>
+#include <optional>
 #include <string_view>
 #include <thread>
 #include <vector>
 
+#include "admission.hpp"
+#include "config.hpp"
 #include "lobby_manager.hpp"
 
 namespace io_blair {
@@ -30,11 +36,16 @@ class Server : public std::enable_shared_from_this<Server> {
    * @warning Do not directly instantiate Server. This object 
    * must be created as a std::shared_ptr<Server>.
    * 
-   * @param address The address to listen on.
-   * @param port The port to listen on.
-   * @param threads The number of threads the server can use for processing.
+   * Lobbies are restored from LobbyOptions::snapshot_path, if set. If a
+   * server is running with the same Config::handoff_socket, its listening
+   * socket is taken over instead of binding a new one. The server then
+   * listens on that path to hand its listening socket to the next one.
+   *
+   * @param config
+   * @param reload Loads the config again on SIGHUP. Its reloadable
+   * settings are applied. Unset ignores SIGHUP.
    */
-  Server(std::string_view address, uint16_t port, uint8_t threads);
+  explicit Server(Config config, std::function<std::optional<Config>()> reload = {});
 
   /**
    * @brief Starts the server. 
@@ -44,34 +55,128 @@ class Server : public std::enable_shared_from_this<Server> {
   void run();
 
  private:
-  // Prints ec and what and exits program.
+  // Logs ec and what, flushes the log and exits program.
   static void log_fatal(error_code, const char* what);
 
   // Sets up acceptor to listen for connections.
   void prepare_acceptor(std::string_view address, uint16_t port);
 
-  // Sets up cleanup operations on server termination.
+  // Takes over the listening socket of the server at the handoff socket.
+  // Returns false if there's no server to take it from.
+  bool adopt_acceptor(std::string_view address);
+
+  // Listens at the handoff socket for the next server.
+  void prepare_handoff();
+
+  // Waits for the next server to ask for the listening socket. Once it's
+  // handed over, stops accepting and drains.
+  void wait_handoff();
+
+  // Stops accepting and starts closing sessions, unless already doing so.
+  // Cuts short a drain after a handoff.
+  void shut_down();
+
+  // Closes the acceptors, so no more connections or handoffs are taken.
+  void stop_accepting();
+
+  // Sets up a staged shutdown on SIGINT or SIGTERM: stop accepting, close
+  // sessions and exit once they're gone or drain_timeout passes. Lobbies
+  // are then saved to snapshot_path_ by run().
   void prepare_exit();
 
+  // Waits for sessions to close until none remain or shutdown_deadline_
+  // passes, then exits. Closes them with a going away frame once
+  // closing_sessions_ is set, otherwise lets them finish.
+  void drain();
+
   // The handler that is called when a connection is accepted.
   void on_accept(error_code, tcp::socket);
 
+  // Periodically re-renders the metrics snapshot served over HTTP.
+  void schedule_metrics_refresh();
+
+  // Periodically runs the lobby manager's timers, which give up the places of
+  // suspended sessions and reclaim empty or idle lobbies.
+  void schedule_lobby_timers();
+
+  // Waits for SIGHUP to reload the config.
+  void wait_reload();
+
+  // Applies the reloadable settings of next. Must run on strand_.
+  void apply(const Config& next);
+
+  // Pins the calling thread to the i-th CPU of the configured affinity, if any.
+  void pin_thread(std::size_t i) const;
+
+  // Sets up dumping collected trace spans whenever a dump is requested by signal.
+  void prepare_trace_dump();
+
+  // Waits for the next trace dump request.
+  void wait_trace_dump();
+
+  // Decides which accepted connections are served. Declared before ctx_ so
+  // it outlives the tickets held by connections still queued on ctx_.
+  Admission admission_;
+
   // All async work done by the server and sessions use this io_context.
   net::io_context ctx_;
 
+  // Serializes accepting, reloading and shutting down, which share
+  // admission_ and config_.
+  net::strand<net::io_context::executor_type> strand_;
+
   // Listens and accepts client connections.
   tcp::acceptor acceptor_;
 
   // Used to schedule post server termination cleanup.
   net::signal_set exit_signals_;
 
-  // The number of threads the server will utilize.
-  uint8_t threads_;
+  // Used to request trace dumps (SIGUSR1 where available).
+  net::signal_set trace_signals_;
+
+  // Used to request config reloads (SIGHUP where available).
+  net::signal_set reload_signals_;
+
+  // Used to schedule metrics snapshot refreshes.
+  net::steady_timer metrics_timer_;
+
+  // Used to schedule running the lobby manager's timers.
+  net::steady_timer lobby_timer_;
+
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+  // Listens for the next server asking for the listening socket.
+  net::local::stream_protocol::acceptor handoff_acceptor_;
+#endif
+
+  // Used to poll for sessions to close on shutdown.
+  net::steady_timer drain_timer_;
+
+  // When shutdown stops waiting for sessions to close. Set once shutting
+  // down or handed off.
+  std::optional<std::chrono::steady_clock::time_point> shutdown_deadline_;
+
+  // Set once sessions are being closed rather than left to finish.
+  bool closing_sessions_ = false;
+
+  // The session count shutdown last logged.
+  int64_t sessions_reported_ = -1;
 
   // The pool of threads the server will use to perform async tasks.
   std::vector<std::thread> pool_;
 
   // Each client session is given a reference to this manager to create/join lobbies.
   LobbyManager manager_;
+
+  // The running config. Only reloadable settings change after construction.
+  Config config_;
+
+  // Loads the config again on SIGHUP.
+  std::function<std::optional<Config>()> reload_;
+
+  // Set once the listening socket went to the next server. Sessions left
+  // here get session.handoff_drain_timeout to finish their games, and their
+  // lobbies aren't saved on exit, since the next server won't restore a
+  // snapshot written after it started.
+  std::atomic<bool> handed_off_{false};
 };
 }  // namespace io_blair
@@ -25,6 +25,15 @@ enum class SessionEvent {
    * @brief Indicates Lobby should transition to GameDone.
    */
   kTransitionToGameDone,
+  /**
+   * @brief Indicates the lobby was closed by the server and the session should leave it.
+   */
+  kLobbyClosed,
+  /**
+   * @brief Indicates the session's matchmaking ticket was paired and the
+   * session was placed in a lobby.
+   */
+  kMatchFound,
 };
 
 }  // namespace io_blair
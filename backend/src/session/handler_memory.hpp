@@ -0,0 +1,205 @@
+/**
+ * @file handler_memory.hpp
+ */
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace io_blair {
+/**
+ * @brief A fixed number of equally sized memory slots that can be taken and
+ * returned from any thread without locking.
+ *
+ * @tparam SlotSize The largest allocation a slot can hold.
+ * @tparam Slots How many allocations can be held at once.
+ */
+template <std::size_t SlotSize, std::size_t Slots>
+class SlotArena {
+ public:
+  static_assert(Slots <= 32, "used_ has a bit per slot");
+
+  /**
+   * @brief Takes a free slot.
+   *
+   * @param size
+   * @return void* The slot or nullptr if \p size doesn't fit or every slot is taken.
+   */
+  void* allocate(std::size_t size) {
+    if (size > SlotSize) {
+      return nullptr;
+    }
+    uint32_t used = used_.load(std::memory_order_relaxed);
+    while (used != kAllUsed) {
+      const int slot = std::countr_one(used);
+      if (used_.compare_exchange_weak(
+              used, used | (1U << slot), std::memory_order_acquire, std::memory_order_relaxed)) {
+        return &storage_[slot];
+      }
+    }
+    return nullptr;
+  }
+
+  /**
+   * @brief Returns \p ptr's slot if \p ptr belongs to the arena.
+   *
+   * @param ptr
+   * @return true \p ptr was returned.
+   * @return false \p ptr didn't come from the arena.
+   */
+  bool deallocate(void* ptr) {
+    const auto* slot = static_cast<const Slot*>(ptr);
+    if (slot < storage_ || slot >= storage_ + Slots) {
+      return false;
+    }
+    used_.fetch_and(~(1U << (slot - storage_)), std::memory_order_release);
+    return true;
+  }
+
+ private:
+  static constexpr uint32_t kAllUsed = Slots == 32 ? ~0U : (1U << Slots) - 1;
+
+  struct Slot {
+    alignas(std::max_align_t) std::byte bytes[SlotSize];
+  };
+
+  Slot storage_[Slots];
+
+  // Bit i is set while slot i is in use.
+  std::atomic<uint32_t> used_{0};
+};
+
+/**
+ * @brief Memory for the async operations of a single session. Asio allocates
+ * the state of every async operation through the handler's associated
+ * allocator, so handlers wrapped with make_alloc_handler() reuse this memory
+ * instead of hitting the heap on every read, write and post.
+ *
+ * Posted handlers are small and many may be queued at once. The composed
+ * websocket read and write are large but only one of each is in flight.
+ * Requests that don't fit fall back to the heap.
+ */
+class HandlerMemory {
+ public:
+  HandlerMemory() = default;
+
+  HandlerMemory(const HandlerMemory&)            = delete;
+  HandlerMemory& operator=(const HandlerMemory&) = delete;
+
+  /**
+   * @brief Allocates \p size bytes, preferably from a free slot.
+   *
+   * @param size
+   * @return void*
+   */
+  void* allocate(std::size_t size) {
+    if (void* ptr = small_.allocate(size)) {
+      return ptr;
+    }
+    if (void* ptr = large_.allocate(size)) {
+      return ptr;
+    }
+    return ::operator new(size);
+  }
+
+  /**
+   * @brief Frees memory returned by allocate().
+   *
+   * @param ptr
+   */
+  void deallocate(void* ptr) {
+    if (!small_.deallocate(ptr) && !large_.deallocate(ptr)) {
+      ::operator delete(ptr);
+    }
+  }
+
+ private:
+  SlotArena<256, 16> small_;
+  SlotArena<1536, 4> large_;
+};
+
+/**
+ * @brief The allocator asio sees for handlers wrapped with make_alloc_handler().
+ *
+ * @tparam T
+ */
+template <typename T>
+class HandlerAllocator {
+ public:
+  using value_type = T;
+
+  explicit HandlerAllocator(HandlerMemory& memory)
+      : memory_(&memory) {}
+
+  template <typename U>
+  HandlerAllocator(const HandlerAllocator<U>& other) noexcept  // NOLINT(google-explicit-constructor)
+      : memory_(other.memory_) {}
+
+  T* allocate(std::size_t n) const {
+    return static_cast<T*>(memory_->allocate(sizeof(T) * n));
+  }
+
+  void deallocate(T* ptr, std::size_t) const {
+    memory_->deallocate(ptr);
+  }
+
+  template <typename U>
+  bool operator==(const HandlerAllocator<U>& other) const noexcept {
+    return memory_ == other.memory_;
+  }
+
+ private:
+  template <typename>
+  friend class HandlerAllocator;
+
+  HandlerMemory* memory_;
+};
+
+/**
+ * @brief Wraps a completion handler so that asio allocates its operation
+ * state from a HandlerMemory.
+ *
+ * @tparam Handler
+ */
+template <typename Handler>
+class AllocHandler {
+ public:
+  using allocator_type = HandlerAllocator<Handler>;
+
+  AllocHandler(HandlerMemory& memory, Handler handler)
+      : memory_(memory),
+        handler_(std::move(handler)) {}
+
+  allocator_type get_allocator() const noexcept {
+    return allocator_type(memory_);
+  }
+
+  template <typename... Args>
+  void operator()(Args&&... args) {
+    handler_(std::forward<Args>(args)...);
+  }
+
+ private:
+  HandlerMemory& memory_;
+  Handler handler_;
+};
+
+/**
+ * @brief Wraps \p handler so its operations allocate from \p memory.
+ * \p memory must outlive every operation started with the returned handler.
+ *
+ * @param memory
+ * @param handler
+ * @return AllocHandler
+ */
+template <typename Handler>
+AllocHandler<std::decay_t<Handler>> make_alloc_handler(HandlerMemory& memory, Handler&& handler) {
+  return AllocHandler<std::decay_t<Handler>>(memory, std::forward<Handler>(handler));
+}
+
+}  // namespace io_blair
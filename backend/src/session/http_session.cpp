@@ -0,0 +1,146 @@
+#include "http_session.hpp"
+
+#include <chrono>
+#include <memory>
+#include <string_view>
+#include <utility>
+
+#include "admission.hpp"
+#include "metrics.hpp"
+#include "session.hpp"
+
+
+namespace io_blair {
+using std::string_view;
+
+namespace {
+constexpr string_view kHealthBody      = "ok\n";
+constexpr string_view kNotFoundBody    = "not found\n";
+constexpr string_view kNotAllowedBody  = "method not allowed\n";
+constexpr string_view kUnavailableBody = "server busy\n";
+constexpr const char* kMetricsMimeType = "text/plain; version=0.0.4";
+
+// How long, in seconds, turned away clients are asked to wait before retrying.
+constexpr const char* kRetryAfter = "5";
+
+// How long a turned away client has to send its request and read the answer.
+constexpr auto kRejectTimeout = std::chrono::seconds(5);
+}  // namespace
+
+HttpSession::HttpSession(net::io_context& ctx, tcp::socket&& socket, LobbyManager& manager,
+                         SessionOptions options, Admission::Ticket ticket)
+    : ctx_(ctx),
+      stream_(std::move(socket)),
+      manager_(manager),
+      options_(options),
+      ticket_(std::move(ticket)) {}
+
+void HttpSession::run() {
+  if (!ticket_.admitted()) {
+    // The request is still read so the answer doesn't race a reset from
+    // closing with unread data, but the client only gets so long.
+    stream_.expires_after(kRejectTimeout);
+  }
+  async_read();
+}
+
+void HttpSession::async_read() {
+  if (ticket_.admitted() && options_.upgrade_timeout.count() != 0) {
+    // Also bounds writing the response. The upgraded Session sets its own.
+    stream_.expires_after(options_.upgrade_timeout);
+  }
+  http::async_read(stream_,
+                   buffer_,
+                   req_,
+                   beast::bind_front_handler(&HttpSession::on_read, shared_from_this()));
+}
+
+void HttpSession::on_read(error_code ec, size_t) {
+  // Turned away connections were never going to be upgraded, so they
+  // don't count towards upgrade timeouts.
+  if (ec == beast::error::timeout && ticket_.admitted()) {
+    Metrics::instance().closed(CloseReason::kUpgradeTimeout).inc();
+    return;
+  }
+  // Either the client closed the connection or sent something that isn't HTTP.
+  if (ec) {
+    return;
+  }
+
+  if (!ticket_.admitted()) {
+    reject();
+    return;
+  }
+  ticket_.release();
+
+  if (websocket::is_upgrade(req_)) {
+    // buffer_ may hold the client's first frames, read along with the request.
+    Session::make(ctx_, std::move(stream_), manager_, options_)
+        ->run(std::move(req_), std::move(buffer_));
+    return;
+  }
+
+  respond();
+}
+
+void HttpSession::respond() {
+  Metrics::instance().http_requests.inc();
+
+  res_ = {};
+  res_.version(req_.version());
+  // The admission ticket was given up once the request was read, so the
+  // connection isn't kept open for requests admission wouldn't count.
+  res_.keep_alive(false);
+  res_.set(http::field::content_type, "text/plain");
+
+  string_view body;
+  if (req_.method() != http::verb::get) {
+    res_.result(http::status::method_not_allowed);
+    body = kNotAllowedBody;
+  } else if (req_.target() == "/health") {
+    res_.result(http::status::ok);
+    body = kHealthBody;
+  } else if (req_.target() == "/metrics") {
+    res_.result(http::status::ok);
+    res_.set(http::field::content_type, kMetricsMimeType);
+    body_owner_ = Metrics::instance().snapshot();
+    body        = *body_owner_;
+  } else {
+    res_.result(http::status::not_found);
+    body = kNotFoundBody;
+  }
+
+  res_.body() = {body.data(), body.size()};
+  res_.prepare_payload();
+
+  http::async_write(stream_,
+                    res_,
+                    beast::bind_front_handler(&HttpSession::on_write, shared_from_this()));
+}
+
+void HttpSession::reject() {
+  Metrics::instance().connections_rejected.inc();
+
+  res_ = {};
+  res_.version(req_.version());
+  res_.keep_alive(false);
+  res_.result(http::status::service_unavailable);
+  res_.set(http::field::content_type, "text/plain");
+  res_.set(http::field::retry_after, kRetryAfter);
+  res_.body() = {kUnavailableBody.data(), kUnavailableBody.size()};
+  res_.prepare_payload();
+
+  http::async_write(stream_,
+                    res_,
+                    beast::bind_front_handler(&HttpSession::on_write, shared_from_this()));
+}
+
+void HttpSession::on_write(error_code ec, size_t) {
+  body_owner_.reset();
+
+  if (!ec) {
+    stream_.socket().shutdown(tcp::socket::shutdown_send, ec);
+  }
+}
+
+}  // namespace io_blair
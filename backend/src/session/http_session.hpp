@@ -0,0 +1,93 @@
+/**
+ * @file http_session.hpp
+ */
+#pragma once
+
+#include <boost/asio.hpp>
+#include <boost/beast.hpp>
+#include <boost/system.hpp>
+#include <memory>
+#include <string>
+
+#include "admission.hpp"
+#include "lobby_manager.hpp"
+#include "session_options.hpp"
+
+namespace io_blair {
+namespace net    = boost::asio;
+using tcp        = net::ip::tcp;
+using error_code = boost::system::error_code;
+namespace beast  = boost::beast;
+namespace http   = beast::http;
+
+/**
+ * @brief HttpSession reads the first HTTP request of an accepted connection.
+ * Websocket upgrade requests are handed off to a new Session. Plain requests
+ * for health and metrics are answered directly without creating a Session.
+ */
+class HttpSession : public std::enable_shared_from_this<HttpSession> {
+ public:
+  /**
+   * @brief Construct a new HttpSession object.
+   *
+   * @warning Do not directly instantiate HttpSession. This object
+   * must be created as a std::shared_ptr<HttpSession>.
+   *
+   * @param ctx The context used for async operations.
+   * @param socket The socket containing the client connection.
+   * @param manager The lobby manager handed to upgraded sessions.
+   * @param options Settings for upgraded sessions.
+   * @param ticket Whether the connection was admitted. Connections that
+   * weren't are answered with 503 Service Unavailable and closed.
+   */
+  HttpSession(net::io_context& ctx, tcp::socket&& socket, LobbyManager& manager,
+              SessionOptions options = {}, Admission::Ticket ticket = {});
+
+  /**
+   * @brief Starts reading the request and immediately returns.
+   */
+  void run();
+
+ private:
+  // Declare intent to read a request from the client and immediately return.
+  void async_read();
+
+  // The handler that is called after a request has been read.
+  void on_read(error_code, size_t bytes);
+
+  // Builds and writes the response to a plain HTTP request.
+  void respond();
+
+  // Writes 503 Service Unavailable and closes the connection.
+  void reject();
+
+  // The handler that is called after a response has been written. Closes
+  // the connection.
+  void on_write(error_code, size_t bytes);
+
+  net::io_context& ctx_;
+
+  // Holds the client connection until it's answered or upgraded.
+  beast::tcp_stream stream_;
+
+  // Used to store incoming client data.
+  beast::flat_buffer buffer_;
+
+  // The request currently being handled.
+  http::request<http::empty_body> req_;
+
+  // The response currently being written. The body views body_owner_ or static storage.
+  http::response<http::span_body<const char>> res_;
+
+  // Keeps a metrics snapshot alive while it's being written.
+  std::shared_ptr<const std::string> body_owner_;
+
+  LobbyManager& manager_;
+
+  SessionOptions options_;
+
+  // Holds the connection's pending handshake place until its first request is read.
+  Admission::Ticket ticket_;
+};
+
+}  // namespace io_blair
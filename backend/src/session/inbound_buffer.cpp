@@ -0,0 +1,72 @@
+#include "inbound_buffer.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+
+#include "pool_allocator.hpp"
+
+
+namespace io_blair {
+InboundBuffer::InboundBuffer(std::size_t max_size)
+    : max_size_(max_size),
+      begin_(inline_) {}
+
+InboundBuffer::~InboundBuffer() {
+  release();
+}
+
+InboundBuffer::mutable_buffers_type InboundBuffer::prepare(std::size_t n) {
+  const std::size_t len = size();
+  if (n > max_size_ - len) {
+    throw std::length_error("InboundBuffer overflow");
+  }
+
+  if (out_ + n > capacity_) {
+    if (len + n <= capacity_) {
+      // Enough room once the consumed bytes are reclaimed.
+      std::memmove(begin_, begin_ + in_, len);
+    } else {
+      const std::size_t capacity = std::bit_ceil(len + n);
+      char* block                = static_cast<char*>(block_pool::allocate(capacity));
+      std::memcpy(block, begin_ + in_, len);
+      release();
+      begin_    = block;
+      capacity_ = capacity;
+    }
+    in_  = 0;
+    out_ = len;
+  }
+
+  last_ = out_ + n;
+  return {begin_ + out_, n};
+}
+
+void InboundBuffer::commit(std::size_t n) noexcept {
+  out_ += std::min(n, last_ - out_);
+  last_ = out_;
+}
+
+void InboundBuffer::consume(std::size_t n) noexcept {
+  if (n < size()) {
+    in_ += n;
+    return;
+  }
+
+  in_   = 0;
+  out_  = 0;
+  last_ = 0;
+  // Keep idle sessions small. The next big message gets a block back from the pool.
+  release();
+}
+
+void InboundBuffer::release() noexcept {
+  if (spilled()) {
+    block_pool::deallocate(begin_, capacity_);
+    begin_    = inline_;
+    capacity_ = kInlineSize;
+  }
+}
+
+}  // namespace io_blair
@@ -0,0 +1,98 @@
+/**
+ * @file inbound_buffer.hpp
+ */
+#pragma once
+
+#include <boost/asio/buffer.hpp>
+#include <cstddef>
+#include <string_view>
+
+namespace io_blair {
+/**
+ * @brief A contiguous DynamicBuffer for reading client messages. Messages up
+ * to kInlineSize bytes are read into storage inside the buffer itself, so the
+ * common path never leaves the session's own memory. Bigger messages spill
+ * into a block from block_pool, which is returned as soon as the buffer
+ * is fully consumed.
+ */
+class InboundBuffer {
+ public:
+  using const_buffers_type   = boost::asio::const_buffer;
+  using mutable_buffers_type = boost::asio::mutable_buffer;
+
+  /**
+   * @brief Bytes held without spilling.
+   */
+  static constexpr std::size_t kInlineSize = 512;
+
+  /**
+   * @brief Construct a new InboundBuffer.
+   *
+   * @param max_size The most bytes the buffer may hold. prepare() throws
+   * std::length_error past this, which fails the read.
+   */
+  explicit InboundBuffer(std::size_t max_size = kInlineSize);
+
+  InboundBuffer(const InboundBuffer&)            = delete;
+  InboundBuffer& operator=(const InboundBuffer&) = delete;
+
+  ~InboundBuffer();
+
+  std::size_t size() const noexcept {
+    return out_ - in_;
+  }
+
+  std::size_t max_size() const noexcept {
+    return max_size_;
+  }
+
+  std::size_t capacity() const noexcept {
+    return capacity_;
+  }
+
+  const_buffers_type data() const noexcept {
+    return {begin_ + in_, size()};
+  }
+
+  /**
+   * @brief Gets the readable bytes as a string_view.
+   *
+   * @return std::string_view
+   */
+  std::string_view view() const noexcept {
+    return {begin_ + in_, size()};
+  }
+
+  mutable_buffers_type prepare(std::size_t n);
+
+  void commit(std::size_t n) noexcept;
+
+  void consume(std::size_t n) noexcept;
+
+  /**
+   * @brief Determines whether the readable bytes live in a spilled block.
+   *
+   * @return true
+   * @return false
+   */
+  bool spilled() const noexcept {
+    return begin_ != inline_;
+  }
+
+ private:
+  // Returns a spilled block to the pool and goes back to inline storage.
+  void release() noexcept;
+
+  std::size_t max_size_;
+  char* begin_;
+  std::size_t capacity_ = kInlineSize;
+
+  // [in_, out_) is readable and [out_, last_) is prepared for writing.
+  std::size_t in_   = 0;
+  std::size_t out_  = 0;
+  std::size_t last_ = 0;
+
+  char inline_[kInlineSize];
+};
+
+}  // namespace io_blair
@@ -3,10 +3,11 @@
  */
 #pragma once
 
+#include <cstdint>
 #include <memory>
-#include <string>
 
 #include "event.hpp"
+#include "message.hpp"
 
 
 namespace io_blair {
@@ -22,22 +23,23 @@ class ISession {
    * 
    * @param msg The message to send.
    */
-  virtual void async_send(std::shared_ptr<const std::string> msg) = 0;
+  virtual void async_send(Message msg) = 0;
 
   /**
-   * @brief Convenience method for async_send() that automatically wraps the string
-   * in a shared_ptr.
+   * @brief Queues an event to be handled by the session.
    * 
-   * @param msg The message to send.
+   * @param ev The event to be handled.
    */
-  virtual void async_send(std::string msg) = 0;
+  virtual void async_handle(SessionEvent ev) = 0;
 
   /**
-   * @brief Queues an event to be handled by the session.
+   * @brief Gets an id identifying the session in logs.
    * 
-   * @param ev The event to be handled.
+   * @return uint64_t. 0 if the session has no id.
    */
-  virtual void async_handle(SessionEvent ev) = 0;
+  virtual uint64_t id() const {
+    return 0;
+  }
 };
 
 }  // namespace io_blair
@@ -0,0 +1,88 @@
+/**
+ * @file mailbox.hpp
+ */
+#pragma once
+
+#include <atomic>
+#include <new>
+#include <utility>
+
+#include "pool_allocator.hpp"
+
+namespace io_blair {
+/**
+ * @brief A lock-free multi-producer, single-consumer queue. Any thread may
+ * push. A single consumer takes everything queued so far in one go, so
+ * producers and the consumer only ever contend on one atomic pointer.
+ *
+ * push() reports when the mailbox goes from empty to non-empty, which lets
+ * producers schedule exactly one drain per batch.
+ *
+ * @tparam T
+ */
+template <typename T>
+class Mailbox {
+ public:
+  Mailbox() = default;
+
+  Mailbox(const Mailbox&)            = delete;
+  Mailbox& operator=(const Mailbox&) = delete;
+
+  ~Mailbox() {
+    drain([](T&&) {});
+  }
+
+  /**
+   * @brief Queues \p value. Safe to call from any thread.
+   *
+   * @param value
+   * @return true The mailbox was empty. The caller should schedule a drain.
+   * @return false A drain is already due.
+   */
+  bool push(T value) {
+    Node* node = NodeAllocator().allocate(1);
+    new (node) Node{std::move(value), head_.load(std::memory_order_relaxed)};
+    while (!head_.compare_exchange_weak(
+        node->next, node, std::memory_order_release, std::memory_order_relaxed)) {
+    }
+    return node->next == nullptr;
+  }
+
+  /**
+   * @brief Takes everything queued so far and passes each value to \p fn in
+   * the order it was pushed. Must only be called by the consumer.
+   *
+   * @param fn Called with T&&.
+   */
+  template <typename Fn>
+  void drain(Fn&& fn) {
+    // Producers push onto the front, so reverse the batch to restore push order.
+    Node* reversed = nullptr;
+    for (Node* node = head_.exchange(nullptr, std::memory_order_acquire); node != nullptr;) {
+      Node* next = node->next;
+      node->next = reversed;
+      reversed   = node;
+      node       = next;
+    }
+
+    while (reversed != nullptr) {
+      Node* node = reversed;
+      reversed   = node->next;
+      fn(std::move(node->value));
+      node->~Node();
+      NodeAllocator().deallocate(node, 1);
+    }
+  }
+
+ private:
+  struct Node {
+    T value;
+    Node* next;
+  };
+  using NodeAllocator = PoolAllocator<Node>;
+
+  // The most recently pushed node.
+  std::atomic<Node*> head_{nullptr};
+};
+
+}  // namespace io_blair
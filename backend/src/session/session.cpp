@@ -1,88 +1,225 @@
 #include "session.hpp"
 
-#include <iostream>
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <memory>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "event.hpp"
 #include "handler.hpp"
+#include "handler_memory.hpp"
 #include "json.hpp"
+#include "logging.hpp"
+#include "metrics.hpp"
+#include "pool_allocator.hpp"
 #include "session_context.hpp"
+#include "trace.hpp"
 
 
 namespace io_blair {
 using std::shared_ptr;
-using std::string;
 
-Session::Session(net::io_context& ctx, tcp::socket&& socket)
-    : ws_(std::move(socket)),
+namespace {
+std::atomic<uint64_t> next_session_id{1};
+
+// Every session past the websocket handshake by id, so they can be closed on
+// shutdown. Only touched when a session opens or closes.
+std::mutex open_sessions_mutex;
+std::unordered_map<uint64_t, std::weak_ptr<Session>> open_sessions;
+}  // namespace
+
+Session::Session(net::io_context& ctx, beast::tcp_stream&& stream, SessionOptions options)
+    : options_(options),
+      id_(next_session_id.fetch_add(1, std::memory_order_relaxed)),
+      ws_(std::move(stream)),
+      buffer_(json::in::kMaxMessageSize),
       read_strand_(net::make_strand(ctx)),
-      write_strand_(net::make_strand(ctx)),
-      handler_(nullptr) {
-  ws_.set_option(websocket::stream_base::timeout::suggested(beast::role_type::server));
-#ifndef NDEBUG
-  std::cout << "Session c'tor\n";
-#endif
+      write_strand_(options.single_strand ? read_strand_ : net::make_strand(ctx)),
+      stall_timer_(ctx) {
+  auto timeout = websocket::stream_base::timeout::suggested(beast::role_type::server);
+  timeout.handshake_timeout = options.handshake_timeout.count() == 0
+                                  ? websocket::stream_base::none()
+                                  : options.handshake_timeout;
+  timeout.idle_timeout      = options.idle_timeout.count() == 0 ? websocket::stream_base::none()
+                                                                : options.idle_timeout;
+  timeout.keep_alive_pings = options.keep_alive_pings;
+  ws_.set_option(timeout);
+  ws_.read_message_max(json::in::kMaxMessageSize);
+  Metrics::instance().sessions_active.inc();
+  Metrics::instance().sessions_total.inc();
+  logging::debug("Session opened", {.session = id_});
 }
 
-#ifndef NDEBUG
 Session::~Session() {
-  std::cout << "Session d'tor\n";
+  {
+    std::lock_guard lock(open_sessions_mutex);
+    open_sessions.erase(id_);
+  }
+  Metrics::instance().sessions_active.dec();
+  logging::debug("Session closed", {.session = id_});
 }
-#endif
 
-std::shared_ptr<Session> Session::make(net::io_context& ctx, tcp::socket&& socket,
-                                       LobbyManager& manager) {
-  auto session = std::make_shared<Session>(ctx, std::move(socket));
+std::shared_ptr<Session> Session::make(net::io_context& ctx, beast::tcp_stream&& stream,
+                                       LobbyManager& manager, SessionOptions options) {
+  auto session
+      = std::allocate_shared<Session>(PoolAllocator<Session>{}, ctx, std::move(stream), options);
 
   // The reason Session couldn't be properly initialized with just the c'tor
   // is because the handler we want to use requires a shared_ptr to the session
   // to construct.
-  session->handler_ = std::make_unique<Game>(SessionContext{session, manager});
+  session->handler_.emplace(SessionContext{session, manager});
 
   return session;
 }
 
-void Session::run() {
-  ws_.async_accept([self = shared_from_this()](error_code ec) {
+void Session::run(http::request<http::empty_body> req, beast::flat_buffer buffer) {
+  // The websocket's handshake timeout bounds accepting from here, and its
+  // own timeouts don't work while the stream has a deadline of its own.
+  beast::get_lowest_layer(ws_).expires_never();
+
+  auto on_accept = [self = shared_from_this()](error_code ec) {
+    if (ec == beast::error::timeout) {
+      Metrics::instance().closed(CloseReason::kHandshakeTimeout).inc();
+    }
     if (!ec) {
+      {
+        std::lock_guard lock(open_sessions_mutex);
+        open_sessions.emplace(self->id_, self);
+      }
       self->async_read();
     }
-  });
+  };
+
+  if (buffer.size() == 0) {
+    ws_.async_accept(req, std::move(on_accept));
+    return;
+  }
+  // The websocket only takes bytes that were already read through the
+  // overload that parses the request itself, so the request is written back
+  // ahead of them. It copies both before returning.
+  std::ostringstream raw;
+  raw << req;
+  const std::array<net::const_buffer, 2> received{net::buffer(raw.view()), buffer.data()};
+  ws_.async_accept(received, std::move(on_accept));
 }
 
-void Session::async_send(shared_ptr<const string> msg) {
-  net::post(write_strand_,
-            beast::bind_front_handler(&Session::on_send, shared_from_this(), std::move(msg)));
+void Session::close_all() {
+  std::vector<shared_ptr<Session>> sessions;
+  {
+    std::lock_guard lock(open_sessions_mutex);
+    sessions.reserve(open_sessions.size());
+    for (const auto& [id, weak] : open_sessions) {
+      if (auto session = weak.lock()) {
+        sessions.push_back(std::move(session));
+      }
+    }
+  }
+
+  for (auto& session : sessions) {
+    auto& strand = session->write_strand_;
+    net::post(strand, beast::bind_front_handler(&Session::go_away, std::move(session)));
+  }
 }
 
-void Session::async_send(std::string msg) {
-  async_send(std::make_shared<const string>(std::move(msg)));
+void Session::async_send(Message msg) {
+  const auto stamp = trace::current();
+
+  if (options_.single_strand) {
+    // Replies to the session's own messages are already on the strand.
+    if (write_strand_.running_in_this_thread()) {
+      on_send(std::move(msg), stamp, trace::now_ns_if(stamp));
+      return;
+    }
+    if (mailbox_.push({std::move(msg), stamp, trace::now_ns_if(stamp)})) {
+      net::post(write_strand_,
+                make_alloc_handler(handler_memory_,
+                                   beast::bind_front_handler(&Session::drain_mailbox,
+                                                             shared_from_this())));
+    }
+    return;
+  }
+
+  net::post(write_strand_,
+            make_alloc_handler(handler_memory_,
+                               beast::bind_front_handler(&Session::on_send,
+                                                         shared_from_this(),
+                                                         std::move(msg),
+                                                         stamp,
+                                                         trace::now_ns_if(stamp))));
 }
 
 
 void Session::async_handle(SessionEvent ev) {
-  net::post(read_strand_, [self = shared_from_this(), ev] { (*self->handler_)(ev); });
+  const auto stamp = trace::current();
+  net::post(read_strand_,
+            make_alloc_handler(
+                handler_memory_,
+                [self = shared_from_this(), ev, stamp, posted_ns = trace::now_ns_if(stamp)] {
+                  trace::Scope scope(stamp);
+                  trace::record_since(stamp, "event_strand_wait", posted_ns);
+                  (*self->handler_)(ev);
+                }));
+}
+
+uint64_t Session::id() const {
+  return id_;
 }
 
 bool Session::is_fatal(error_code ec) {
   return ec == websocket::error::closed || ec == net::error::connection_aborted
-         || ec == net::error::connection_reset || ec == net::error::operation_aborted;
+         || ec == net::error::connection_reset || ec == net::error::operation_aborted
+         || ec == beast::error::timeout;
 }
 
 void Session::async_read() {
-  ws_.async_read(buffer_, beast::bind_front_handler(&Session::on_read, shared_from_this()));
+  auto handler = make_alloc_handler(handler_memory_,
+                                    beast::bind_front_handler(&Session::on_read, shared_from_this()));
+  if (options_.single_strand) {
+    ws_.async_read(buffer_, net::bind_executor(read_strand_, std::move(handler)));
+  } else {
+    ws_.async_read(buffer_, std::move(handler));
+  }
 }
 
 void Session::async_write() {
+  const Outbound& front = queue_.front();
+  trace::record_since(front.stamp, "write_queue", front.queued_ns);
+  write_start_ns_ = trace::now_ns_if(front.stamp);
+  if (options_.write_stall_timeout.count() != 0) {
+    stall_timer_.expires_after(options_.write_stall_timeout);
+    stall_timer_.async_wait(net::bind_executor(
+        write_strand_,
+        make_alloc_handler(handler_memory_, beast::bind_front_handler(&Session::on_write_stall,
+                                                                      shared_from_this()))));
+  }
+
   ws_.async_write(
-      net::buffer(*queue_.front()),
-      net::bind_executor(write_strand_,
-                         beast::bind_front_handler(&Session::on_write, shared_from_this())));
+      net::buffer(front.msg.data(), front.msg.size()),
+      net::bind_executor(
+          write_strand_,
+          make_alloc_handler(handler_memory_,
+                             beast::bind_front_handler(&Session::on_write, shared_from_this()))));
 }
 
 void Session::on_read(error_code ec, size_t) {
+  if (ec == websocket::error::message_too_big || ec == websocket::error::buffer_overflow) {
+    // Beast has already started closing the connection.
+    Metrics::instance().messages_oversized.inc();
+    Metrics::instance().closed(CloseReason::kOversized).inc();
+    logging::warn("Message over size limit", {.session = id_});
+    async_handle(SessionEvent::kCloseSession);
+    return;
+  }
   if (ec) {
+    if (ec == beast::error::timeout) {
+      // The websocket closes the connection when nothing arrives in time.
+      Metrics::instance().closed(CloseReason::kIdleTimeout).inc();
+    }
     if (is_fatal(ec)) {
       async_handle(SessionEvent::kCloseSession);
     } else {
@@ -90,18 +227,52 @@ void Session::on_read(error_code ec, size_t) {
     }
     return;
   }
+  Metrics::instance().messages_received.inc();
+  if (buffer_.spilled()) {
+    Metrics::instance().messages_spilled.inc();
+  }
+
+  const auto stamp = trace::Tracer::instance().sample();
+  if (options_.single_strand) {
+    // The read completed on read_strand_, so the message can be handled right away.
+    handle_message(stamp);
+    return;
+  }
 
   net::post(read_strand_,
-            [self = shared_from_this(), data = beast::buffers_to_string(buffer_.data())]() {
-              json::decode(data, *self->handler_);
-            });
+            make_alloc_handler(handler_memory_, [self = shared_from_this(), stamp]() {
+              trace::record_since(stamp, "read_strand_wait", stamp.start_ns);
+              self->handle_message(stamp);
+            }));
+}
+
+void Session::handle_message(trace::Stamp stamp) {
+  trace::Scope scope(stamp);
+  if (buffer_.view() == json::in::kPingMessage) {
+    // Legacy heartbeat. The reply is the same every time, so skip the decoder.
+    Metrics::instance().pings_fast_path.inc();
+    async_send(json::out::pong_msg());
+  } else {
+    trace::Span span("handle");
+    if (json::decode(buffer_.view(), *handler_) == json::DecodeResult::kTooLarge) {
+      Metrics::instance().messages_rejected.inc();
+      logging::debug("Message too large for its type", {.session = id_});
+    }
+  }
+  // The message is decoded straight out of buffer_, so the next read only
+  // starts once it has been handled.
   buffer_.consume(buffer_.size());
 
   async_read();
 }
 
-void Session::on_send(shared_ptr<const string> msg) {
-  queue_.push_back(std::move(msg));
+void Session::on_send(Message msg, trace::Stamp stamp, int64_t posted_ns) {
+  if (closing_) {
+    return;
+  }
+  trace::record_since(stamp, "write_strand_wait", posted_ns);
+
+  queue_.push_back({std::move(msg), stamp, trace::now_ns_if(stamp)});
 
   if (queue_.size() > 1) {
     return;
@@ -109,13 +280,78 @@ void Session::on_send(shared_ptr<const string> msg) {
   async_write();
 }
 
-void Session::on_write(error_code, size_t) {
+void Session::drain_mailbox() {
+  mailbox_.drain(
+      [this](Outbound&& out) { on_send(std::move(out.msg), out.stamp, out.queued_ns); });
+}
+
+void Session::on_write(error_code ec, size_t) {
+  if (options_.write_stall_timeout.count() != 0) {
+    // Also moves the expiry on_write_stall checks past now.
+    stall_timer_.expires_at(std::chrono::steady_clock::time_point::max());
+  }
+
+  const trace::Stamp stamp = queue_.front().stamp;
+  trace::record_since(stamp, "write", write_start_ns_);
+  trace::record_since(stamp, "end_to_end", stamp.start_ns);
+
+  if (ec) {
+    // The websocket can't be written to after a failed write.
+    queue_.clear();
+    shutdown();
+    return;
+  }
+  Metrics::instance().messages_sent.inc();
+
   queue_.erase(queue_.begin());
 
   if (queue_.empty()) {
+    if (closing_) {
+      async_close();
+    }
     return;
   }
   async_write();
 }
 
+void Session::on_write_stall(error_code ec) {
+  // A write that completed just as the timer expired has already moved
+  // the expiry on.
+  if (ec || stall_timer_.expiry() > std::chrono::steady_clock::now()) {
+    return;
+  }
+  Metrics::instance().closed(CloseReason::kWriteStall).inc();
+  logging::debug("Write stalled", {.session = id_});
+  // Fails the stalled write, whose handler drops the rest of the queue.
+  shutdown();
+}
+
+void Session::shutdown() {
+  closing_ = true;
+  error_code ec;
+  beast::get_lowest_layer(ws_).socket().shutdown(tcp::socket::shutdown_both, ec);
+}
+
+void Session::go_away() {
+  if (closing_) {
+    return;
+  }
+  closing_ = true;
+  Metrics::instance().closed(CloseReason::kGoingAway).inc();
+
+  // Otherwise the close follows the last queued write, since a close frame
+  // can't be sent while a write is in flight.
+  if (queue_.empty()) {
+    async_close();
+  }
+}
+
+void Session::async_close() {
+  // The pending read completes once the client answers the close frame,
+  // which closes the session as usual.
+  auto handler = make_alloc_handler(handler_memory_, [self = shared_from_this()](error_code) {});
+  ws_.async_close(websocket::close_code::going_away,
+                  net::bind_executor(write_strand_, std::move(handler)));
+}
+
 }  // namespace io_blair
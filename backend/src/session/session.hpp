@@ -6,19 +6,30 @@
 #include <boost/asio.hpp>
 #include <boost/beast.hpp>
 #include <boost/system.hpp>
+#include <chrono>
+#include <cstdint>
 #include <memory>
+#include <optional>
 #include <vector>
 
 #include "event.hpp"
-#include "ihandler.hpp"
+#include "handler.hpp"
+#include "handler_memory.hpp"
+#include "inbound_buffer.hpp"
 #include "isession.hpp"
 #include "lobby_manager.hpp"
+#include "mailbox.hpp"
+#include "message.hpp"
+#include "pool_allocator.hpp"
+#include "session_options.hpp"
+#include "trace.hpp"
 
 namespace io_blair {
 namespace net       = boost::asio;
 using tcp           = net::ip::tcp;
 using error_code    = boost::system::error_code;
 namespace beast     = boost::beast;
+namespace http      = beast::http;
 namespace websocket = beast::websocket;
 
 /**
@@ -29,14 +40,16 @@ class Session : public ISession, public std::enable_shared_from_this<Session> {
   /**
    * @brief Creates a new Session object. This function should be used
    * instead of the constructor to have a properly initialized Session.
+   * The Session's memory is recycled from previously closed sessions.
    * 
    * @param ctx The context used for async operations.
-   * @param socket The socket containing the client connection.
+   * @param stream The stream containing the client connection.
    * @param manager The lobby manager.
+   * @param options
    * @return std::shared_ptr<Session> 
    */
-  static std::shared_ptr<Session> make(net::io_context& ctx, tcp::socket&& socket,
-                                       LobbyManager& manager);
+  static std::shared_ptr<Session> make(net::io_context& ctx, beast::tcp_stream&& stream,
+                                       LobbyManager& manager, SessionOptions options = {});
 
   /**
    * @brief Construct a new Session object.
@@ -45,26 +58,37 @@ class Session : public ISession, public std::enable_shared_from_this<Session> {
    * Session must be created through Session::make.
    * 
    * @param ctx The context used for async operations.
-   * @param socket The socket containing the client connection.
+   * @param stream The stream containing the client connection.
+   * @param options
    */
-  Session(net::io_context& ctx, tcp::socket&& socket);
+  Session(net::io_context& ctx, beast::tcp_stream&& stream, SessionOptions options = {});
 
-#ifndef NDEBUG
   ~Session() override;
-#endif
 
   /**
    * @brief Starts the session and immediately returns. Operations are done
    * on the io_context thread(s).
+   *
+   * @param req The websocket upgrade request already read by HttpSession.
+   * @param buffer Whatever HttpSession read past \p req, such as the
+   * client's first frames.
    */
-  void run();
-
-  void async_send(std::shared_ptr<const std::string> msg) override;
+  void run(http::request<http::empty_body> req, beast::flat_buffer buffer = {});
 
-  void async_send(std::string msg) override;
+  void async_send(Message msg) override;
 
   void async_handle(SessionEvent) override;
 
+  uint64_t id() const override;
+
+  /**
+   * @brief Starts closing every open session with a going away close frame.
+   * Each session first finishes sending the messages it has queued, then
+   * drops any sent later. Sessions still in the websocket handshake are
+   * missed, so callers draining the server repeat this until none remain.
+   */
+  static void close_all();
+
  private:
   // Checks if the error code is fatal, meaning the session should terminate.
   static bool is_fatal(error_code);
@@ -78,29 +102,88 @@ class Session : public ISession, public std::enable_shared_from_this<Session> {
   // The handler that is called when the client sends data.
   void on_read(error_code, size_t bytes);
 
-  // The handler that is called when send is initiated.
-  void on_send(std::shared_ptr<const std::string> msg);
+  // Decodes and handles the message in buffer_, then reads the next one.
+  // Must run on read_strand_.
+  void handle_message(trace::Stamp stamp);
+
+  // The handler that is called when send is initiated. stamp is the trace of the
+  // message that caused the send and posted_ns is when the send was initiated.
+  void on_send(Message msg, trace::Stamp stamp, int64_t posted_ns);
 
   // The handler that is called after data has been written to the client.
   void on_write(error_code ec, size_t bytes);
 
+  // The handler that is called when stall_timer_ expires or is cancelled.
+  void on_write_stall(error_code ec);
+
+  // Stops queueing messages and shuts the socket down, which fails any write
+  // in flight and the pending read, closing the session as usual. Must run
+  // on write_strand_.
+  void shutdown();
+
+  // Moves messages sent from other threads out of mailbox_ into queue_.
+  void drain_mailbox();
+
+  // Stops queueing messages and closes the connection once queue_ is
+  // flushed. Must run on write_strand_.
+  void go_away();
+
+  // Sends the going away close frame.
+  void async_close();
+
+  const SessionOptions options_;
+
+  // Identifies the session in logs.
+  const uint64_t id_;
+
   // Holds the client connection.
   websocket::stream<beast::tcp_stream> ws_;
 
   // Used to store incoming client data.
-  beast::flat_static_buffer<512> buffer_;
+  InboundBuffer buffer_;
 
   using strand = net::strand<net::io_context::executor_type>;
   // Synchronizes reads from the client.
   strand read_strand_;
-  // Synchronizes writes to the client.
+  // Synchronizes writes to the client. The same strand as read_strand_ when
+  // options_.single_strand is set.
   strand write_strand_;
 
+  // A message waiting to be sent to the client.
+  struct Outbound {
+    Message msg;
+    // The trace of the inbound message that caused this one.
+    trace::Stamp stamp;
+    // When the message was queued.
+    int64_t queued_ns;
+  };
+
   // Stores messages to be sent to the client.
-  std::vector<std::shared_ptr<const std::string>> queue_;
+  std::vector<Outbound, PoolAllocator<Outbound>> queue_;
+
+  // Messages sent from other threads when options_.single_strand is set.
+  // queued_ns holds when they were sent until they are moved into queue_.
+  Mailbox<Outbound> mailbox_;
+
+  // When the write of queue_.front() started. Only set for sampled messages.
+  int64_t write_start_ns_ = 0;
+
+  // Armed for options_.write_stall_timeout around every write. Only accessed on
+  // write_strand_.
+  net::steady_timer stall_timer_;
+
+  // Set once the session starts closing, by go_away(), a write stall or a
+  // failed write.
+  // Only accessed on write_strand_.
+  bool closing_ = false;
+
+  // Handles incoming client data. Set by make() since Game needs a
+  // pointer to the session.
+  std::optional<Game> handler_;
 
-  // Handles incoming client data.
-  std::unique_ptr<IHandler> handler_;
+  // Backs the state of the session's async operations so that reads, writes
+  // and posts don't allocate once the session is running.
+  HandlerMemory handler_memory_;
 };
 
 }  // namespace io_blair
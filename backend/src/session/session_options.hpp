@@ -0,0 +1,66 @@
+/**
+ * @file session_options.hpp
+ */
+#pragma once
+
+#include <chrono>
+
+namespace io_blair {
+/**
+ * @brief Settings shared by every Session the server starts.
+ */
+struct SessionOptions {
+  /**
+   * @brief Runs all of a session's work on one strand. Inbound messages are
+   * handled directly in the read completion and sends from other sessions
+   * go through a lock-free mailbox drained on that strand. When false,
+   * reads and writes are serialized by separate strands.
+   */
+  bool single_strand = false;
+
+  /**
+   * @brief How long a connection has to send each HTTP request, including
+   * the websocket upgrade. Zero disables the timeout.
+   */
+  std::chrono::seconds upgrade_timeout{10};
+
+  /**
+   * @brief How long the websocket handshake, and later the close handshake,
+   * may take. Zero disables the timeout.
+   */
+  std::chrono::seconds handshake_timeout{10};
+
+  /**
+   * @brief How long a connection may go without receiving anything before
+   * it's closed. Zero disables the timeout.
+   */
+  std::chrono::seconds idle_timeout{60};
+
+  /**
+   * @brief Sends a websocket ping once half of idle_timeout passes without
+   * traffic, so idle but healthy clients aren't dropped. Clients answer
+   * pings in the websocket layer, so no JSON heartbeat is needed.
+   */
+  bool keep_alive_pings = true;
+
+  /**
+   * @brief How long a write to the client may go without completing before
+   * the connection is closed, so a client that stops reading can't pile up
+   * queued messages. Zero disables the timeout.
+   */
+  std::chrono::seconds write_stall_timeout{10};
+
+  /**
+   * @brief How long shutdown waits for sessions to flush their queued
+   * messages and close before the server stops regardless.
+   */
+  std::chrono::seconds drain_timeout{10};
+
+  /**
+   * @brief How long a server that handed its listening socket to the next
+   * one lets its sessions finish their games before it stops regardless.
+   */
+  std::chrono::seconds handoff_drain_timeout{600};
+};
+
+}  // namespace io_blair
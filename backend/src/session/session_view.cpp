@@ -5,7 +5,6 @@
 
 namespace io_blair {
 using std::shared_ptr;
-using std::string;
 using std::weak_ptr;
 
 using guard = std::lock_guard<std::mutex>;
@@ -13,25 +12,26 @@ using guard = std::lock_guard<std::mutex>;
 SessionView::SessionView(weak_ptr<ISession> session)
     : session_(std::move(session)) {}
 
-void SessionView::async_send(shared_ptr<const string> msg) {
+void SessionView::async_send(Message msg) {
   guard lock(mutex_);
   if (auto sess = session_.lock()) {
     sess->async_send(std::move(msg));
   }
 }
 
-void SessionView::async_send(string msg) {
+void SessionView::async_handle(SessionEvent ev) {
   guard lock(mutex_);
   if (auto sess = session_.lock()) {
-    sess->async_send(std::move(msg));
+    sess->async_handle(ev);
   }
 }
 
-void SessionView::async_handle(SessionEvent ev) {
+uint64_t SessionView::id() const {
   guard lock(mutex_);
   if (auto sess = session_.lock()) {
-    sess->async_handle(ev);
+    return sess->id();
   }
+  return 0;
 }
 
 bool SessionView::try_set(weak_ptr<ISession> session) {
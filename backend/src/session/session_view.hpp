@@ -25,12 +25,12 @@ class SessionView : public ISession {
    */
   explicit SessionView(std::weak_ptr<ISession> session = {});
 
-  void async_send(std::shared_ptr<const std::string> msg) override;
-
-  void async_send(std::string msg) override;
+  void async_send(Message msg) override;
 
   void async_handle(SessionEvent ev) override;
 
+  uint64_t id() const override;
+
   /**
    * @brief Attempt to reassign an expired session with a new session.
    * 
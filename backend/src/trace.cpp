@@ -0,0 +1,163 @@
+#include "trace.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+namespace io_blair::trace {
+using std::memory_order_acquire;
+using std::memory_order_relaxed;
+using std::memory_order_release;
+using std::string;
+using std::vector;
+
+namespace {
+thread_local Stamp current_stamp;
+thread_local uint32_t sample_counter = 0;
+
+// Small stable id for the calling thread, used as the trace event tid.
+uint32_t thread_index() {
+  static std::atomic<uint32_t> next{1};
+  thread_local const uint32_t index = next.fetch_add(1, memory_order_relaxed);
+  return index;
+}
+}  // namespace
+
+int64_t now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+Tracer& Tracer::instance() {
+  static Tracer tracer;
+  return tracer;
+}
+
+void Tracer::set_sample_every(uint32_t every) {
+  sample_every_.store(every, memory_order_relaxed);
+}
+
+Stamp Tracer::sample() {
+  const uint32_t every = sample_every_.load(memory_order_relaxed);
+  if (every == 0 || ++sample_counter % every != 0) {
+    return {};
+  }
+  return {.id = next_id_.fetch_add(1, memory_order_relaxed), .start_ns = now_ns()};
+}
+
+void Tracer::record(Stamp stamp, const char* name, int64_t start_ns, int64_t end_ns) {
+  if (!stamp) {
+    return;
+  }
+
+  const uint64_t pos = head_.fetch_add(1, memory_order_relaxed);
+  Slot& slot         = slots_[pos % kCapacity];
+
+  // Mark the slot as being written so readers skip it.
+  const uint64_t seq = slot.seq.load(memory_order_relaxed);
+  slot.seq.store(seq | 1, memory_order_relaxed);
+  std::atomic_thread_fence(memory_order_release);
+
+  slot.trace_id.store(stamp.id, memory_order_relaxed);
+  slot.name.store(name, memory_order_relaxed);
+  slot.start_ns.store(start_ns, memory_order_relaxed);
+  slot.end_ns.store(end_ns, memory_order_relaxed);
+  slot.thread.store(thread_index(), memory_order_relaxed);
+
+  slot.seq.store((seq | 1) + 1, memory_order_release);
+}
+
+void Tracer::set_dump_path(string path) {
+  dump_path_ = std::move(path);
+}
+
+bool Tracer::dump() const {
+  return dump(dump_path_);
+}
+
+bool Tracer::dump(const string& path) const {
+  vector<SpanRecord> spans;
+  spans.reserve(kCapacity);
+
+  for (const Slot& slot : slots_) {
+    const uint64_t before = slot.seq.load(memory_order_acquire);
+    if (before == 0 || (before & 1) != 0) {
+      continue;
+    }
+
+    SpanRecord span{.trace_id = slot.trace_id.load(memory_order_relaxed),
+                    .name     = slot.name.load(memory_order_relaxed),
+                    .start_ns = slot.start_ns.load(memory_order_relaxed),
+                    .end_ns   = slot.end_ns.load(memory_order_relaxed),
+                    .thread   = slot.thread.load(memory_order_relaxed)};
+
+    // Discard the span if a writer raced with us.
+    std::atomic_thread_fence(memory_order_acquire);
+    if (slot.seq.load(memory_order_relaxed) != before) {
+      continue;
+    }
+    spans.push_back(span);
+  }
+
+  std::ranges::sort(spans, {}, &SpanRecord::start_ns);
+
+  std::ofstream out(path, std::ios::trunc);
+  if (!out) {
+    return false;
+  }
+
+  // Chrome trace event format, complete events with microsecond timestamps.
+  out << "{\"traceEvents\":[";
+  for (size_t i = 0; i < spans.size(); ++i) {
+    const SpanRecord& span = spans[i];
+    out << (i == 0 ? "" : ",") << "\n{\"name\":\"" << span.name
+        << "\",\"cat\":\"io_blair\",\"ph\":\"X\",\"pid\":1,\"tid\":" << span.thread
+        << ",\"ts\":" << static_cast<double>(span.start_ns) / 1000.0
+        << ",\"dur\":" << static_cast<double>(span.end_ns - span.start_ns) / 1000.0
+        << ",\"args\":{\"trace\":" << span.trace_id << "}}";
+  }
+  out << "\n]}\n";
+
+  return static_cast<bool>(out);
+}
+
+void record_since(Stamp stamp, const char* name, int64_t start_ns) {
+  if (stamp) {
+    Tracer::instance().record(stamp, name, start_ns, now_ns());
+  }
+}
+
+int64_t now_ns_if(Stamp stamp) {
+  return stamp ? now_ns() : 0;
+}
+
+Stamp current() {
+  return current_stamp;
+}
+
+Scope::Scope(Stamp stamp)
+    : prev_(current_stamp) {
+  current_stamp = stamp;
+}
+
+Scope::~Scope() {
+  current_stamp = prev_;
+}
+
+Span::Span(const char* name)
+    : stamp_(current_stamp), name_(name), start_ns_(stamp_ ? now_ns() : 0) {}
+
+Span::~Span() {
+  if (stamp_) {
+    Tracer::instance().record(stamp_, name_, start_ns_, now_ns());
+  }
+}
+
+}  // namespace io_blair::trace
@@ -0,0 +1,212 @@
+/**
+ * @file trace.hpp
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Sampled latency tracing of client messages.
+ *
+ * An inbound message is stamped when it's read. The stamp is carried through
+ * the threads handling it by trace::Scope and is attached to every outbound
+ * message queued while it's current, so spans from the read up to each
+ * resulting write share one trace id.
+ */
+namespace io_blair::trace {
+
+/**
+ * @brief Identifies a sampled inbound message. An id of 0 means unsampled.
+ */
+struct Stamp {
+  uint64_t id = 0;
+  /**
+   * @brief When the message was read, in nanoseconds. See trace::now_ns().
+   */
+  int64_t start_ns = 0;
+
+  /**
+   * @brief Determines whether the stamp belongs to a sampled message.
+   */
+  explicit operator bool() const {
+    return id != 0;
+  }
+};
+
+/**
+ * @brief A completed span.
+ */
+struct SpanRecord {
+  uint64_t trace_id;
+  const char* name;
+  int64_t start_ns;
+  int64_t end_ns;
+  uint32_t thread;
+};
+
+/**
+ * @brief Gets the current time of the clock used for spans.
+ *
+ * @return int64_t Nanoseconds.
+ */
+int64_t now_ns();
+
+/**
+ * @brief Collects sampled spans into a fixed size lock-free ring buffer.
+ * When the buffer is full, the oldest spans are overwritten.
+ */
+class Tracer {
+ public:
+  /**
+   * @brief The number of spans retained.
+   */
+  static constexpr std::size_t kCapacity = 1 << 14;
+
+  /**
+   * @brief Gets the process wide tracer.
+   *
+   * @return Tracer&
+   */
+  static Tracer& instance();
+
+  /**
+   * @brief Sets how often inbound messages are sampled.
+   *
+   * @param every Sample one out of every \p every messages per thread. 0 disables tracing.
+   */
+  void set_sample_every(uint32_t every);
+
+  /**
+   * @brief Decides whether the message being read should be traced.
+   *
+   * @return Stamp A sampled stamp or an unsampled one.
+   */
+  Stamp sample();
+
+  /**
+   * @brief Records a span. Does nothing if \p stamp is unsampled.
+   *
+   * @param stamp The trace the span belongs to.
+   * @param name A string literal naming the span.
+   * @param start_ns The start of the span.
+   * @param end_ns The end of the span.
+   */
+  void record(Stamp stamp, const char* name, int64_t start_ns, int64_t end_ns);
+
+  /**
+   * @brief Sets the file Tracer::dump() writes to.
+   *
+   * @param path The file to write.
+   */
+  void set_dump_path(std::string path);
+
+  /**
+   * @brief Writes all retained spans to the dump path in the Chrome trace event format.
+   *
+   * @return true The file was written.
+   * @return false The file couldn't be opened.
+   */
+  bool dump() const;
+
+  /**
+   * @brief Writes all retained spans to \p path in the Chrome trace event format.
+   *
+   * @param path The file to write.
+   * @return true The file was written.
+   * @return false The file couldn't be opened.
+   */
+  bool dump(const std::string& path) const;
+
+ private:
+  Tracer() = default;
+
+  // A ring buffer slot. seq is odd while the slot is being written and
+  // otherwise is twice the number of writes the slot has completed.
+  struct alignas(64) Slot {
+    std::atomic<uint64_t> seq{0};
+    std::atomic<uint64_t> trace_id{0};
+    std::atomic<const char*> name{nullptr};
+    std::atomic<int64_t> start_ns{0};
+    std::atomic<int64_t> end_ns{0};
+    std::atomic<uint32_t> thread{0};
+  };
+
+  std::string dump_path_ = "io_blair_trace.json";
+  std::atomic<uint32_t> sample_every_{0};
+  std::atomic<uint64_t> next_id_{1};
+  std::atomic<uint64_t> head_{0};
+  std::array<Slot, kCapacity> slots_;
+};
+
+/**
+ * @brief Records a span from \p start_ns until now. Does nothing if \p stamp is unsampled.
+ *
+ * @param stamp The trace the span belongs to.
+ * @param name A string literal naming the span.
+ * @param start_ns The start of the span.
+ */
+void record_since(Stamp stamp, const char* name, int64_t start_ns);
+
+/**
+ * @brief Gets the current time if \p stamp is sampled, otherwise 0.
+ * Avoids reading the clock for unsampled messages.
+ *
+ * @param stamp
+ * @return int64_t
+ */
+int64_t now_ns_if(Stamp stamp);
+
+/**
+ * @brief Gets the stamp of the message being handled by this thread.
+ *
+ * @return Stamp
+ */
+Stamp current();
+
+/**
+ * @brief Makes a stamp current on this thread for the lifetime of the scope.
+ */
+class Scope {
+ public:
+  /**
+   * @brief Construct a new Scope object.
+   *
+   * @param stamp The stamp to make current.
+   */
+  explicit Scope(Stamp stamp);
+  ~Scope();
+
+  Scope(const Scope&)            = delete;
+  Scope& operator=(const Scope&) = delete;
+
+ private:
+  Stamp prev_;
+};
+
+/**
+ * @brief Records the lifetime of the span under the current stamp.
+ */
+class Span {
+ public:
+  /**
+   * @brief Construct a new Span object.
+   *
+   * @param name A string literal naming the span.
+   */
+  explicit Span(const char* name);
+  ~Span();
+
+  Span(const Span&)            = delete;
+  Span& operator=(const Span&) = delete;
+
+ private:
+  Stamp stamp_;
+  const char* name_;
+  int64_t start_ns_;
+};
+
+}  // namespace io_blair::trace
@@ -0,0 +1,95 @@
+#include "admission.hpp"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <vector>
+
+#include "admission_options.hpp"
+
+
+namespace io_blair::testing {
+using Verdict = Admission::Verdict;
+using std::chrono::milliseconds;
+
+TEST(AdmissionShould, AdmitEveryConnectionByDefault) {
+  Admission admission;
+
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_TRUE(admission.admit(i).admitted());
+  }
+}
+
+TEST(AdmissionShould, TurnAwayConnectionsOverSessionCap) {
+  Admission admission({.max_sessions = 2});
+
+  EXPECT_TRUE(admission.admit(1).admitted());
+  EXPECT_EQ(admission.admit(2).verdict(), Verdict::kTooManySessions);
+}
+
+TEST(AdmissionShould, CapPendingHandshakesUntilReleased) {
+  Admission admission({.max_pending_handshakes = 2});
+
+  auto first  = admission.admit(0);
+  auto second = admission.admit(0);
+  EXPECT_EQ(admission.pending(), 2);
+  EXPECT_EQ(admission.admit(0).verdict(), Verdict::kTooManyHandshakes);
+
+  first.release();
+  EXPECT_EQ(admission.pending(), 1);
+  EXPECT_TRUE(admission.admit(0).admitted());
+}
+
+TEST(AdmissionShould, LimitAcceptRateAfterBurst) {
+  Admission admission({.accept_rate = 10, .accept_burst = 3});
+  const auto start = Admission::clock::now();
+
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_TRUE(admission.admit(0, start).admitted());
+  }
+  EXPECT_EQ(admission.admit(0, start).verdict(), Verdict::kRateLimited);
+
+  // One token is earned every 100ms.
+  EXPECT_TRUE(admission.admit(0, start + milliseconds(100)).admitted());
+  EXPECT_EQ(admission.admit(0, start + milliseconds(150)).verdict(), Verdict::kRateLimited);
+
+  // Refilling stops at the burst size.
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_TRUE(admission.admit(0, start + milliseconds(10'000)).admitted());
+  }
+  EXPECT_FALSE(admission.admit(0, start + milliseconds(10'000)).admitted());
+}
+
+TEST(AdmissionShould, NotSpendTokensOnTurnedAwayConnections) {
+  const auto start = Admission::clock::now();
+  Admission admission({.max_sessions = 1, .accept_rate = 1});
+
+  EXPECT_EQ(admission.admit(1, start).verdict(), Verdict::kTooManySessions);
+  EXPECT_TRUE(admission.admit(0, start).admitted());
+}
+
+TEST(AdmissionShould, DropRejectionsPastCapUntilReleased) {
+  Admission admission({.max_sessions = 1, .max_pending_rejections = 2});
+
+  auto first  = admission.admit(1);
+  auto second = admission.admit(1);
+  EXPECT_FALSE(first.dropped());
+  EXPECT_FALSE(second.dropped());
+  EXPECT_EQ(admission.rejecting(), 2);
+  EXPECT_TRUE(admission.admit(1).dropped());
+
+  first.release();
+  EXPECT_EQ(admission.rejecting(), 1);
+  EXPECT_FALSE(admission.admit(1).dropped());
+}
+
+TEST(AdmissionShould, NotHoldRejectionPlacesForAdmittedConnections) {
+  Admission admission({.max_pending_rejections = 0});
+
+  auto ticket = admission.admit(0);
+  EXPECT_TRUE(ticket.admitted());
+  EXPECT_FALSE(ticket.dropped());
+  EXPECT_EQ(admission.rejecting(), 0);
+}
+
+}  // namespace io_blair::testing
@@ -0,0 +1,82 @@
+#include "code_allocator.hpp"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+
+namespace io_blair::testing {
+using std::string;
+
+constexpr CodeAllocator::Key kKey = {1, 2, 3, 4};
+
+TEST(CodeAllocatorShould, MakeCodesFromAlphabet) {
+  CodeAllocator codes(kKey);
+
+  const string code = codes.allocate();
+
+  EXPECT_EQ(code.size(), CodeAllocator::kCodeLength);
+  EXPECT_EQ(code.find_first_not_of(CodeAllocator::kAlphabet), string::npos);
+}
+
+TEST(CodeAllocatorShould, NotRepeatCodes) {
+  constexpr int kCodes = 200'000;
+  CodeAllocator codes(kKey);
+
+  std::unordered_set<string> seen;
+  for (int i = 0; i < kCodes; ++i) {
+    EXPECT_TRUE(seen.insert(codes.allocate()).second) << i;
+  }
+}
+
+TEST(CodeAllocatorShould, NotHandOutCodesInOrder) {
+  CodeAllocator codes(kKey);
+
+  const string first  = codes.allocate();
+  const string second = codes.allocate();
+
+  // Sequential codes would differ only in the last character.
+  EXPECT_NE(first.substr(0, CodeAllocator::kCodeLength - 1),
+            second.substr(0, CodeAllocator::kCodeLength - 1));
+}
+
+TEST(CodeAllocatorShould, FollowKey) {
+  CodeAllocator a(kKey);
+  CodeAllocator b(kKey);
+  CodeAllocator c({5, 6, 7, 8});
+
+  const string code = a.allocate();
+
+  EXPECT_EQ(b.allocate(), code);
+  EXPECT_NE(c.allocate(), code);
+}
+
+TEST(CodeAllocatorShould, QuarantineReleasedCodes) {
+  CodeAllocator codes(kKey);
+  std::vector<string> released;
+  for (std::size_t i = 0; i <= CodeAllocator::kQuarantine; ++i) {
+    released.push_back(codes.allocate());
+  }
+
+  // Not reused while fewer than kQuarantine codes were released after it.
+  codes.release(released[0]);
+  EXPECT_NE(codes.allocate(), released[0]);
+
+  for (std::size_t i = 1; i < released.size(); ++i) {
+    codes.release(released[i]);
+  }
+  EXPECT_EQ(codes.allocate(), released[0]);
+}
+
+TEST(CodeAllocatorShould, IgnoreInvalidReleases) {
+  CodeAllocator codes(kKey);
+
+  codes.release("abc");
+  codes.release("??????");
+
+  EXPECT_EQ(codes.allocate().size(), CodeAllocator::kCodeLength);
+}
+
+}  // namespace io_blair::testing
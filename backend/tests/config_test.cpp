@@ -0,0 +1,125 @@
+#include "config.hpp"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "logging.hpp"
+
+
+namespace io_blair::testing {
+using std::string;
+using std::vector;
+using std::chrono::seconds;
+namespace fs = std::filesystem;
+
+class ConfigShould : public ::testing::Test {
+ protected:
+  ~ConfigShould() override {
+    unsetenv("SERVER_PORT");
+    unsetenv("SERVER_THREADS");
+    fs::remove(path_);
+  }
+
+  void write_file(const string& content) {
+    std::ofstream(path_) << content;
+  }
+
+  const string path_ = (fs::temp_directory_path() / "io_blair_config_test.conf").string();
+  string error_;
+};
+
+TEST_F(ConfigShould, RequirePort) {
+  EXPECT_FALSE(load_config({}, error_).has_value());
+  EXPECT_FALSE(error_.empty());
+}
+
+TEST_F(ConfigShould, DefaultEverythingButPort) {
+  const auto config = load_config(vector<string>{"--port=8080"}, error_);
+
+  ASSERT_TRUE(config.has_value()) << error_;
+  EXPECT_EQ(config->port, 8080);
+  EXPECT_EQ(config->address, "0.0.0.0");
+  EXPECT_EQ(config->threads, std::max(1U, std::thread::hardware_concurrency()));
+  EXPECT_EQ(config->session.idle_timeout, SessionOptions{}.idle_timeout);
+}
+
+TEST_F(ConfigShould, PreferArgsOverEnvironmentOverFile) {
+  write_file("# Tuning\nport = 1000\nthreads = 2\nlog_level = warn\n");
+  setenv("SERVER_PORT", "2000", 1);
+  setenv("SERVER_THREADS", "3", 1);
+
+  const auto config = load_config(vector<string>{"--config=" + path_, "--threads=4"}, error_);
+
+  ASSERT_TRUE(config.has_value()) << error_;
+  EXPECT_EQ(config->port, 2000);
+  EXPECT_EQ(config->threads, 4);
+  EXPECT_EQ(config->log_level, logging::Level::kWarn);
+}
+
+TEST_F(ConfigShould, ParseNestedSettings) {
+  const auto config = load_config(vector<string>{"--port=1",
+                                                 "--cpu_affinity=0, 2,5",
+                                                 "--session.single_strand=true",
+                                                 "--session.write_stall_timeout_s=3",
+                                                 "--session.handoff_drain_timeout_s=900",
+                                                 "--lobby.snapshot_file=/tmp/lobbies",
+                                                 "--admission.accept_rate=50"},
+                                  error_);
+
+  ASSERT_TRUE(config.has_value()) << error_;
+  EXPECT_EQ(config->cpu_affinity, (vector<uint32_t>{0, 2, 5}));
+  EXPECT_TRUE(config->session.single_strand);
+  EXPECT_EQ(config->session.write_stall_timeout, seconds(3));
+  EXPECT_EQ(config->session.handoff_drain_timeout, seconds(900));
+  EXPECT_EQ(config->lobby.snapshot_path, "/tmp/lobbies");
+  EXPECT_EQ(config->admission.accept_rate, 50);
+}
+
+TEST_F(ConfigShould, RejectUnknownSettings) {
+  EXPECT_FALSE(load_config(vector<string>{"--port=1", "--prot=2"}, error_).has_value());
+  EXPECT_NE(error_.find("prot"), string::npos);
+
+  write_file("port = 1\nthreds = 2\n");
+  EXPECT_FALSE(load_config(vector<string>{"--config=" + path_}, error_).has_value());
+  EXPECT_NE(error_.find(":2:"), string::npos);
+}
+
+TEST_F(ConfigShould, RejectInvalidValues) {
+  for (const char* arg : {"--port=70000", "--threads=-1", "--threads=5000", "--log_level=loud",
+                          "--session.single_strand=yes", "--cpu_affinity=1,,2",
+                          "--session.idle_timeout_s=10s", "--address=localhost",
+                          "--address=0.0.0.0:80"}) {
+    EXPECT_FALSE(load_config(vector<string>{"--port=1", arg}, error_).has_value()) << arg;
+  }
+}
+
+TEST_F(ConfigShould, ParseAddressesIntoCanonicalForm) {
+  const auto config = load_config(vector<string>{"--port=1", "--address=0:0::1"}, error_);
+
+  ASSERT_TRUE(config.has_value()) << error_;
+  EXPECT_EQ(config->address, "::1");
+}
+
+TEST_F(ConfigShould, TellWhichChangesNeedRestart) {
+  const auto running = load_config(vector<string>{"--port=1"}, error_);
+  ASSERT_TRUE(running.has_value());
+
+  Config reloadable                 = *running;
+  reloadable.log_level              = logging::Level::kDebug;
+  reloadable.session.idle_timeout   = seconds(5);
+  reloadable.admission.max_sessions = 10;
+  EXPECT_FALSE(needs_restart(*running, reloadable));
+
+  Config restart             = *running;
+  restart.lobby.resume_grace = seconds(5);
+  EXPECT_TRUE(needs_restart(*running, restart));
+}
+
+}  // namespace io_blair::testing
@@ -0,0 +1,76 @@
+#include "handoff.hpp"
+
+#include <gtest/gtest.h>
+
+#include <boost/asio.hpp>
+#include <filesystem>
+#include <string>
+#include <thread>
+
+
+namespace io_blair::testing {
+namespace net = boost::asio;
+using net::ip::tcp;
+using local = net::local::stream_protocol;
+using std::string;
+namespace fs = std::filesystem;
+
+namespace {
+// Listens on an ephemeral loopback port.
+tcp::acceptor make_listener(net::io_context& ctx) {
+  return {ctx, {net::ip::address_v4::loopback(), 0}};
+}
+}  // namespace
+
+TEST(HandoffShould, PassListeningSocketOverUnixSocket) {
+  net::io_context ctx;
+  local::socket sender(ctx);
+  local::socket receiver(ctx);
+  net::local::connect_pair(sender, receiver);
+  tcp::acceptor listener = make_listener(ctx);
+
+  ASSERT_TRUE(handoff::send_fd(sender.native_handle(), listener.native_handle()));
+  const int fd = handoff::receive_fd(receiver.native_handle());
+  ASSERT_GE(fd, 0);
+
+  tcp::acceptor adopted(ctx, tcp::v4(), fd);
+  EXPECT_EQ(adopted.local_endpoint(), listener.local_endpoint());
+
+  // The received copy keeps accepting once the sender's is closed.
+  const auto endpoint = listener.local_endpoint();
+  listener.close();
+  tcp::socket client(ctx);
+  client.connect(endpoint);
+  tcp::socket accepted = adopted.accept();
+  EXPECT_EQ(accepted.remote_endpoint(), client.local_endpoint());
+}
+
+TEST(HandoffShould, RequestListenerFromRunningServer) {
+  const string path = (fs::temp_directory_path() / "io_blair_handoff_test.sock").string();
+  fs::remove(path);
+
+  net::io_context ctx;
+  local::acceptor handoffs(ctx, local::endpoint(path));
+  tcp::acceptor listener = make_listener(ctx);
+  std::thread running([&] {
+    local::socket socket = handoffs.accept();
+    handoff::send_fd(socket.native_handle(), listener.native_handle());
+  });
+
+  const int fd = handoff::request_listener(path);
+  running.join();
+  ASSERT_GE(fd, 0);
+  tcp::acceptor adopted(ctx, tcp::v4(), fd);
+  EXPECT_EQ(adopted.local_endpoint(), listener.local_endpoint());
+
+  fs::remove(path);
+}
+
+TEST(HandoffShould, FailWithoutRunningServer) {
+  const string path = (fs::temp_directory_path() / "io_blair_handoff_none.sock").string();
+  fs::remove(path);
+
+  EXPECT_EQ(handoff::request_listener(path), -1);
+}
+
+}  // namespace io_blair::testing
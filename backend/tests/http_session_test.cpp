@@ -0,0 +1,190 @@
+#include "http_session.hpp"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <boost/asio.hpp>
+#include <boost/beast.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "admission.hpp"
+#include "admission_options.hpp"
+#include "lobby_manager.hpp"
+#include "metrics.hpp"
+#include "session_options.hpp"
+
+
+namespace io_blair::testing {
+using std::make_shared;
+using std::string;
+using ::testing::HasSubstr;
+
+class HttpSessionShould : public ::testing::Test {
+ protected:
+  explicit HttpSessionShould(AdmissionOptions admission = {}, SessionOptions options = {})
+      : admission_(admission) {
+    acceptor_.async_accept([this, options](error_code ec, tcp::socket socket) {
+      if (!ec) {
+        make_shared<HttpSession>(ctx_, std::move(socket), manager_, options,
+                                 admission_.admit(0))
+            ->run();
+      }
+    });
+    thread_ = std::thread([this] { ctx_.run(); });
+  }
+
+  ~HttpSessionShould() override {
+    ctx_.stop();
+    thread_.join();
+  }
+
+  // Sends a GET request for target and returns the response.
+  http::response<http::string_body> get(const string& target) {
+    net::io_context client_ctx;
+    beast::tcp_stream stream(client_ctx);
+    stream.connect(acceptor_.local_endpoint());
+
+    http::request<http::empty_body> req(http::verb::get, target, 11);
+    http::write(stream, req);
+
+    beast::flat_buffer buffer;
+    http::response<http::string_body> res;
+    http::read(stream, buffer, res);
+    return res;
+  }
+
+  Admission admission_;
+  net::io_context ctx_;
+  tcp::acceptor acceptor_{
+      ctx_, {net::ip::make_address("127.0.0.1"), 0}
+  };
+  LobbyManager manager_;
+  std::thread thread_;
+};
+
+class RateLimitedHttpSessionShould : public HttpSessionShould {
+ protected:
+  RateLimitedHttpSessionShould()
+      : HttpSessionShould({.accept_rate = 1}) {}
+};
+
+class SlowClientHttpSessionShould : public HttpSessionShould {
+ protected:
+  SlowClientHttpSessionShould()
+      : HttpSessionShould({}, {.upgrade_timeout = std::chrono::seconds(1)}) {}
+};
+
+TEST_F(HttpSessionShould, AnswerHealth) {
+  auto res = get("/health");
+
+  EXPECT_EQ(res.result(), http::status::ok);
+  EXPECT_EQ(res.body(), "ok\n");
+}
+
+TEST_F(HttpSessionShould, AnswerMetrics) {
+  auto res = get("/metrics");
+
+  EXPECT_EQ(res.result(), http::status::ok);
+  EXPECT_THAT(string(res[http::field::content_type]), HasSubstr("text/plain"));
+}
+
+TEST_F(HttpSessionShould, CloseAfterAnsweringKeepAliveRequest) {
+  net::io_context client_ctx;
+  beast::tcp_stream stream(client_ctx);
+  stream.connect(acceptor_.local_endpoint());
+
+  http::request<http::empty_body> req(http::verb::get, "/health", 11);
+  req.keep_alive(true);
+  http::write(stream, req);
+
+  beast::flat_buffer buffer;
+  http::response<http::string_body> res;
+  http::read(stream, buffer, res);
+  EXPECT_FALSE(res.keep_alive());
+
+  error_code ec;
+  http::read(stream, buffer, res, ec);
+  EXPECT_EQ(ec, http::error::end_of_stream);
+}
+
+TEST_F(HttpSessionShould, RejectUnknownTarget) {
+  auto res = get("/unknown");
+
+  EXPECT_EQ(res.result(), http::status::not_found);
+}
+
+TEST_F(RateLimitedHttpSessionShould, AnswerUnavailableWhenTurnedAway) {
+  const auto rejected = Metrics::instance().connections_rejected.value();
+  // Spends the only token before the test's connection is accepted.
+  ASSERT_TRUE(admission_.admit(0).admitted());
+
+  auto res = get("/health");
+
+  EXPECT_EQ(res.result(), http::status::service_unavailable);
+  EXPECT_FALSE(res[http::field::retry_after].empty());
+  EXPECT_FALSE(res.keep_alive());
+  EXPECT_EQ(Metrics::instance().connections_rejected.value(), rejected + 1);
+}
+
+TEST_F(SlowClientHttpSessionShould, CloseWhenRequestNeverArrives) {
+  const auto timed_out = Metrics::instance().closed(CloseReason::kUpgradeTimeout).value();
+  net::io_context client_ctx;
+  tcp::socket client(client_ctx);
+  client.connect(acceptor_.local_endpoint());
+
+  char byte;
+  error_code ec;
+  client.read_some(net::buffer(&byte, 1), ec);
+
+  EXPECT_EQ(ec, net::error::eof);
+  EXPECT_EQ(Metrics::instance().closed(CloseReason::kUpgradeTimeout).value(), timed_out + 1);
+}
+
+TEST_F(HttpSessionShould, KeepFramesSentWithUpgradeRequest) {
+  const auto pings = Metrics::instance().pings_fast_path.value();
+  net::io_context client_ctx;
+  tcp::socket client(client_ctx);
+  client.connect(acceptor_.local_endpoint());
+
+  // The upgrade request and a ping frame in one write. A zero mask leaves
+  // the payload as is.
+  const string payload = R"({"type":"ping"})";
+  string data
+      = "GET / HTTP/1.1\r\nHost: localhost\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+        "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n";
+  data += '\x81';
+  data += static_cast<char>(0x80 | payload.size());
+  data.append(4, '\0');
+  data += payload;
+  net::write(client, net::buffer(data));
+
+  // Reads with a deadline, since the pong never comes if the frame is lost.
+  constexpr auto kDeadline = std::chrono::seconds(5);
+  net::streambuf buffer;
+  std::size_t header = 0;
+  net::async_read_until(client, buffer, "\r\n\r\n", [&](error_code, std::size_t n) {
+    header = n;
+  });
+  client_ctx.run_for(kDeadline);
+  ASSERT_NE(header, 0);
+  EXPECT_THAT(string(net::buffers_begin(buffer.data()), net::buffers_begin(buffer.data()) + 12),
+              HasSubstr("101"));
+  buffer.consume(header);
+  if (buffer.size() == 0) {
+    client_ctx.restart();
+    net::async_read(client, buffer, net::transfer_at_least(1), [](error_code, std::size_t) {});
+    client_ctx.run_for(kDeadline);
+  }
+
+  // The pong, a text frame.
+  ASSERT_NE(buffer.size(), 0);
+  EXPECT_EQ(static_cast<uint8_t>(*net::buffers_begin(buffer.data())), 0x81);
+  EXPECT_EQ(Metrics::instance().pings_fast_path.value(), pings + 1);
+}
+
+}  // namespace io_blair::testing
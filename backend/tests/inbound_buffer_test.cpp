@@ -0,0 +1,67 @@
+#include "inbound_buffer.hpp"
+
+#include <gtest/gtest.h>
+
+#include <boost/asio/buffer.hpp>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+
+namespace io_blair::testing {
+using std::string;
+using std::string_view;
+
+namespace {
+// Writes str into buf the way a read would.
+void write(InboundBuffer& buf, string_view str) {
+  boost::asio::buffer_copy(buf.prepare(str.size()), boost::asio::buffer(str));
+  buf.commit(str.size());
+}
+}  // namespace
+
+TEST(InboundBufferShould, HoldSmallMessagesInline) {
+  InboundBuffer buf(4096);
+  write(buf, "arbitrary");
+
+  EXPECT_EQ(buf.view(), "arbitrary");
+  EXPECT_FALSE(buf.spilled());
+}
+
+TEST(InboundBufferShould, SpillLargeMessages) {
+  InboundBuffer buf(4096);
+  const string large(InboundBuffer::kInlineSize + 1, 'a');
+  write(buf, large);
+
+  EXPECT_EQ(buf.view(), large);
+  EXPECT_TRUE(buf.spilled());
+}
+
+TEST(InboundBufferShould, KeepDataWhenSpillingMidMessage) {
+  InboundBuffer buf(4096);
+  const string first(InboundBuffer::kInlineSize - 10, 'a');
+  const string second(100, 'b');
+  write(buf, first);
+  write(buf, second);
+
+  EXPECT_EQ(buf.view(), first + second);
+}
+
+TEST(InboundBufferShould, ReturnToInlineWhenConsumed) {
+  InboundBuffer buf(4096);
+  write(buf, string(InboundBuffer::kInlineSize * 2, 'a'));
+  buf.consume(buf.size());
+
+  EXPECT_EQ(buf.size(), 0);
+  EXPECT_FALSE(buf.spilled());
+  EXPECT_EQ(buf.capacity(), InboundBuffer::kInlineSize);
+}
+
+TEST(InboundBufferShould, ThrowPastMaxSize) {
+  InboundBuffer buf(1024);
+
+  EXPECT_THROW(buf.prepare(1025), std::length_error);
+}
+
+}  // namespace io_blair::testing
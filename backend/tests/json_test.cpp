@@ -2,11 +2,14 @@
 #include <gtest/gtest.h>
 
 #include <json.hpp>
+#include <string>
 
 #include "mock/mock_handler.hpp"
 
 
 namespace io_blair::testing {
+using std::string;
+using ::testing::_;
 using ::testing::StrictMock;
 
 TEST(JsonDecodeShould, NotCallHandlerOnInvalidJson) {
@@ -17,4 +20,39 @@ TEST(JsonDecodeShould, NotCallHandlerOnInvalidJson) {
   json::decode("invalid json", handler);
 }
 
+TEST(JsonDecodeShould, CallHandlerOnValidJson) {
+  StrictMock<MockHandler> handler;
+
+  EXPECT_CALL(handler, EvPing(_));
+
+  EXPECT_EQ(json::decode(R"({"type":"ping"})", handler), json::DecodeResult::kHandled);
+}
+
+TEST(JsonDecodeShould, NotCallHandlerWhenTooLargeForType) {
+  StrictMock<MockHandler> handler;
+  const string padded = R"({"type":"ping","pad":")"
+                        + string(json::in::kMaxSize<json::in::Ping>, 'x') + R"("})";
+
+  EXPECT_EQ(json::decode(padded, handler), json::DecodeResult::kTooLarge);
+}
+
+TEST(JsonEncodeShould, WriteCharacterMove) {
+  EXPECT_EQ(json::out::character_move({3, -1}, 261),
+            R"({"type":"characterMove","coordinate":[3,-1],"cell":261,"reset":false})");
+}
+
+TEST(JsonEncodeShould, WriteCharacterOtherMove) {
+  EXPECT_EQ(json::out::character_other_move(json::out::Direction::left, true),
+            R"({"type":"characterOtherMove","direction":"left","reset":true})");
+}
+
+TEST(JsonEncodeShould, WriteCoinTaken) {
+  EXPECT_EQ(json::out::coin_taken({0, 12}), R"({"type":"coinTaken","coordinate":[0,12]})");
+}
+
+TEST(JsonEncodeShould, WriteSpectateMove) {
+  EXPECT_EQ(json::out::spectate_move(Character::Blair, {1, 4}, true),
+            R"({"type":"spectateMove","character":"Blair","coordinate":[1,4],"reset":true})");
+}
+
 }  // namespace io_blair::testing
@@ -3,13 +3,18 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <chrono>
+#include <future>
 #include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
+#include <thread>
 
 #include "character.hpp"
 #include "event.hpp"
 #include "json.hpp"
+#include "message.hpp"
 #include "mock/mock_session.hpp"
 
 
@@ -18,11 +23,15 @@ using std::make_shared;
 using std::nullopt;
 using std::shared_ptr;
 using std::string;
+using std::string_view;
+using std::chrono::seconds;
+using time_point = std::chrono::steady_clock::time_point;
+using ::testing::AnyNumber;
 using ::testing::HasSubstr;
-using ::testing::Matcher;
 using ::testing::NiceMock;
-using ::testing::Pointee;
+using ::testing::SaveArg;
 using ::testing::StrictMock;
+using ::testing::_;
 namespace jout = json::out;
 
 TEST(LobbyControllerShould, SaveCode) {
@@ -45,9 +54,9 @@ TEST(LobbyControllerShould, SendOnOtherSessionJoining) {
   auto s1 = make_shared<MockSession>();
   auto s2 = make_shared<MockSession>();
 
-  EXPECT_CALL(*s1, async_send(Matcher<string>(HasSubstr("lobbyJoin"))));
-  EXPECT_CALL(*s1, async_send(Matcher<string>(HasSubstr("lobbyOtherJoin"))));
-  EXPECT_CALL(*s2, async_send(Matcher<string>(HasSubstr("lobbyJoin"))));
+  EXPECT_CALL(*s1, async_send(HasSubstr("lobbyJoin")));
+  EXPECT_CALL(*s1, async_send(HasSubstr("lobbyOtherJoin")));
+  EXPECT_CALL(*s2, async_send(HasSubstr("lobbyJoin")));
 
   controller.join(s1);
   controller.join(s2);
@@ -93,9 +102,9 @@ TEST(LobbyControllerShould, SendOnOtherSessionLeaving) {
   auto s1 = make_shared<NiceMock<MockSession>>();
   auto s2 = make_shared<NiceMock<MockSession>>();
 
-  EXPECT_CALL(*s1, async_send(Matcher<string>(HasSubstr("lobbyJoin"))));
-  EXPECT_CALL(*s1, async_send(Matcher<string>(HasSubstr("lobbyOtherJoin"))));
-  EXPECT_CALL(*s2, async_send(Matcher<string>(HasSubstr("lobbyJoin"))));
+  EXPECT_CALL(*s1, async_send(HasSubstr("lobbyJoin")));
+  EXPECT_CALL(*s1, async_send(HasSubstr("lobbyOtherJoin")));
+  EXPECT_CALL(*s2, async_send(HasSubstr("lobbyJoin")));
   EXPECT_CALL(*s2, async_send(jout::lobby_other_leave()));
   EXPECT_CALL(*s2, async_handle(SessionEvent::kTransitionToCharacterSelect));
 
@@ -104,6 +113,210 @@ TEST(LobbyControllerShould, SendOnOtherSessionLeaving) {
   controller.leave(s1);
 }
 
+// Gets the resume token out of a lobbyJoin or lobbyResume.
+string resume_token_of(const Message& msg) {
+  constexpr string_view kKey = R"("resumeToken":")";
+  const string_view view     = msg.view();
+  const auto begin           = view.find(kKey) + kKey.size();
+  return string(view.substr(begin, view.find('"', begin) - begin));
+}
+
+class LobbyControllerResumeShould : public ::testing::Test {
+ protected:
+  LobbyControllerResumeShould() {
+    EXPECT_CALL(*s1_, async_send(_)).Times(AnyNumber());
+    EXPECT_CALL(*s1_, async_send(HasSubstr("lobbyJoin"))).WillOnce(SaveArg<0>(&join_));
+    ctx1_.emplace(*controller_.join(s1_));
+    ctx2_.emplace(*controller_.join(s2_));
+  }
+
+  const time_point deadline_ = time_point() + seconds(30);
+
+  LobbyController controller_{"CODE42"};
+  shared_ptr<NiceMock<MockSession>> s1_ = make_shared<NiceMock<MockSession>>();
+  shared_ptr<NiceMock<MockSession>> s2_ = make_shared<NiceMock<MockSession>>();
+  shared_ptr<NiceMock<MockSession>> s3_ = make_shared<NiceMock<MockSession>>();
+
+  std::optional<LobbyContext> ctx1_;
+  std::optional<LobbyContext> ctx2_;
+
+  // The lobbyJoin sent to s1_.
+  Message join_;
+};
+
+TEST_F(LobbyControllerResumeShould, IssueTokenNamingLobby) {
+  EXPECT_EQ(LobbyController::resume_token_code(resume_token_of(join_)), controller_.code_);
+}
+
+TEST_F(LobbyControllerResumeShould, ResumeSuspendedPlayerWithoutTellingOther) {
+  EXPECT_CALL(*s2_, async_send(jout::lobby_other_leave())).Times(0);
+  EXPECT_CALL(*s3_, async_send(HasSubstr("lobbyResume")));
+
+  controller_.suspend(s1_, deadline_);
+
+  EXPECT_NE(controller_.resume(s3_, resume_token_of(join_)), nullopt);
+}
+
+TEST_F(LobbyControllerResumeShould, HoldSuspendedPlayerFromJoins) {
+  controller_.suspend(s1_, deadline_);
+  s1_.reset();
+
+  EXPECT_EQ(controller_.join(s3_), nullopt);
+  EXPECT_FALSE(controller_.empty());
+}
+
+TEST_F(LobbyControllerResumeShould, NotResumeWithWrongToken) {
+  controller_.suspend(s1_, deadline_);
+
+  EXPECT_EQ(controller_.resume(s3_, controller_.code_ + ".0"), nullopt);
+}
+
+TEST_F(LobbyControllerResumeShould, NotResumeConnectedPlayer) {
+  EXPECT_EQ(controller_.resume(s3_, resume_token_of(join_)), nullopt);
+}
+
+TEST_F(LobbyControllerResumeShould, NotReuseTokens) {
+  controller_.suspend(s1_, deadline_);
+  controller_.resume(s3_, resume_token_of(join_));
+  controller_.suspend(s3_, deadline_);
+
+  EXPECT_EQ(controller_.resume(make_shared<NiceMock<MockSession>>(), resume_token_of(join_)),
+            nullopt);
+}
+
+TEST_F(LobbyControllerResumeShould, ResyncInGamePlayer) {
+  EXPECT_CALL(*s3_, async_send(HasSubstr("lobbyResume")));
+  EXPECT_CALL(*s3_, async_send(jout::transition_to_ingame()));
+  EXPECT_CALL(*s3_, async_handle(SessionEvent::kTransitionToInGame));
+  EXPECT_CALL(*s3_, async_send(HasSubstr("inGameMaze")));
+
+  ctx1_->controller->set_character(Character::Io);
+  ctx2_->controller->set_character(Character::Blair);
+  controller_.suspend(s1_, deadline_);
+
+  EXPECT_NE(controller_.resume(s3_, resume_token_of(join_)), nullopt);
+}
+
+TEST_F(LobbyControllerResumeShould, RemoveExpiredPlayer) {
+  EXPECT_CALL(*s2_, async_send(jout::lobby_other_leave()));
+  EXPECT_CALL(*s2_, async_handle(SessionEvent::kTransitionToCharacterSelect));
+
+  controller_.suspend(s1_, deadline_);
+
+  EXPECT_EQ(controller_.expire(deadline_ - seconds(1)), 0);
+  EXPECT_EQ(controller_.expire(deadline_), 1);
+  EXPECT_EQ(controller_.resume(s3_, resume_token_of(join_)), nullopt);
+}
+
+class LobbyControllerSpectateShould : public ::testing::Test {
+ protected:
+  LobbyControllerSpectateShould() {
+    ctx1_.emplace(*controller_.join(s1_));
+    ctx2_.emplace(*controller_.join(s2_));
+  }
+
+  // Starts a game, which sends spectators the maze.
+  void start_game() {
+    ctx1_->controller->set_character(Character::Io);
+    ctx2_->controller->set_character(Character::Blair);
+  }
+
+  LobbyController controller_{"CODE42"};
+  shared_ptr<NiceMock<MockSession>> s1_ = make_shared<NiceMock<MockSession>>();
+  shared_ptr<NiceMock<MockSession>> s2_ = make_shared<NiceMock<MockSession>>();
+  shared_ptr<NiceMock<MockSession>> s3_ = make_shared<NiceMock<MockSession>>();
+  shared_ptr<NiceMock<MockSession>> s4_ = make_shared<NiceMock<MockSession>>();
+
+  std::optional<LobbyContext> ctx1_;
+  std::optional<LobbyContext> ctx2_;
+};
+
+TEST_F(LobbyControllerSpectateShould, SendJoinToSpectator) {
+  EXPECT_CALL(*s3_, async_send(HasSubstr("spectateJoin")));
+
+  EXPECT_TRUE(controller_.spectate(s3_));
+  EXPECT_EQ(controller_.spectators(), 1);
+}
+
+TEST_F(LobbyControllerSpectateShould, NotTakeSpectatorsPlace) {
+  controller_.spectate(s3_);
+
+  EXPECT_EQ(controller_.players(), 2);
+}
+
+TEST_F(LobbyControllerSpectateShould, SendEverySpectatorTheSamePayload) {
+  Message first;
+  Message second;
+  EXPECT_CALL(*s3_, async_send(_)).Times(AnyNumber());
+  EXPECT_CALL(*s4_, async_send(_)).Times(AnyNumber());
+  EXPECT_CALL(*s3_, async_send(HasSubstr("spectateMove"))).WillOnce(SaveArg<0>(&first));
+  EXPECT_CALL(*s4_, async_send(HasSubstr("spectateMove"))).WillOnce(SaveArg<0>(&second));
+
+  controller_.spectate(s3_);
+  controller_.spectate(s4_);
+  start_game();
+  ctx1_->controller->move_character({1, 3});
+
+  EXPECT_EQ(first.data(), second.data());
+}
+
+TEST_F(LobbyControllerSpectateShould, SendToSpectatorsWithoutHoldingLobby) {
+  // Asks the lobby from another thread, which would wait on a held lock.
+  std::promise<void> asked;
+  std::thread asker;
+  bool available = false;
+  EXPECT_CALL(*s3_, async_send(_)).Times(AnyNumber());
+  EXPECT_CALL(*s3_, async_send(HasSubstr("spectateMove"))).WillOnce([&](const Message&) {
+    asker = std::thread([&] {
+      controller_.players();
+      asked.set_value();
+    });
+    available = asked.get_future().wait_for(seconds(1)) == std::future_status::ready;
+  });
+
+  controller_.spectate(s3_);
+  start_game();
+  ctx1_->controller->move_character({1, 3});
+  asker.join();
+
+  EXPECT_TRUE(available);
+}
+
+TEST_F(LobbyControllerSpectateShould, ResyncSpectatorJoiningMidGame) {
+  EXPECT_CALL(*s3_, async_send(HasSubstr("spectateJoin")));
+  EXPECT_CALL(*s3_, async_send(jout::transition_to_ingame()));
+  EXPECT_CALL(*s3_, async_send(HasSubstr("spectateMaze")));
+  EXPECT_CALL(*s3_, async_send(jout::spectate_move(Character::Io, {1, 4}, false)));
+  EXPECT_CALL(*s3_, async_send(jout::spectate_move(Character::Blair, {1, 4}, false)));
+
+  start_game();
+  controller_.spectate(s3_);
+}
+
+TEST_F(LobbyControllerSpectateShould, StopSendingAfterUnspectate) {
+  EXPECT_CALL(*s3_, async_send(_)).Times(AnyNumber());
+  EXPECT_CALL(*s3_, async_send(HasSubstr("spectateMaze"))).Times(0);
+
+  controller_.spectate(s3_);
+  controller_.unspectate(s3_);
+  start_game();
+
+  EXPECT_EQ(controller_.spectators(), 0);
+}
+
+TEST_F(LobbyControllerSpectateShould, SendSpectatorsAwayOnClose) {
+  EXPECT_CALL(*s3_, async_send(_)).Times(AnyNumber());
+  EXPECT_CALL(*s3_, async_send(jout::lobby_closed()));
+  EXPECT_CALL(*s3_, async_handle(SessionEvent::kLobbyClosed));
+  EXPECT_CALL(*s4_, async_send(HasSubstr("spectateJoin")));
+
+  controller_.spectate(s3_);
+  controller_.close();
+
+  EXPECT_FALSE(controller_.spectate(s4_));
+  EXPECT_EQ(controller_.spectators(), 0);
+}
+
 class LobbyControllerFShould : public ::testing::Test {
  protected:
   std::shared_ptr<StrictMock<MockSession>> s1_ = std::make_shared<StrictMock<MockSession>>();
@@ -167,23 +380,22 @@ TEST_F(LobbyControllerFShould, SetCharacterToUnknown) {
 }
 
 TEST_F(LobbyControllerFShould, SetCharactersAndTransitionToInGame) {
-  using MatcherSharedStr = Matcher<shared_ptr<const string>>;
 
-  EXPECT_CALL(*s1_, async_send(Matcher<string>(HasSubstr("lobbyJoin"))));
-  EXPECT_CALL(*s1_, async_send(Matcher<string>(HasSubstr("lobbyOtherJoin"))));
-  EXPECT_CALL(*s2_, async_send(Matcher<string>(HasSubstr("lobbyJoin"))));
+  EXPECT_CALL(*s1_, async_send(HasSubstr("lobbyJoin")));
+  EXPECT_CALL(*s1_, async_send(HasSubstr("lobbyOtherJoin")));
+  EXPECT_CALL(*s2_, async_send(HasSubstr("lobbyJoin")));
 
   EXPECT_CALL(*s1_, async_send(jout::character_confirm(Character::Blair)));
   EXPECT_CALL(*s2_, async_send(jout::character_confirm(Character::Io)));
 
   EXPECT_CALL(*s1_, async_handle(SessionEvent::kTransitionToInGame));
-  EXPECT_CALL(*s1_, async_send(MatcherSharedStr(Pointee(jout::transition_to_ingame()))));
+  EXPECT_CALL(*s1_, async_send(jout::transition_to_ingame()));
 
   EXPECT_CALL(*s2_, async_handle(SessionEvent::kTransitionToInGame));
-  EXPECT_CALL(*s2_, async_send(MatcherSharedStr(Pointee(jout::transition_to_ingame()))));
+  EXPECT_CALL(*s2_, async_send(jout::transition_to_ingame()));
 
-  EXPECT_CALL(*s1_, async_send(Matcher<string>(HasSubstr("inGameMaze"))));
-  EXPECT_CALL(*s2_, async_send(Matcher<string>(HasSubstr("inGameMaze"))));
+  EXPECT_CALL(*s1_, async_send(HasSubstr("inGameMaze")));
+  EXPECT_CALL(*s2_, async_send(HasSubstr("inGameMaze")));
 
   p1_.try_set(s1_);
   p2_.try_set(s2_);
@@ -0,0 +1,147 @@
+#include "lobby_manager.hpp"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "code_allocator.hpp"
+#include "event.hpp"
+#include "json.hpp"
+#include "lobby_options.hpp"
+#include "matchmaker.hpp"
+#include "metrics.hpp"
+#include "mock/mock_session.hpp"
+
+
+namespace io_blair::testing {
+using std::make_shared;
+using std::shared_ptr;
+using std::string;
+using std::chrono::seconds;
+using ::testing::AnyNumber;
+using ::testing::HasSubstr;
+using ::testing::NiceMock;
+using ::testing::_;
+namespace jout = json::out;
+
+class LobbyManagerShould : public ::testing::Test {
+ protected:
+  LobbyManagerShould() {
+    EXPECT_CALL(*s1_, async_send(_)).Times(AnyNumber());
+    EXPECT_CALL(*s2_, async_send(_)).Times(AnyNumber());
+  }
+
+  // Runs the manager's timers as if after has passed.
+  void expire_after(seconds after) {
+    manager_.expire(std::chrono::steady_clock::now() + after);
+  }
+
+  LobbyManager manager_{
+      {.resume_grace = seconds(5), .idle_timeout = seconds(60), .half_empty_timeout = seconds(10)}
+  };
+  shared_ptr<NiceMock<MockSession>> s1_ = make_shared<NiceMock<MockSession>>();
+  shared_ptr<NiceMock<MockSession>> s2_ = make_shared<NiceMock<MockSession>>();
+
+  const uint64_t reaped_ = Metrics::instance().lobbies_reaped.value();
+};
+
+TEST_F(LobbyManagerShould, PlaceMatchedSessionsInOneLobby) {
+  EXPECT_CALL(*s1_, async_handle(SessionEvent::kMatchFound));
+  EXPECT_CALL(*s2_, async_handle(SessionEvent::kMatchFound));
+
+  const auto lobbies = Metrics::instance().lobbies_active.value();
+
+  const auto a = manager_.matchmake(s1_, Character::Io);
+  const auto b = manager_.matchmake(s2_, Character::unknown);
+
+  ASSERT_TRUE(a->match.has_value());
+  ASSERT_TRUE(b->match.has_value());
+  EXPECT_EQ(a->match->code, b->match->code);
+  EXPECT_EQ(Metrics::instance().lobbies_active.value(), lobbies + 1);
+}
+
+TEST_F(LobbyManagerShould, NotResumeClosedSession) {
+  std::weak_ptr<ISession> closed = make_shared<NiceMock<MockSession>>();
+
+  EXPECT_FALSE(manager_.resume(closed, "NOCODE.token").has_value());
+}
+
+TEST_F(LobbyManagerShould, NotSpectateWithClosedSession) {
+  std::weak_ptr<ISession> closed = make_shared<NiceMock<MockSession>>();
+
+  EXPECT_FALSE(manager_.spectate(closed, "NOCODE"));
+}
+
+TEST_F(LobbyManagerShould, CloseHalfEmptyLobbies) {
+  EXPECT_CALL(*s1_, async_send(jout::lobby_closed()));
+  EXPECT_CALL(*s1_, async_handle(SessionEvent::kLobbyClosed));
+
+  manager_.create(s1_);
+  expire_after(seconds(11));
+
+  EXPECT_EQ(Metrics::instance().lobbies_reaped.value(), reaped_ + 1);
+}
+
+TEST_F(LobbyManagerShould, CloseIdleLobbies) {
+  EXPECT_CALL(*s1_, async_send(jout::lobby_closed()));
+  EXPECT_CALL(*s2_, async_send(jout::lobby_closed()));
+
+  const string code(manager_.create(s1_).code);
+  manager_.join(s2_, code);
+  expire_after(seconds(11));
+  expire_after(seconds(61));
+
+  EXPECT_EQ(Metrics::instance().lobbies_reaped.value(), reaped_ + 1);
+}
+
+TEST_F(LobbyManagerShould, KeepActiveLobbies) {
+  EXPECT_CALL(*s1_, async_send(jout::lobby_closed())).Times(0);
+
+  const string code(manager_.create(s1_).code);
+  manager_.join(s2_, code);
+  expire_after(seconds(11));
+
+  EXPECT_EQ(Metrics::instance().lobbies_reaped.value(), reaped_);
+}
+
+TEST_F(LobbyManagerShould, ReapLobbiesWhosePlayersVanished) {
+  const string code(manager_.create(s1_).code);
+  s1_.reset();
+  expire_after(seconds(11));
+
+  EXPECT_EQ(Metrics::instance().lobbies_reaped.value(), reaped_ + 1);
+  // The lobby is gone, so joining it fails.
+  EXPECT_CALL(*s2_, async_send(HasSubstr("lobbyJoin")));
+  EXPECT_EQ(manager_.join(s2_, code), std::nullopt);
+}
+
+TEST_F(LobbyManagerShould, SkipTimersOfClosedLobbyWhenCodeIsReused) {
+  const string code(manager_.create(s1_).code);
+  manager_.leave(s1_, code);
+  // Enough closed lobbies for the first code to come out of quarantine.
+  for (std::size_t i = 0; i < CodeAllocator::kQuarantine; ++i) {
+    manager_.leave(s1_, string(manager_.create(s1_).code));
+  }
+  ASSERT_EQ(manager_.create(s1_).code, code);
+
+  expire_after(seconds(11));
+
+  // Only the reused code's own timer reaped it, and it alone checks on it again.
+  EXPECT_EQ(Metrics::instance().lobbies_reaped.value(), reaped_ + 1);
+  EXPECT_EQ(Metrics::instance().lobby_timers.value(), 1);
+}
+
+TEST_F(LobbyManagerShould, RemoveSuspendedPlayersAfterGrace) {
+  EXPECT_CALL(*s2_, async_send(jout::lobby_other_leave()));
+
+  const string code(manager_.create(s1_).code);
+  manager_.join(s2_, code);
+  manager_.suspend(s1_, code);
+  expire_after(seconds(6));
+}
+
+}  // namespace io_blair::testing
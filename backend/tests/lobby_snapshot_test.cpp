@@ -0,0 +1,156 @@
+#include "lobby_snapshot.hpp"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "character.hpp"
+#include "lobby_controller.hpp"
+#include "lobby_manager.hpp"
+#include "message.hpp"
+#include "metrics.hpp"
+#include "mock/mock_session.hpp"
+
+
+namespace io_blair::testing {
+using std::make_shared;
+using std::nullopt;
+using std::shared_ptr;
+using std::string;
+using std::string_view;
+using std::chrono::seconds;
+using ::testing::AnyNumber;
+using ::testing::HasSubstr;
+using ::testing::NiceMock;
+using ::testing::SaveArg;
+using ::testing::_;
+namespace fs = std::filesystem;
+
+namespace {
+// Gets the resume token out of a lobbyJoin.
+string token_of(const Message& msg) {
+  constexpr string_view kKey = R"("resumeToken":")";
+  const string_view view     = msg.view();
+  const auto begin           = view.find(kKey) + kKey.size();
+  return string(view.substr(begin, view.find('"', begin) - begin));
+}
+
+// Determines whether a and b saved the same lobby.
+bool same_lobby(const LobbyImage& a, const LobbyImage& b) {
+  const auto same_seat = [](const LobbyImage::Seat& x, const LobbyImage::Seat& y) {
+    return x.occupied == y.occupied && x.character == y.character && x.x == y.x && x.y == y.y &&
+           x.resume_token == y.resume_token;
+  };
+  return a.code == b.code && same_seat(a.seats[0], b.seats[0]) &&
+         same_seat(a.seats[1], b.seats[1]) && a.cells == b.cells;
+}
+}  // namespace
+
+class LobbySnapshotShould : public ::testing::Test {
+ protected:
+  ~LobbySnapshotShould() override {
+    fs::remove(path_);
+  }
+
+  const string path_ = (fs::temp_directory_path() / "io_blair_snapshot_test.bin").string();
+};
+
+TEST_F(LobbySnapshotShould, RoundTripImages) {
+  ASSERT_TRUE(LobbySnapshot::save(path_, 3, [](std::span<LobbyImage> images) {
+    LobbyImage::put(images[0].code, "ABC123");
+    LobbyImage::put(images[1].code, "XYZ789");
+    return 2;
+  }));
+
+  const auto snapshot = LobbySnapshot::open(path_);
+  ASSERT_TRUE(snapshot.has_value());
+  ASSERT_EQ(snapshot->images().size(), 2);
+  EXPECT_EQ(LobbyImage::get(snapshot->images()[0].code), "ABC123");
+  EXPECT_EQ(LobbyImage::get(snapshot->images()[1].code), "XYZ789");
+}
+
+TEST_F(LobbySnapshotShould, RejectOtherFiles) {
+  EXPECT_FALSE(LobbySnapshot::open(path_).has_value());
+
+  std::FILE* file = std::fopen(path_.c_str(), "wb");
+  ASSERT_NE(file, nullptr);
+  const string junk(256, 'x');
+  std::fwrite(junk.data(), 1, junk.size(), file);
+  std::fclose(file);
+
+  EXPECT_FALSE(LobbySnapshot::open(path_).has_value());
+}
+
+TEST_F(LobbySnapshotShould, RestoreControllerAsSaved) {
+  LobbyController controller("CODE42");
+  auto s1  = make_shared<NiceMock<MockSession>>();
+  auto s2  = make_shared<NiceMock<MockSession>>();
+  auto ctx = controller.join(s1);
+  controller.join(s2)->controller->set_character(Character::Blair);
+  ctx->controller->set_character(Character::Io);
+
+  LobbyImage image{};
+  ASSERT_TRUE(controller.save(image));
+  const LobbyController restored(image, std::chrono::steady_clock::now() + seconds(30));
+  LobbyImage again{};
+  ASSERT_TRUE(restored.save(again));
+
+  EXPECT_EQ(restored.code_, controller.code_);
+  EXPECT_EQ(restored.players(), 2);
+  EXPECT_TRUE(same_lobby(image, again));
+}
+
+TEST_F(LobbySnapshotShould, LetPlayersResumeAfterRestart) {
+  auto s1 = make_shared<NiceMock<MockSession>>();
+  auto s2 = make_shared<NiceMock<MockSession>>();
+  auto s3 = make_shared<NiceMock<MockSession>>();
+  Message join;
+  EXPECT_CALL(*s1, async_send(_)).Times(AnyNumber());
+  EXPECT_CALL(*s1, async_send(HasSubstr("lobbyJoin"))).WillOnce(SaveArg<0>(&join));
+  EXPECT_CALL(*s3, async_send(HasSubstr("lobbyResume")));
+  const auto restored = Metrics::instance().lobbies_restored.value();
+
+  {
+    LobbyManager before;
+    const string code(before.create(s1).code);
+    before.join(s2, code);
+    ASSERT_TRUE(before.snapshot(path_));
+  }
+
+  LobbyManager after({.resume_grace = seconds(5)});
+  EXPECT_EQ(after.restore(path_), 1);
+  EXPECT_FALSE(fs::exists(path_));
+
+  EXPECT_NE(after.resume(s3, token_of(join)), nullopt);
+  EXPECT_EQ(Metrics::instance().lobbies_restored.value(), restored + 1);
+}
+
+TEST_F(LobbySnapshotShould, DropLobbiesNoOneCameBackTo) {
+  auto s1 = make_shared<NiceMock<MockSession>>();
+  auto s3 = make_shared<NiceMock<MockSession>>();
+  Message join;
+  EXPECT_CALL(*s1, async_send(_)).Times(AnyNumber());
+  EXPECT_CALL(*s1, async_send(HasSubstr("lobbyJoin"))).WillOnce(SaveArg<0>(&join));
+
+  {
+    LobbyManager before;
+    before.create(s1);
+    ASSERT_TRUE(before.snapshot(path_));
+  }
+
+  LobbyManager after({.resume_grace = seconds(5)});
+  after.restore(path_);
+  after.expire(std::chrono::steady_clock::now() + seconds(10));
+
+  EXPECT_EQ(after.resume(s3, token_of(join)), nullopt);
+}
+
+}  // namespace io_blair::testing
@@ -19,6 +19,8 @@ using ::std::make_shared;
 using ::std::shared_ptr;
 using ::std::string;
 using ::testing::StrictMock;
+using ::testing::VariantWith;
+using ::testing::_;
 namespace jin  = json::in;
 namespace jout = json::out;
 
@@ -40,11 +42,20 @@ TEST_F(LobbyShould, TransitionOnLeave) {
   Lobby lobby(std::move(lob_ctx_));
 
   EXPECT_CALL(manager_, leave);
-  EXPECT_CALL(game_, transition_to);
+  EXPECT_CALL(game_, transition_to(VariantWith<Prelobby>(_)));
 
   lobby(game_, sess_ctx_, jin::LobbyLeave{});
 }
 
+TEST_F(LobbyShould, SuspendAndTransitionOnClose) {
+  Lobby lobby(std::move(lob_ctx_));
+
+  EXPECT_CALL(manager_, suspend);
+  EXPECT_CALL(game_, transition_to(VariantWith<Prelobby>(_)));
+
+  lobby(game_, sess_ctx_, SessionEvent::kCloseSession);
+}
+
 TEST_F(LobbyShould, SendOnMsg) {
   Lobby lobby(std::move(lob_ctx_));
   const string msg = "arbitrary";
@@ -0,0 +1,117 @@
+#include "logging.hpp"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <string>
+
+
+namespace io_blair::testing {
+using std::string;
+using ::testing::HasSubstr;
+using ::testing::Not;
+namespace logging = io_blair::logging;
+
+namespace {
+logging::Record make_record() {
+  logging::Record record{};
+  record.level = logging::Level::kInfo;
+  return record;
+}
+
+// Reads back everything written to file.
+string read_all(std::FILE* file) {
+  std::rewind(file);
+  string res;
+  char buf[256];
+  while (const size_t n = std::fread(buf, 1, sizeof(buf), file)) {
+    res.append(buf, n);
+  }
+  return res;
+}
+}  // namespace
+
+TEST(RecordRingShould, PopInPushOrder) {
+  logging::RecordRing ring;
+  auto r1    = make_record();
+  r1.session = 1;
+  auto r2    = make_record();
+  r2.session = 2;
+
+  ASSERT_TRUE(ring.push(r1));
+  ASSERT_TRUE(ring.push(r2));
+
+  logging::Record out;
+  ASSERT_TRUE(ring.pop(out));
+  EXPECT_EQ(out.session, 1);
+  ASSERT_TRUE(ring.pop(out));
+  EXPECT_EQ(out.session, 2);
+  EXPECT_FALSE(ring.pop(out));
+}
+
+TEST(RecordRingShould, RejectPushWhenFull) {
+  logging::RecordRing ring;
+  const auto record = make_record();
+
+  for (size_t i = 0; i < logging::RecordRing::kCapacity; ++i) {
+    ASSERT_TRUE(ring.push(record));
+  }
+  EXPECT_FALSE(ring.push(record));
+}
+
+TEST(LevelShould, ParseNames) {
+  EXPECT_EQ(logging::parse_level("debug", logging::Level::kError), logging::Level::kDebug);
+  EXPECT_EQ(logging::parse_level("warn", logging::Level::kError), logging::Level::kWarn);
+  EXPECT_EQ(logging::parse_level("bogus", logging::Level::kError), logging::Level::kError);
+}
+
+class LoggerShould : public ::testing::Test {
+ protected:
+  // Points the logger back at stdout so later flushes don't use a closed file.
+  ~LoggerShould() override {
+    logging::Logger::instance().start(stdout);
+    logging::Logger::instance().stop();
+  }
+};
+
+TEST_F(LoggerShould, WriteStructuredJsonLines) {
+  std::FILE* file = std::tmpfile();
+  ASSERT_NE(file, nullptr);
+  auto& logger = logging::Logger::instance();
+
+  logger.start(file);
+  logging::info("hello \"world\"", {.session = 7, .lobby = "ABC123"});
+  logging::debug("filtered out");
+  logger.stop();
+
+  const string out = read_all(file);
+  std::fclose(file);
+
+  EXPECT_THAT(out, HasSubstr("\"level\":\"info\""));
+  EXPECT_THAT(out, HasSubstr("\"msg\":\"hello \\\"world\\\"\""));
+  EXPECT_THAT(out, HasSubstr("\"session\":7"));
+  EXPECT_THAT(out, HasSubstr("\"lobby\":\"ABC123\""));
+  EXPECT_THAT(out, Not(HasSubstr("filtered out")));
+}
+
+TEST_F(LoggerShould, CountDroppedRecordsWhenBehind) {
+  auto& logger        = logging::Logger::instance();
+  const auto before   = logger.dropped();
+  constexpr int kMany = logging::RecordRing::kCapacity * 2;
+
+  // The background thread isn't running, so nothing drains the ring.
+  for (int i = 0; i < kMany; ++i) {
+    logging::warn("flood");
+  }
+
+  EXPECT_GE(logger.dropped() - before, logging::RecordRing::kCapacity);
+
+  std::FILE* file = std::tmpfile();
+  ASSERT_NE(file, nullptr);
+  logger.start(file);
+  logger.stop();
+  std::fclose(file);
+}
+
+}  // namespace io_blair::testing
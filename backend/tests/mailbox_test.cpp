@@ -0,0 +1,78 @@
+#include "mailbox.hpp"
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <utility>
+#include <vector>
+
+
+namespace io_blair::testing {
+
+TEST(MailboxShould, DrainInPushOrder) {
+  Mailbox<int> mailbox;
+  mailbox.push(1);
+  mailbox.push(2);
+  mailbox.push(3);
+
+  std::vector<int> drained;
+  mailbox.drain([&](int&& value) { drained.push_back(value); });
+
+  EXPECT_EQ(drained, (std::vector<int>{1, 2, 3}));
+}
+
+TEST(MailboxShould, ReportPushToEmptyMailbox) {
+  Mailbox<int> mailbox;
+
+  EXPECT_TRUE(mailbox.push(1));
+  EXPECT_FALSE(mailbox.push(2));
+
+  mailbox.drain([](int&&) {});
+  EXPECT_TRUE(mailbox.push(3));
+}
+
+TEST(MailboxShould, KeepEveryValueFromConcurrentProducers) {
+  constexpr int kProducers   = 4;
+  constexpr int kPerProducer = 10'000;
+  Mailbox<std::pair<int, int>> mailbox;
+
+  std::atomic<bool> done{false};
+  std::array<int, kProducers> next{};
+  std::size_t drained = 0;
+  bool in_order       = true;
+  auto consume        = [&](std::pair<int, int>&& value) {
+    auto [producer, seq] = value;
+    in_order             = in_order && seq == next[producer];
+    next[producer]       = seq + 1;
+    ++drained;
+  };
+
+  std::thread consumer([&] {
+    while (!done.load()) {
+      mailbox.drain(consume);
+    }
+    mailbox.drain(consume);
+  });
+
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kProducers; ++p) {
+    producers.emplace_back([&mailbox, p] {
+      for (int i = 0; i < kPerProducer; ++i) {
+        mailbox.push({p, i});
+      }
+    });
+  }
+  for (auto& producer : producers) {
+    producer.join();
+  }
+  done.store(true);
+  consumer.join();
+
+  EXPECT_EQ(drained, kProducers * kPerProducer);
+  EXPECT_TRUE(in_order);
+}
+
+}  // namespace io_blair::testing
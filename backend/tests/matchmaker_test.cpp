@@ -0,0 +1,172 @@
+#include "matchmaker.hpp"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "event.hpp"
+#include "metrics.hpp"
+#include "mock/mock_session.hpp"
+
+
+namespace io_blair::testing {
+using std::make_shared;
+using std::pair;
+using std::shared_ptr;
+using std::vector;
+using ::testing::NiceMock;
+using State = MatchTicket::State;
+
+class MatchmakerShould : public ::testing::Test {
+ protected:
+  // Makes a ticket for a new session that lives as long as the fixture.
+  shared_ptr<MatchTicket> ticket(Character preference = Character::unknown) {
+    sessions_.push_back(make_shared<NiceMock<MockSession>>());
+    return make_shared<MatchTicket>(sessions_.back(), preference);
+  }
+
+  vector<shared_ptr<NiceMock<MockSession>>> sessions_;
+  vector<pair<MatchTicket*, MatchTicket*>> matches_;
+  Matchmaker matchmaker_{[this](MatchTicket& a, MatchTicket& b) { matches_.emplace_back(&a, &b); }};
+};
+
+TEST_F(MatchmakerShould, PairOldestFirst) {
+  auto a = ticket();
+  auto b = ticket();
+  auto c = ticket();
+
+  matchmaker_.enqueue(a);
+  matchmaker_.enqueue(b);
+  matchmaker_.enqueue(c);
+
+  ASSERT_EQ(matches_.size(), 1);
+  EXPECT_EQ(matches_[0].first, a.get());
+  EXPECT_EQ(matches_[0].second, b.get());
+  EXPECT_EQ(c->state(), State::kWaiting);
+}
+
+TEST_F(MatchmakerShould, PairComplementaryPreferences) {
+  auto io       = ticket(Character::Io);
+  auto io_too   = ticket(Character::Io);
+  auto blair    = ticket(Character::Blair);
+  auto flexible = ticket();
+
+  matchmaker_.enqueue(io);
+  matchmaker_.enqueue(io_too);
+  EXPECT_TRUE(matches_.empty());
+
+  matchmaker_.enqueue(blair);
+  matchmaker_.enqueue(flexible);
+
+  ASSERT_EQ(matches_.size(), 2);
+  EXPECT_EQ(matches_[0], pair(io.get(), blair.get()));
+  EXPECT_EQ(matches_[1], pair(io_too.get(), flexible.get()));
+}
+
+TEST_F(MatchmakerShould, SkipCancelledTickets) {
+  auto a = ticket();
+  auto b = ticket();
+  auto c = ticket();
+
+  matchmaker_.enqueue(a);
+  EXPECT_TRUE(a->cancel());
+  matchmaker_.enqueue(b);
+  matchmaker_.enqueue(c);
+
+  ASSERT_EQ(matches_.size(), 1);
+  EXPECT_EQ(matches_[0], pair(b.get(), c.get()));
+}
+
+TEST_F(MatchmakerShould, DropCancelledTicketsBehindWaitingOne) {
+  // No one can be paired with a, so it stays at the front of its queue.
+  auto a = ticket(Character::Io);
+  matchmaker_.enqueue(a);
+
+  for (int i = 0; i < 1000; ++i) {
+    auto requeued = ticket(Character::Io);
+    matchmaker_.enqueue(requeued);
+    EXPECT_TRUE(requeued->cancel());
+  }
+
+  EXPECT_LT(matchmaker_.size(), 64);
+  EXPECT_EQ(a->state(), State::kWaiting);
+}
+
+TEST_F(MatchmakerShould, SkipClosedSessions) {
+  auto a = ticket();
+  auto b = ticket();
+  auto c = ticket();
+
+  matchmaker_.enqueue(a);
+  sessions_[0].reset();
+  matchmaker_.enqueue(b);
+  matchmaker_.enqueue(c);
+
+  ASSERT_EQ(matches_.size(), 1);
+  EXPECT_EQ(matches_[0], pair(b.get(), c.get()));
+}
+
+TEST_F(MatchmakerShould, NotCancelMatchedTickets) {
+  auto a = ticket();
+  auto b = ticket();
+  EXPECT_CALL(*sessions_[0], async_handle(SessionEvent::kMatchFound));
+  EXPECT_CALL(*sessions_[1], async_handle(SessionEvent::kMatchFound));
+
+  matchmaker_.enqueue(a);
+  matchmaker_.enqueue(b);
+
+  EXPECT_EQ(a->state(), State::kMatched);
+  EXPECT_FALSE(a->cancel());
+}
+
+TEST_F(MatchmakerShould, TrackQueueDepthAndWaits) {
+  auto& metrics     = Metrics::instance();
+  const auto depth  = metrics.matchmaking_queue_depth.value();
+  const auto made   = metrics.matches_made.value();
+  const auto waited = metrics.matchmaking_wait_seconds.bucket(0);
+
+  matchmaker_.enqueue(ticket());
+  EXPECT_EQ(metrics.matchmaking_queue_depth.value(), depth + 1);
+  matchmaker_.enqueue(ticket());
+
+  EXPECT_EQ(metrics.matchmaking_queue_depth.value(), depth);
+  EXPECT_EQ(metrics.matches_made.value(), made + 1);
+  EXPECT_EQ(metrics.matchmaking_wait_seconds.bucket(0), waited + 2);
+}
+
+TEST_F(MatchmakerShould, PairConcurrentEnqueues) {
+  constexpr int kThreads = 8;
+  constexpr int kTickets = 500;
+
+  vector<vector<shared_ptr<MatchTicket>>> tickets(kThreads);
+  for (auto& batch : tickets) {
+    for (int i = 0; i < kTickets; ++i) {
+      batch.push_back(ticket());
+    }
+  }
+
+  vector<std::thread> threads;
+  for (auto& batch : tickets) {
+    threads.emplace_back([&] {
+      for (auto& t : batch) {
+        matchmaker_.enqueue(t);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(matches_.size(), kThreads * kTickets / 2);
+  for (const auto& batch : tickets) {
+    for (const auto& t : batch) {
+      EXPECT_EQ(t->state(), State::kMatched);
+    }
+  }
+}
+
+}  // namespace io_blair::testing
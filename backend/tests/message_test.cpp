@@ -0,0 +1,92 @@
+#include "message.hpp"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+
+
+namespace io_blair::testing {
+using std::string;
+using std::string_view;
+
+TEST(MessageShould, BeEmptyByDefault) {
+  const Message msg;
+
+  EXPECT_TRUE(msg.empty());
+  EXPECT_EQ(msg.view(), "");
+}
+
+TEST(MessageShould, CopyPayload) {
+  string payload = "arbitrary";
+  const Message msg(payload);
+  payload[0] = 'X';
+
+  EXPECT_EQ(msg, "arbitrary");
+  EXPECT_EQ(msg.size(), 9);
+}
+
+TEST(MessageShould, ShareBufferBetweenCopies) {
+  const Message msg("arbitrary");
+  const Message copy = msg;  // NOLINT(performance-unnecessary-copy-initialization)
+
+  EXPECT_EQ(copy.data(), msg.data());
+  EXPECT_EQ(copy, msg);
+}
+
+TEST(MessageShould, LeaveMovedFromEmpty) {
+  Message msg("arbitrary");
+  const char* data = msg.data();
+  const Message moved(std::move(msg));
+
+  EXPECT_EQ(moved.data(), data);
+  EXPECT_TRUE(msg.empty());  // NOLINT(bugprone-use-after-move)
+}
+
+TEST(MessageShould, BuildInPlace) {
+  const Message msg = Message::build(16, [](char* out) {
+    const string_view payload = "built";
+    payload.copy(out, payload.size());
+    return payload.size();
+  });
+
+  EXPECT_EQ(msg, "built");
+}
+
+TEST(MessageShould, HoldLargePayloads) {
+  const string payload(100'000, 'a');
+  const Message msg(payload);
+
+  EXPECT_EQ(msg, payload);
+}
+
+TEST(MessageShould, ReuseReleasedBuffers) {
+  const char* data = nullptr;
+  {
+    const Message msg("arbitrary");
+    data = msg.data();
+  }
+  const Message msg("another");
+
+  EXPECT_EQ(msg.data(), data);
+}
+
+TEST(MessageShould, OutliveThreadThatCreatedIt) {
+  Message msg;
+  std::thread([&msg] { msg = Message("arbitrary"); }).join();
+
+  EXPECT_EQ(msg, "arbitrary");
+}
+
+TEST(MessageShould, KeepStaticMessagesAlive) {
+  const Message msg = Message::make_static("arbitrary");
+  {
+    const Message copy = msg;  // NOLINT(performance-unnecessary-copy-initialization)
+  }
+
+  EXPECT_EQ(msg, "arbitrary");
+}
+
+}  // namespace io_blair::testing
@@ -0,0 +1,68 @@
+#include "metrics.hpp"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <string>
+
+
+namespace io_blair::testing {
+using std::string;
+using ::testing::HasSubstr;
+
+TEST(CounterShould, Increment) {
+  Counter counter;
+
+  counter.inc();
+  counter.inc(2);
+
+  EXPECT_EQ(counter.value(), 3);
+}
+
+TEST(GaugeShould, IncrementAndDecrement) {
+  Gauge gauge;
+
+  gauge.inc(5);
+  gauge.dec(2);
+  EXPECT_EQ(gauge.value(), 3);
+
+  gauge.set(-1);
+  EXPECT_EQ(gauge.value(), -1);
+}
+
+TEST(HistogramShould, CountIntoBuckets) {
+  Histogram<2> histogram({1, 10});
+
+  histogram.observe(0.5);
+  histogram.observe(1);
+  histogram.observe(5);
+  histogram.observe(100);
+
+  EXPECT_EQ(histogram.bucket(0), 2);
+  EXPECT_EQ(histogram.bucket(1), 1);
+  EXPECT_EQ(histogram.bucket(2), 1);
+  EXPECT_DOUBLE_EQ(histogram.sum(), 106.5);
+}
+
+TEST(MetricsShould, RenderPrometheusText) {
+  const string text = Metrics::instance().render();
+
+  EXPECT_THAT(text, HasSubstr("# TYPE io_blair_sessions_active gauge\n"));
+  EXPECT_THAT(text, HasSubstr("# TYPE io_blair_messages_received_total counter\n"));
+  EXPECT_THAT(text, HasSubstr("io_blair_matchmaking_wait_seconds_bucket{le=\"+Inf\"} "));
+}
+
+TEST(MetricsShould, OnlyUpdateSnapshotOnRefresh) {
+  auto& metrics = Metrics::instance();
+  metrics.refresh();
+  const auto before = metrics.snapshot();
+
+  metrics.http_requests.inc();
+  EXPECT_EQ(metrics.snapshot(), before);
+
+  metrics.refresh();
+  EXPECT_NE(metrics.snapshot(), before);
+  EXPECT_EQ(*metrics.snapshot(), metrics.render());
+}
+
+}  // namespace io_blair::testing
@@ -2,14 +2,13 @@
 
 #include <gmock/gmock.h>
 
-#include <memory>
-
+#include "handler.hpp"
 #include "igame.hpp"
 
 
 namespace io_blair::testing {
 class MockGame : public IGame {
  public:
-  MOCK_METHOD(void, transition_to, (std::unique_ptr<IGameHandler>), (override));
+  MOCK_METHOD(void, transition_to, (GameState), (override));
 };
 }  // namespace io_blair::testing
@@ -23,6 +23,11 @@ class MockHandler : public IHandler {
     return EvLobbyJoin(ev);
   }
 
+  MOCK_METHOD(void, EvLobbyResume, (const json::in::LobbyResume&));
+  inline void operator()(const json::in::LobbyResume& ev) override {
+    return EvLobbyResume(ev);
+  }
+
   MOCK_METHOD(void, EvLobbyLeave, (const json::in::LobbyLeave&));
   inline void operator()(const json::in::LobbyLeave& ev) override {
     return EvLobbyLeave(ev);
@@ -52,6 +57,21 @@ class MockHandler : public IHandler {
   inline void operator()(const json::in::NewGame& ev) override {
     return EvNewGame(ev);
   }
+
+  MOCK_METHOD(void, EvMatchmake, (const json::in::Matchmake&));
+  inline void operator()(const json::in::Matchmake& ev) override {
+    return EvMatchmake(ev);
+  }
+
+  MOCK_METHOD(void, EvMatchmakeCancel, (const json::in::MatchmakeCancel&));
+  inline void operator()(const json::in::MatchmakeCancel& ev) override {
+    return EvMatchmakeCancel(ev);
+  }
+
+  MOCK_METHOD(void, EvSpectate, (const json::in::Spectate&));
+  inline void operator()(const json::in::Spectate& ev) override {
+    return EvSpectate(ev);
+  }
 };
 
 }  // namespace io_blair::testing
@@ -6,6 +6,7 @@
 
 #include "ilobby_manager.hpp"
 #include "lobby_context.hpp"
+#include "matchmaker.hpp"
 
 
 namespace io_blair::testing {
@@ -16,5 +17,15 @@ class MockLobbyManager : public ILobbyManager {
               (std::weak_ptr<ISession> session, std::string_view code), (override));
   MOCK_METHOD(void, leave, (const std::weak_ptr<ISession>& session, std::string_view code),
               (override));
+  MOCK_METHOD(void, suspend, (const std::weak_ptr<ISession>& session, std::string_view code),
+              (override));
+  MOCK_METHOD(std::optional<LobbyContext>, resume,
+              (std::weak_ptr<ISession> session, std::string_view token), (override));
+  MOCK_METHOD(bool, spectate, (std::weak_ptr<ISession> session, std::string_view code),
+              (override));
+  MOCK_METHOD(void, unspectate, (const std::weak_ptr<ISession>& session, std::string_view code),
+              (override));
+  MOCK_METHOD(std::shared_ptr<MatchTicket>, matchmake,
+              (std::weak_ptr<ISession> session, Character preference), (override));
 };
 }  // namespace io_blair::testing
@@ -2,18 +2,15 @@
 
 #include <gmock/gmock.h>
 
-#include <memory>
-#include <string>
-
 #include "event.hpp"
 #include "isession.hpp"
+#include "message.hpp"
 
 
 namespace io_blair::testing {
 class MockSession : public ISession {
  public:
-  MOCK_METHOD(void, async_send, (std::shared_ptr<const std::string> msg), (override));
-  MOCK_METHOD(void, async_send, (std::string msg), (override));
+  MOCK_METHOD(void, async_send, (Message msg), (override));
   MOCK_METHOD(void, async_handle, (SessionEvent ev), (override));
 };
 
@@ -0,0 +1,49 @@
+#include "pool_allocator.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <vector>
+
+
+namespace io_blair::testing {
+
+TEST(BlockPoolShould, ReuseFreedBlocks) {
+  void* block = block_pool::allocate(1000);
+  block_pool::deallocate(block, 1000);
+
+  void* reused = block_pool::allocate(1000);
+  EXPECT_EQ(reused, block);
+  block_pool::deallocate(reused, 1000);
+}
+
+TEST(BlockPoolShould, ReuseBlocksWithinSizeClass) {
+  void* block = block_pool::allocate(1000);
+  block_pool::deallocate(block, 1000);
+
+  // 1000 and 1024 bytes share a class.
+  void* reused = block_pool::allocate(1024);
+  EXPECT_EQ(reused, block);
+  block_pool::deallocate(reused, 1024);
+}
+
+TEST(BlockPoolShould, NotMixSizeClasses) {
+  void* small = block_pool::allocate(64);
+  block_pool::deallocate(small, 64);
+
+  void* large = block_pool::allocate(4096);
+  EXPECT_NE(large, small);
+  block_pool::deallocate(large, 4096);
+}
+
+TEST(PoolAllocatorShould, BackContainers) {
+  std::vector<int, PoolAllocator<int>> vec;
+  for (int i = 0; i < 1000; ++i) {
+    vec.push_back(i);
+  }
+
+  EXPECT_EQ(vec.size(), 1000);
+  EXPECT_EQ(vec.back(), 999);
+}
+
+}  // namespace io_blair::testing
@@ -9,6 +9,7 @@
 #include "handler.hpp"
 #include "json.hpp"
 #include "lobby_context.hpp"
+#include "matchmaker.hpp"
 #include "mock/mock_game.hpp"
 #include "mock/mock_lobby_manager.hpp"
 #include "mock/mock_session.hpp"
@@ -23,6 +24,8 @@ using std::shared_ptr;
 using std::string;
 using ::testing::Return;
 using ::testing::StrictMock;
+using ::testing::VariantWith;
+using ::testing::_;
 namespace jin  = json::in;
 namespace jout = json::out;
 
@@ -43,7 +46,7 @@ TEST_F(PrelobbyShould, CreateLobby) {
   Prelobby prelobby;
 
   EXPECT_CALL(manager_, create).WillOnce(Return(std::move(lob_ctx_)));
-  EXPECT_CALL(game_, transition_to);
+  EXPECT_CALL(game_, transition_to(VariantWith<Lobby>(_)));
 
   prelobby(game_, sess_ctx_, jin::LobbyCreate{});
 }
@@ -52,7 +55,7 @@ TEST_F(PrelobbyShould, TransitionOnLobbyCtx) {
   Prelobby prelobby;
 
   EXPECT_CALL(manager_, join).WillOnce(Return(std::move(lob_ctx_)));
-  EXPECT_CALL(game_, transition_to);
+  EXPECT_CALL(game_, transition_to(VariantWith<Lobby>(_)));
 
   prelobby(game_, sess_ctx_, jin::LobbyJoin{code_});
 }
@@ -65,4 +68,82 @@ TEST_F(PrelobbyShould, NotTransitionOnNulloptLobbyCtx) {
   prelobby(game_, sess_ctx_, jin::LobbyJoin{code_});
 }
 
+TEST_F(PrelobbyShould, TransitionOnResumedLobbyCtx) {
+  Prelobby prelobby;
+
+  EXPECT_CALL(manager_, resume).WillOnce(Return(std::move(lob_ctx_)));
+  EXPECT_CALL(game_, transition_to(VariantWith<Lobby>(_)));
+
+  prelobby(game_, sess_ctx_, jin::LobbyResume{"token"});
+}
+
+TEST_F(PrelobbyShould, NotTransitionOnFailedResume) {
+  Prelobby prelobby;
+
+  EXPECT_CALL(manager_, resume).WillOnce(Return(nullopt));
+
+  prelobby(game_, sess_ctx_, jin::LobbyResume{"token"});
+}
+
+TEST_F(PrelobbyShould, MatchmakeOnce) {
+  Prelobby prelobby;
+
+  EXPECT_CALL(manager_, matchmake(_, Character::Io))
+      .WillOnce(Return(make_shared<MatchTicket>(sess_, Character::Io)));
+
+  prelobby(game_, sess_ctx_, jin::Matchmake{Character::Io});
+  prelobby(game_, sess_ctx_, jin::Matchmake{Character::Io});
+}
+
+TEST_F(PrelobbyShould, MatchmakeAgainAfterCancelling) {
+  Prelobby prelobby;
+
+  EXPECT_CALL(manager_, matchmake(_, Character::unknown))
+      .Times(2)
+      .WillRepeatedly(
+          [this](auto, auto) { return make_shared<MatchTicket>(sess_, Character::unknown); });
+
+  prelobby(game_, sess_ctx_, jin::Matchmake{});
+  prelobby(game_, sess_ctx_, jin::MatchmakeCancel{});
+  prelobby(game_, sess_ctx_, jin::Matchmake{});
+}
+
+TEST_F(PrelobbyShould, CancelMatchmakingOnCreate) {
+  Prelobby prelobby;
+  auto ticket = make_shared<MatchTicket>(sess_, Character::unknown);
+
+  EXPECT_CALL(manager_, matchmake).WillOnce(Return(ticket));
+  EXPECT_CALL(manager_, create).WillOnce(Return(std::move(lob_ctx_)));
+  EXPECT_CALL(game_, transition_to(VariantWith<Lobby>(_)));
+
+  prelobby(game_, sess_ctx_, jin::Matchmake{});
+  prelobby(game_, sess_ctx_, jin::LobbyCreate{});
+
+  EXPECT_EQ(ticket->state(), MatchTicket::State::kCancelled);
+}
+
+TEST_F(PrelobbyShould, TransitionOnMatchFound) {
+  Prelobby prelobby;
+  auto ticket = make_shared<MatchTicket>(sess_, Character::unknown);
+  ticket->match.emplace(std::move(lob_ctx_));
+
+  EXPECT_CALL(manager_, matchmake).WillOnce(Return(ticket));
+  EXPECT_CALL(game_, transition_to(VariantWith<Lobby>(_)));
+
+  prelobby(game_, sess_ctx_, jin::Matchmake{});
+  prelobby(game_, sess_ctx_, SessionEvent::kMatchFound);
+}
+
+TEST_F(PrelobbyShould, CancelMatchmakingOnClose) {
+  Prelobby prelobby;
+  auto ticket = make_shared<MatchTicket>(sess_, Character::unknown);
+
+  EXPECT_CALL(manager_, matchmake).WillOnce(Return(ticket));
+
+  prelobby(game_, sess_ctx_, jin::Matchmake{});
+  prelobby(game_, sess_ctx_, SessionEvent::kCloseSession);
+
+  EXPECT_EQ(ticket->state(), MatchTicket::State::kCancelled);
+}
+
 }  // namespace io_blair::testing
@@ -0,0 +1,265 @@
+#include "replay.hpp"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <bitset>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "character.hpp"
+#include "lobby_controller.hpp"
+#include "lobby_snapshot.hpp"
+#include "maze.hpp"
+#include "metrics.hpp"
+#include "mock/mock_session.hpp"
+#include "replay_writer.hpp"
+
+
+namespace io_blair::testing {
+using std::make_shared;
+using std::vector;
+using ::testing::NiceMock;
+using replay::EventKind;
+using Maze = LobbyController::Maze;
+namespace fs = std::filesystem;
+
+namespace {
+// A maze whose start at (0, 0) opens right onto its end at (1, 0), which holds a coin.
+Maze small_maze() {
+  Maze::matrix<Cell> cells;
+  cells[0][0].set(direction::Both::kRight, true);
+  cells[0][1].set(direction::Both::kLeft, true);
+  cells[0][1].set_coin(true);
+  return Maze({0, 0}, {1, 0}, cells);
+}
+
+// Records a game in small_maze with the events passed to record.
+template <typename Record>
+vector<uint8_t> record_game(Record&& record) {
+  replay::GameRecorder recorder;
+  recorder.begin(small_maze(), Character::Io, Character::Blair);
+  record(recorder);
+  return recorder.finish();
+}
+
+replay::Game decode(const vector<uint8_t>& log) {
+  replay::Game game;
+  replay::Reader reader(log);
+  EXPECT_TRUE(reader.next(game));
+  return game;
+}
+
+replay::Verdict verify(const vector<uint8_t>& log) {
+  return replay::verify<Maze::rows(), Maze::cols()>(decode(log));
+}
+
+// Both seats reach the end and the first takes the coin on the way.
+void play_to_finish(replay::GameRecorder& recorder) {
+  recorder.record(EventKind::kMove, 0, {1, 0});
+  recorder.record(EventKind::kCoin, 0, {1, 0});
+  recorder.record(EventKind::kReset, 1, {0, 1});
+  recorder.record(EventKind::kMove, 1, {1, 0});
+  recorder.record(EventKind::kFinish, 0, {1, 0});
+}
+
+// Reads back everything written to path.
+vector<uint8_t> read_log(const fs::path& path) {
+  std::ifstream file(path, std::ios::binary);
+  return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+}
+
+// Appends the moves that walk from at to every cell reachable from it and back.
+void tour(const Maze& maze, coordinate at, Maze::matrix<bool>& seen, vector<coordinate>& path) {
+  seen[at.second][at.first] = true;
+  for (const direction::General dir : {direction::kUp, direction::kRight, direction::kDown,
+                                       direction::kLeft}) {
+    const coordinate next = direction::translate(at, dir);
+    if (maze.traversable(at, next) && !seen[next.second][next.first]) {
+      path.push_back(next);
+      tour(maze, next, seen, path);
+      path.push_back(at);
+    }
+  }
+}
+
+// The moves that visit every cell of controller's maze from its start.
+vector<coordinate> tour(const LobbyController& controller) {
+  LobbyImage image{};
+  EXPECT_TRUE(controller.save(image));
+  Maze::matrix<Cell> cells;
+  for (int row = 0; row < Maze::rows(); ++row) {
+    for (int col = 0; col < Maze::cols(); ++col) {
+      cells[row][col] = Cell(std::bitset<9>(image.cells[row * Maze::cols() + col]));
+    }
+  }
+  const coordinate start(image.seats[0].x, image.seats[0].y);
+  Maze::matrix<bool> seen{};
+  vector<coordinate> path;
+  tour(Maze(start, start, cells), start, seen, path);
+  return path;
+}
+}  // namespace
+
+TEST(ReplayShould, RoundTripGame) {
+  const vector<uint8_t> log = record_game(play_to_finish);
+
+  replay::Game game;
+  replay::Reader reader(log);
+  ASSERT_TRUE(reader.next(game));
+
+  EXPECT_EQ(game.rows, Maze::rows());
+  EXPECT_EQ(game.cols, Maze::cols());
+  EXPECT_EQ(game.characters[0], Character::Io);
+  EXPECT_EQ(game.characters[1], Character::Blair);
+  EXPECT_EQ(game.start, coordinate(0, 0));
+  EXPECT_EQ(game.end, coordinate(1, 0));
+  EXPECT_EQ(game.cells[1], small_maze().at(0, 1).bits());
+  ASSERT_EQ(game.events.size(), 5);
+  EXPECT_EQ(game.events[2].kind, EventKind::kReset);
+  EXPECT_EQ(game.events[2].seat, 1);
+  EXPECT_EQ(game.events[2].coord, coordinate(0, 1));
+
+  EXPECT_FALSE(reader.next(game));
+  EXPECT_TRUE(reader.error().empty());
+}
+
+TEST(ReplayShould, VerifyLegalGame) {
+  EXPECT_TRUE(verify(record_game(play_to_finish)).ok);
+}
+
+TEST(ReplayShould, RejectMoveThroughWall) {
+  const auto verdict = verify(record_game([](replay::GameRecorder& recorder) {
+    recorder.record(EventKind::kMove, 1, {0, 1});
+  }));
+
+  EXPECT_FALSE(verdict.ok);
+  EXPECT_EQ(verdict.event, 0);
+}
+
+TEST(ReplayShould, RejectCoinLeftBehind) {
+  const auto verdict = verify(record_game([](replay::GameRecorder& recorder) {
+    recorder.record(EventKind::kMove, 0, {1, 0});
+    recorder.record(EventKind::kMove, 0, {0, 0});
+  }));
+
+  EXPECT_FALSE(verdict.ok);
+  EXPECT_EQ(verdict.event, 0);
+}
+
+TEST(ReplayShould, RejectUnrecordedFinish) {
+  const auto verdict = verify(record_game([](replay::GameRecorder& recorder) {
+    recorder.record(EventKind::kMove, 0, {1, 0});
+    recorder.record(EventKind::kCoin, 0, {1, 0});
+    recorder.record(EventKind::kMove, 1, {1, 0});
+  }));
+
+  EXPECT_FALSE(verdict.ok);
+  EXPECT_EQ(verdict.event, 2);
+}
+
+TEST(ReplayShould, ReportTruncatedLog) {
+  vector<uint8_t> log = record_game(play_to_finish);
+  log.pop_back();
+
+  replay::Game game;
+  replay::Reader reader(log);
+
+  EXPECT_FALSE(reader.next(game));
+  EXPECT_FALSE(reader.error().empty());
+}
+
+TEST(ReplayWriterShould, WriteLobbyGamesToLog) {
+  const fs::path path = fs::temp_directory_path() / "io_blair_replay_test.bin";
+  fs::remove(path);
+  auto& writer        = replay::Writer::instance();
+  const auto& written = Metrics::instance().replay_games_written;
+  const auto before   = written.value();
+
+  ASSERT_TRUE(writer.start(path.string()));
+  {
+    LobbyController controller("CODE42");
+    auto s1  = make_shared<NiceMock<MockSession>>();
+    auto s2  = make_shared<NiceMock<MockSession>>();
+    auto ctx = controller.join(s1);
+    controller.join(s2)->controller->set_character(Character::Blair);
+    ctx->controller->set_character(Character::Io);
+    ctx->controller->move_character({1, 3});
+    controller.close();
+  }
+  writer.stop();
+
+  const replay::Game game = decode(read_log(path));
+  EXPECT_EQ(game.characters[0], Character::Io);
+  EXPECT_EQ(game.characters[1], Character::Blair);
+  ASSERT_FALSE(game.events.empty());
+  EXPECT_EQ(game.events[0].coord, coordinate(1, 3));
+  EXPECT_TRUE((replay::verify<Maze::rows(), Maze::cols()>(game).ok));
+  EXPECT_EQ(written.value(), before + 1);
+
+  fs::remove(path);
+}
+
+TEST(ReplayWriterShould, RecordFinishWhenPlayerLeavesBeforeCheckWin) {
+  const fs::path path = fs::temp_directory_path() / "io_blair_replay_finish_test.bin";
+  fs::remove(path);
+  auto& writer = replay::Writer::instance();
+
+  ASSERT_TRUE(writer.start(path.string()));
+  {
+    LobbyController controller("CODE42");
+    auto s1   = make_shared<NiceMock<MockSession>>();
+    auto s2   = make_shared<NiceMock<MockSession>>();
+    auto ctx1 = controller.join(s1);
+    auto ctx2 = controller.join(s2);
+    ctx2->controller->set_character(Character::Blair);
+    ctx1->controller->set_character(Character::Io);
+
+    // The first player takes every coin, then both walk the maze together
+    // until they meet at its end. Neither sends checkWin.
+    const vector<coordinate> path = tour(controller);
+    for (const coordinate& step : path) {
+      ctx1->controller->move_character(step);
+    }
+    for (const coordinate& step : path) {
+      ctx1->controller->move_character(step);
+      ctx2->controller->move_character(step);
+    }
+    controller.leave(s2);
+  }
+  writer.stop();
+
+  const replay::Game game = decode(read_log(path));
+  ASSERT_FALSE(game.events.empty());
+  EXPECT_EQ(game.events.back().kind, EventKind::kFinish);
+  EXPECT_TRUE((replay::verify<Maze::rows(), Maze::cols()>(game).ok));
+
+  fs::remove(path);
+}
+
+#if defined(__linux__)
+TEST(ReplayWriterShould, StopRecordingWhenWriteFails) {
+  auto& writer        = replay::Writer::instance();
+  const auto& written = Metrics::instance().replay_games_written;
+  const auto before   = written.value();
+
+  // Every write to /dev/full fails with ENOSPC.
+  ASSERT_TRUE(writer.start("/dev/full"));
+  writer.submit(record_game(play_to_finish));
+  for (int i = 0; i < 50 && writer.recording(); ++i) {
+    std::this_thread::sleep_for(replay::Writer::kFlushInterval / 5);
+  }
+
+  EXPECT_FALSE(writer.recording());
+  writer.stop();
+  EXPECT_EQ(written.value(), before);
+}
+#endif
+
+}  // namespace io_blair::testing
@@ -0,0 +1,277 @@
+#include "session.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <boost/asio.hpp>
+#include <boost/beast.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "http_session.hpp"
+#include "ihandler.hpp"
+#include "json.hpp"
+#include "lobby_manager.hpp"
+#include "metrics.hpp"
+#include "session_options.hpp"
+
+namespace {
+// Counts heap allocations made by threads that opted in, so tests can
+// tell the server's allocations apart from the client's.
+thread_local bool count_allocations = false;
+std::atomic<std::size_t> allocations{0};
+}  // namespace
+
+void* operator new(std::size_t size) {
+  if (count_allocations) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+  }
+  if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+  std::free(ptr);
+}
+
+namespace io_blair::testing {
+using std::make_shared;
+using std::string_view;
+
+// Matches the keepalive fast path, which answers without decoding.
+constexpr string_view kPing = R"({"type":"ping"})";
+// A ping that has to go through the decoder.
+constexpr string_view kDecodedPing = R"({"type":"ping","seq":1})";
+
+class SessionShould : public ::testing::Test {
+ protected:
+  explicit SessionShould(SessionOptions options = {}) {
+    acceptor_.async_accept([this, options](error_code ec, tcp::socket socket) {
+      if (!ec) {
+        make_shared<HttpSession>(ctx_, std::move(socket), manager_, options)->run();
+      }
+    });
+    net::post(ctx_, [] { count_allocations = true; });
+    thread_ = std::thread([this] { ctx_.run(); });
+
+    client_.next_layer().connect(acceptor_.local_endpoint());
+    client_.handshake("localhost", "/");
+  }
+
+  ~SessionShould() override {
+    ctx_.stop();
+    thread_.join();
+  }
+
+  // Sends a ping and waits for the pong.
+  void ping(string_view payload = kPing) {
+    client_.write(net::buffer(payload));
+    client_.read(buffer_);
+    buffer_.consume(buffer_.size());
+  }
+
+  // Pings the session many times and checks the server thread allocated
+  // expected_per_ping for each once warmed up.
+  void expect_steady_state_allocations(string_view payload, std::size_t expected_per_ping) {
+    constexpr std::size_t kWarmup = 100;
+    constexpr std::size_t kPings  = 1000;
+
+    for (std::size_t i = 0; i < kWarmup; ++i) {
+      ping(payload);
+    }
+    allocations.store(0);
+    for (std::size_t i = 0; i < kPings; ++i) {
+      ping(payload);
+    }
+
+    EXPECT_EQ(allocations.load(), kPings * expected_per_ping);
+  }
+
+  net::io_context ctx_;
+  tcp::acceptor acceptor_{
+      ctx_, {net::ip::make_address("127.0.0.1"), 0}
+  };
+  LobbyManager manager_;
+  std::thread thread_;
+
+  net::io_context client_ctx_;
+  websocket::stream<tcp::socket> client_{client_ctx_};
+  beast::flat_buffer buffer_;
+};
+
+class IdleSessionShould : public SessionShould {
+ protected:
+  IdleSessionShould()
+      : SessionShould({.idle_timeout = std::chrono::seconds(1), .keep_alive_pings = false}) {}
+};
+
+class SingleStrandSessionShould : public SessionShould {
+ protected:
+  SingleStrandSessionShould()
+      : SessionShould({.single_strand = true}) {}
+};
+
+// Dispatches nowhere so only decoding is measured.
+class NullHandler : public IHandler {};
+
+// Decoding is the parser's business. Everything else a message goes through,
+// reading, posting to the strands and writing the reply, should reuse memory.
+std::size_t allocations_per_decode(string_view payload) {
+  NullHandler handler;
+  allocations.store(0);
+  count_allocations = true;
+  json::decode(payload, handler);
+  count_allocations = false;
+  return allocations.load();
+}
+
+TEST_F(SessionShould, NotAllocateBeyondDecodingInSteadyState) {
+  expect_steady_state_allocations(kDecodedPing, allocations_per_decode(kDecodedPing));
+}
+
+TEST_F(SingleStrandSessionShould, NotAllocateBeyondDecodingInSteadyState) {
+  expect_steady_state_allocations(kDecodedPing, allocations_per_decode(kDecodedPing));
+}
+
+TEST_F(SessionShould, NotAllocateForKeepalivePings) {
+  expect_steady_state_allocations(kPing, 0);
+}
+
+TEST_F(SessionShould, ReplyToPingsWithoutDecoding) {
+  const auto fast = Metrics::instance().pings_fast_path.value();
+  ping();
+
+  EXPECT_EQ(Metrics::instance().pings_fast_path.value(), fast + 1);
+}
+
+TEST_F(SingleStrandSessionShould, ReplyToPings) {
+  client_.write(net::buffer(kPing));
+  client_.read(buffer_);
+
+  EXPECT_EQ(beast::buffers_to_string(buffer_.data()), json::out::pong_msg().view());
+}
+
+TEST_F(SessionShould, AnswerWebsocketPings) {
+  bool ponged = false;
+  client_.control_callback([&](websocket::frame_type kind, beast::string_view) {
+    ponged = ponged || kind == websocket::frame_type::pong;
+  });
+  client_.ping({});
+  // Control frames are handled while reading, so read the reply to a ping.
+  ping();
+
+  EXPECT_TRUE(ponged);
+}
+
+TEST_F(SessionShould, CloseWhenMessageOverSizeLimit) {
+  const auto oversized = Metrics::instance().messages_oversized.value();
+
+  client_.write(net::buffer(std::string(json::in::kMaxMessageSize + 1, 'x')));
+  beast::error_code ec;
+  client_.read(buffer_, ec);
+
+  EXPECT_EQ(ec, websocket::error::closed);
+  EXPECT_EQ(client_.reason().code, websocket::close_code::too_big);
+  // The close frame can reach the client before the server's read completes.
+  for (int i = 0; i < 100 && Metrics::instance().messages_oversized.value() == oversized; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_EQ(Metrics::instance().messages_oversized.value(), oversized + 1);
+}
+
+TEST_F(SessionShould, GoAwayWhenClosingAll) {
+  // Makes sure the handshake finished, so the session is counted as open.
+  ping();
+
+  Session::close_all();
+  beast::error_code ec;
+  client_.read(buffer_, ec);
+
+  EXPECT_EQ(ec, websocket::error::closed);
+  EXPECT_EQ(client_.reason().code, websocket::close_code::going_away);
+}
+
+TEST_F(IdleSessionShould, CloseWhenNothingArrives) {
+  const Counter& closed = Metrics::instance().closed(CloseReason::kIdleTimeout);
+  const auto timed_out  = closed.value();
+
+  beast::error_code ec;
+  client_.read(buffer_, ec);
+  EXPECT_TRUE(ec);
+
+  // The client can see the connection close before the server's read completes.
+  for (int i = 0; i < 100 && closed.value() == timed_out; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_EQ(closed.value(), timed_out + 1);
+}
+
+TEST(StalledSessionShould, CloseWhenOnlyWriteStalls) {
+  const Counter& closed = Metrics::instance().closed(CloseReason::kWriteStall);
+  const auto stalled    = closed.value();
+
+  net::io_context ctx;
+  tcp::acceptor acceptor(ctx, {net::ip::make_address("127.0.0.1"), 0});
+  LobbyManager manager;
+  std::shared_ptr<Session> session;
+  SessionOptions options;
+  options.write_stall_timeout = std::chrono::seconds(1);
+
+  // Makes the Session directly, so it can be handed a message the client never reads.
+  std::optional<beast::tcp_stream> stream;
+  beast::flat_buffer received;
+  http::request<http::empty_body> req;
+  acceptor.async_accept([&](error_code ec, tcp::socket socket) {
+    ASSERT_FALSE(ec);
+    stream.emplace(std::move(socket));
+    http::async_read(*stream, received, req, [&](error_code ec, std::size_t) {
+      ASSERT_FALSE(ec);
+      session = Session::make(ctx, std::move(*stream), manager, options);
+      session->run(std::move(req), std::move(received));
+    });
+  });
+  std::thread thread([&ctx] { ctx.run(); });
+
+  net::io_context client_ctx;
+  websocket::stream<tcp::socket> client(client_ctx);
+  client.next_layer().open(tcp::v4());
+  client.next_layer().set_option(net::socket_base::receive_buffer_size(4096));
+  client.next_layer().connect(acceptor.local_endpoint());
+  client.handshake("localhost", "/");
+
+  // Far more than the socket buffers hold, and nothing queued behind it.
+  net::post(ctx, [&] { session->async_send(Message(std::string(16 << 20, 'x'))); });
+
+  for (int i = 0; i < 500 && closed.value() == stalled; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_EQ(closed.value(), stalled + 1);
+
+  ctx.stop();
+  thread.join();
+}
+
+TEST(SessionPoolShould, ReuseMemoryOfClosedSessions) {
+  net::io_context ctx;
+  LobbyManager manager;
+
+  const void* first  = Session::make(ctx, beast::tcp_stream(ctx), manager).get();
+  const void* second = Session::make(ctx, beast::tcp_stream(ctx), manager).get();
+
+  EXPECT_EQ(second, first);
+}
+
+}  // namespace io_blair::testing
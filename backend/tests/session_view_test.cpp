@@ -3,34 +3,26 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <atomic>
 #include <memory>
+#include <thread>
+#include <vector>
 
 #include "mock/mock_session.hpp"
 
 namespace io_blair::testing {
 using std::make_shared;
-using std::string;
 using std::weak_ptr;
 using ::testing::StrictMock;
 
-TEST(SessionViewShould, ForwardSendStrToRealSession) {
+TEST(SessionViewShould, ForwardSendToRealSession) {
   auto sess = make_shared<MockSession>();
-  const string str = "arbitrary";
+  const Message msg("arbitrary");
 
-  EXPECT_CALL(*sess, async_send(str));
+  EXPECT_CALL(*sess, async_send(msg));
 
   SessionView view(sess);
-  view.async_send(str);
-}
-
-TEST(SessionViewShould, ForwardSendSharedStrToRealSession) {
-  auto sess = make_shared<MockSession>();
-  const auto str = make_shared<const string>("arbitrary");
-
-  EXPECT_CALL(*sess, async_send(str));
-
-  SessionView view(sess);
-  view.async_send(str);
+  view.async_send(msg);
 }
 
 TEST(SessionViewShould, NotForwardSendWhenReset) {
@@ -38,8 +30,7 @@ TEST(SessionViewShould, NotForwardSendWhenReset) {
   SessionView view(sess);
   view.reset();
 
-  view.async_send("");
-  view.async_send(make_shared<const string>());
+  view.async_send(Message());
 }
 
 TEST(SessionViewShould, SetWhenExpired) {
@@ -55,6 +46,31 @@ TEST(SessionViewShould, NotSetWhenNotExpired) {
   EXPECT_FALSE(view.try_set(weak_ptr<MockSession>{}));
 }
 
+TEST(SessionViewShould, SetOnceWhenRacing) {
+  constexpr int kThreads = 8;
+  SessionView view;
+  std::vector<std::shared_ptr<MockSession>> sessions;
+  for (int i = 0; i < kThreads; ++i) {
+    sessions.push_back(make_shared<MockSession>());
+  }
+
+  std::atomic<int> successes{0};
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kThreads; ++i) {
+    threads.emplace_back([&, i] {
+      if (view.try_set(sessions[i])) {
+        successes.fetch_add(1);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(successes.load(), 1);
+  EXPECT_FALSE(view.expired());
+}
+
 TEST(SessionViewEqualityShould, BeFalseWhenExpired) {
   SessionView view;
   auto ptr = make_shared<MockSession>();
@@ -0,0 +1,78 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+
+#include "handler.hpp"
+#include "json.hpp"
+#include "mock/mock_game.hpp"
+#include "mock/mock_lobby_manager.hpp"
+#include "mock/mock_session.hpp"
+#include "session_context.hpp"
+
+
+namespace io_blair::testing {
+using ::std::make_shared;
+using ::std::shared_ptr;
+using ::std::string;
+using ::testing::Return;
+using ::testing::StrictMock;
+using ::testing::VariantWith;
+using ::testing::_;
+namespace jin = json::in;
+
+class SpectatingShould : public ::testing::Test {
+ protected:
+  StrictMock<MockGame> game_;
+
+  shared_ptr<StrictMock<MockSession>> sess_ = make_shared<StrictMock<MockSession>>();
+  MockLobbyManager manager_;
+  SessionContext sess_ctx_{sess_, manager_};
+
+  const string code_ = "arbitrary";
+};
+
+TEST_F(SpectatingShould, StartFromPrelobby) {
+  Prelobby prelobby;
+
+  EXPECT_CALL(manager_, spectate(_, code_)).WillOnce(Return(true));
+  EXPECT_CALL(game_, transition_to(VariantWith<Spectating>(_)));
+
+  prelobby(game_, sess_ctx_, jin::Spectate{code_});
+}
+
+TEST_F(SpectatingShould, NotStartWhenLobbyRefuses) {
+  Prelobby prelobby;
+
+  EXPECT_CALL(manager_, spectate(_, code_)).WillOnce(Return(false));
+
+  prelobby(game_, sess_ctx_, jin::Spectate{code_});
+}
+
+TEST_F(SpectatingShould, UnspectateAndTransitionOnLeave) {
+  Spectating spectating(code_);
+
+  EXPECT_CALL(manager_, unspectate(_, code_));
+  EXPECT_CALL(game_, transition_to(VariantWith<Prelobby>(_)));
+
+  spectating(game_, sess_ctx_, jin::LobbyLeave{});
+}
+
+TEST_F(SpectatingShould, UnspectateOnClose) {
+  Spectating spectating(code_);
+
+  EXPECT_CALL(manager_, unspectate(_, code_));
+
+  spectating(game_, sess_ctx_, SessionEvent::kCloseSession);
+}
+
+TEST_F(SpectatingShould, TransitionWhenLobbyClosed) {
+  Spectating spectating(code_);
+
+  EXPECT_CALL(game_, transition_to(VariantWith<Prelobby>(_)));
+
+  spectating(game_, sess_ctx_, SessionEvent::kLobbyClosed);
+}
+
+}  // namespace io_blair::testing
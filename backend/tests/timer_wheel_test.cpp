@@ -0,0 +1,87 @@
+#include "timer_wheel.hpp"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <vector>
+
+
+namespace io_blair::testing {
+using std::chrono::seconds;
+using time_point = TimerWheel<int>::time_point;
+
+class TimerWheelShould : public ::testing::Test {
+ protected:
+  // Advances to now and gets what fired.
+  std::vector<int> advance(seconds now) {
+    std::vector<int> fired;
+    wheel_.advance(kStart + now, [&](int&& value) { fired.push_back(value); });
+    return fired;
+  }
+
+  static constexpr time_point kStart{};
+
+  TimerWheel<int> wheel_{seconds(1), kStart};
+};
+
+TEST_F(TimerWheelShould, FireAtDeadline) {
+  wheel_.schedule(kStart + seconds(5), 1);
+
+  EXPECT_TRUE(advance(seconds(4)).empty());
+  EXPECT_EQ(advance(seconds(5)), std::vector<int>{1});
+  EXPECT_EQ(wheel_.size(), 0);
+}
+
+TEST_F(TimerWheelShould, RoundDeadlinesUp) {
+  wheel_.schedule(kStart + std::chrono::milliseconds(1500), 1);
+
+  EXPECT_TRUE(advance(seconds(1)).empty());
+  EXPECT_EQ(advance(seconds(2)), std::vector<int>{1});
+}
+
+TEST_F(TimerWheelShould, FirePastDeadlinesOnNextTick) {
+  advance(seconds(10));
+  wheel_.schedule(kStart + seconds(3), 1);
+
+  EXPECT_EQ(advance(seconds(11)), std::vector<int>{1});
+}
+
+TEST_F(TimerWheelShould, FireTimersOnEveryLevel) {
+  // Either side of each level's boundary, in order.
+  const std::vector<seconds> deadlines = {seconds(63),      seconds(64),      seconds(4095),
+                                          seconds(4096),    seconds(262'143), seconds(262'144),
+                                          seconds(300'000), seconds(16'777'215)};
+  for (int i = 0; i < static_cast<int>(deadlines.size()); ++i) {
+    wheel_.schedule(kStart + deadlines[i], i);
+  }
+
+  for (int i = 0; i < static_cast<int>(deadlines.size()); ++i) {
+    EXPECT_TRUE(advance(deadlines[i] - seconds(1)).empty()) << i;
+    EXPECT_EQ(advance(deadlines[i]), std::vector<int>{i}) << i;
+  }
+  EXPECT_EQ(wheel_.size(), 0);
+}
+
+TEST_F(TimerWheelShould, HoldTimersBeyondItsSpan) {
+  const seconds far(16'777'216 + 100);
+  wheel_.schedule(kStart + far, 1);
+
+  EXPECT_TRUE(advance(far - seconds(1)).empty());
+  EXPECT_EQ(advance(far), std::vector<int>{1});
+}
+
+TEST_F(TimerWheelShould, AllowSchedulingWhileFiring) {
+  wheel_.schedule(kStart + seconds(1), 1);
+
+  std::vector<int> fired;
+  wheel_.advance(kStart + seconds(100), [&](int&& value) {
+    fired.push_back(value);
+    if (value < 3) {
+      wheel_.schedule(kStart + seconds(value * 50), value + 1);
+    }
+  });
+
+  EXPECT_EQ(fired, (std::vector<int>{1, 2, 3}));
+}
+
+}  // namespace io_blair::testing
@@ -0,0 +1,72 @@
+#include "trace.hpp"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+
+namespace io_blair::testing {
+using std::string;
+using ::testing::HasSubstr;
+
+class TracerShould : public ::testing::Test {
+ protected:
+  ~TracerShould() override {
+    trace::Tracer::instance().set_sample_every(0);
+  }
+};
+
+TEST_F(TracerShould, NotSampleWhenDisabled) {
+  trace::Tracer::instance().set_sample_every(0);
+
+  EXPECT_FALSE(trace::Tracer::instance().sample());
+}
+
+TEST_F(TracerShould, SampleEveryMessageWhenRateIsOne) {
+  trace::Tracer::instance().set_sample_every(1);
+
+  auto s1 = trace::Tracer::instance().sample();
+  auto s2 = trace::Tracer::instance().sample();
+
+  EXPECT_TRUE(s1);
+  EXPECT_TRUE(s2);
+  EXPECT_NE(s1.id, s2.id);
+}
+
+TEST_F(TracerShould, PropagateStampThroughScope) {
+  trace::Stamp stamp{.id = 42, .start_ns = 0};
+
+  EXPECT_FALSE(trace::current());
+  {
+    trace::Scope scope(stamp);
+    EXPECT_EQ(trace::current().id, stamp.id);
+  }
+  EXPECT_FALSE(trace::current());
+}
+
+TEST_F(TracerShould, DumpSpansInChromeTraceFormat) {
+  trace::Tracer::instance().set_sample_every(1);
+  const auto stamp = trace::Tracer::instance().sample();
+  {
+    trace::Scope scope(stamp);
+    trace::Span span("test_span");
+  }
+
+  const auto path = (std::filesystem::temp_directory_path() / "io_blair_trace_test.json").string();
+  ASSERT_TRUE(trace::Tracer::instance().dump(path));
+
+  std::ifstream in(path);
+  std::stringstream contents;
+  contents << in.rdbuf();
+  std::filesystem::remove(path);
+
+  EXPECT_THAT(contents.str(), HasSubstr("\"traceEvents\""));
+  EXPECT_THAT(contents.str(), HasSubstr("\"name\":\"test_span\""));
+  EXPECT_THAT(contents.str(), HasSubstr("\"trace\":" + std::to_string(stamp.id)));
+}
+
+}  // namespace io_blair::testing